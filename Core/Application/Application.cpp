@@ -269,10 +269,12 @@ namespace Omnia
 
 		GUI::CloseUIContext();
 		//Clouds::DestroyClouds();
-		glfwDestroyWindow(m_Window);
 
+		// The world and the renderers delete their opengl objects, the context has to be alive
 		delete m_Renderer2D;
 		delete m_World;
+
+		glfwDestroyWindow(m_Window);
 	}
 
 	void Application::OnUpdate()
@@ -420,6 +422,13 @@ namespace Omnia
 					ss << "Chunk Amount: " << m_World->m_ChunkCount << "\n";
 					ss << "Loaded Chunks: " << m_World->p_ChunksRendered << "\n";
 					ss << "Sun Position: " << m_World->GetSunPositionY() << "\n";
+
+					if (m_World->GetChunkSaver().GetPendingCount() > 0)
+					{
+						ChunkSaveProgress save_progress = m_World->GetChunkSaver().GetProgress();
+						ss << "Saving Chunks: " << save_progress.p_Written << "  /  " << save_progress.p_Queued << "\n";
+					}
+
 					ss << "Total CPU Used: " << m_ProcDebugInfo.cpu_usage << "\n";
 					ss << "Total Memory: " << m_ProcDebugInfo.total_mem << "  /  " << m_ProcDebugInfo.total_mem_used << "\n";
 					ss << "Total Virtual Memory: " << m_ProcDebugInfo.total_vm << "  /  " << m_ProcDebugInfo.total_vm_used << "\n";
@@ -601,6 +610,8 @@ namespace Omnia
 					{
 						if (ImGui::Button(Saves.at(i).c_str(), ImVec2(1000, 75)))
 						{
+							// Only one world at a time, they share the chunk mesh arenas (see ChunkMeshArena.h)
+							delete m_World;
 							m_World = WorldFileHandler::LoadWorld(Saves.at(i));
 							m_GameState = GameState::PlayingState;
 							EventSystem::Event e;
@@ -645,6 +656,7 @@ namespace Omnia
 					bool isValid = FilenameIsValid(input);
 					if (isValid)
 					{
+						delete m_World;
 						m_World = new World(seed, glm::vec2(w, h), input, static_cast<WorldGenerationType>(world_type));
 						m_GameState = GameState::PlayingState;
 						memset(input, '\0', 64);
@@ -96,7 +96,7 @@ namespace Omnia
 			return false;
 		}
 
-		bool CastsShadow()
+		bool CastsShadow() const
 		{
 			if (p_BlockType != BlockType::Air && p_BlockType != BlockType::GlassWhite && !IsModel())
 			{
@@ -197,7 +197,8 @@ namespace Omnia
 				return BlockDatabase[BlockTypeTexture::UnknownBlockType];
 			}
 
-			return BlockDatabase[tex];
+			// Don't use operator[] here, this is called from the mesher threads and must not modify the map
+			return iter->second;
 		}
 
 		const std::string& GetBlockName(BlockType block_type)
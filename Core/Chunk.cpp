@@ -3,15 +3,24 @@
 namespace Omnia
 {
 	Chunk::Chunk(const glm::vec3 chunk_position) : p_Position(chunk_position), 
-		p_MeshState(ChunkMeshState::Unbuilt), p_ChunkState(ChunkState::Ungenerated), p_LightMapState(ChunkLightMapState::UnmodifiedLightMap)
+		p_ChunkState(ChunkState::Ungenerated), p_LightMapState(ChunkLightMapState::UnmodifiedLightMap)
 		, p_ChunkFrustumAABB(glm::vec3(CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SIZE_Z), glm::vec3(chunk_position.x * CHUNK_SIZE_X, chunk_position.y * CHUNK_SIZE_Y, chunk_position.z * CHUNK_SIZE_Z))
 	{
-		// Initialize all the blocks in the chunk to be air blocks
+		// The sections start out uniform, all air and no light. Nothing casts a shadow yet so every block sees the sky
 
-		memset(&p_ChunkContents, BlockType::Air, CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z);
-		memset(&p_ChunkLightInformation, 0, (CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z * sizeof(std::uint8_t)));
 		memset(&p_HeightMap, 0, CHUNK_SIZE_X * CHUNK_SIZE_Z * sizeof(std::uint8_t));
 		memset(&p_BiomeMap, 0, CHUNK_SIZE_X * CHUNK_SIZE_Z * sizeof(std::uint8_t));
+		memset(&m_ShadowCasterHeights, 0, CHUNK_SIZE_X * CHUNK_SIZE_Z * sizeof(std::uint8_t));
+
+		for (int i = 0; i < CHUNK_SECTION_COUNT; i++)
+		{
+			int base_y = i * CHUNK_SECTION_SIZE_Y;
+			int height = std::min(CHUNK_SECTION_SIZE_Y, CHUNK_SIZE_Y - base_y);
+
+			p_Sections[i].p_SkyLight.Fill(MAX_SKY_LIGHT_LEVEL);
+			p_Sections[i].p_FrustumAABB = FrustumAABB(glm::vec3(CHUNK_SIZE_X, height, CHUNK_SIZE_Z), 
+				glm::vec3(chunk_position.x * CHUNK_SIZE_X, base_y, chunk_position.z * CHUNK_SIZE_Z));
+		}
 	}
 
 	Chunk::~Chunk()
@@ -19,45 +28,354 @@ namespace Omnia
 		
 	}
 
+	void Chunk::SetBlock(int x, int y, int z, BlockType type)
+	{
+		p_Sections[y / CHUNK_SECTION_SIZE_Y].p_Blocks.Set(x, y % CHUNK_SECTION_SIZE_Y, z, type);
+
+		const Block block = { type };
+		std::uint8_t& caster_height = m_ShadowCasterHeights[x][z];
+
+		if (block.CastsShadow())
+		{
+			caster_height = std::max<std::uint8_t>(caster_height, static_cast<std::uint8_t>(y + 1));
+		}
+
+		// The highest caster was removed, the next one is somewhere below it
+		else if (y + 1 == caster_height)
+		{
+			caster_height = 0;
+
+			for (int i = y - 1; i >= 0; i--)
+			{
+				if (GetBlock(x, i, z).CastsShadow())
+				{
+					caster_height = static_cast<std::uint8_t>(i + 1);
+					break;
+				}
+			}
+		}
+	}
+
 	void Chunk::SetBlock(BlockType type, const glm::vec3& position)
 	{
-		Block b;
-		b.p_BlockType = type;
+		SetBlock(static_cast<int>(position.x), static_cast<int>(position.y), static_cast<int>(position.z), type);
+	}
+
+	void Chunk::GetBlockRow(int x, int y, Block* out) const
+	{
+		p_Sections[y / CHUNK_SECTION_SIZE_Y].p_Blocks.GetRow(x, y % CHUNK_SECTION_SIZE_Y, out);
+	}
+
+	void Chunk::GetBlocks(Block* blocks) const
+	{
+		for (int x = 0; x < CHUNK_SIZE_X; x++)
+		{
+			for (int y = 0; y < CHUNK_SIZE_Y; y++)
+			{
+				GetBlockRow(x, y, &blocks[(x * CHUNK_SIZE_Y + y) * CHUNK_SIZE_Z]);
+			}
+		}
+	}
+
+	void Chunk::SetBlocks(const Block* blocks)
+	{
+		Block section_blocks[PaletteBlockStorage::VOLUME];
+
+		// Encode() leaves the sections made of one type uniform
+
+		for (int i = 0; i < CHUNK_SECTION_COUNT; i++)
+		{
+			const int base_y = i * CHUNK_SECTION_SIZE_Y;
+			const int height = std::min(CHUNK_SECTION_SIZE_Y, CHUNK_SIZE_Y - base_y);
+
+			// The rows above the top of the world stay air
+			std::fill_n(section_blocks, PaletteBlockStorage::VOLUME, Block{ BlockType::Air });
+
+			for (int x = 0; x < CHUNK_SIZE_X; x++)
+			{
+				memcpy(&section_blocks[x * CHUNK_SECTION_SIZE_Y * CHUNK_SIZE_Z], &blocks[(x * CHUNK_SIZE_Y + base_y) * CHUNK_SIZE_Z],
+					height * CHUNK_SIZE_Z * sizeof(Block));
+			}
+
+			p_Sections[i].p_Blocks.Encode(section_blocks);
+		}
+
+		UpdateShadowCasterHeights();
+		UpdateSkyLight();
+	}
+
+	void Chunk::GetLightMap(std::uint8_t* light) const
+	{
+		for (int x = 0; x < CHUNK_SIZE_X; x++)
+		{
+			for (int y = 0; y < CHUNK_SIZE_Y; y++)
+			{
+				GetLightRow(x, y, &light[(x * CHUNK_SIZE_Y + y) * CHUNK_SIZE_Z]);
+			}
+		}
+	}
+
+	void Chunk::SetLightMap(const std::uint8_t* light)
+	{
+		std::uint8_t section_light[SectionLightMap::VOLUME];
 
-		p_ChunkContents.at(position.x).at(position.y).at(position.z) = b;
+		for (int i = 0; i < CHUNK_SECTION_COUNT; i++)
+		{
+			const int base_y = i * CHUNK_SECTION_SIZE_Y;
+			const int height = std::min(CHUNK_SECTION_SIZE_Y, CHUNK_SIZE_Y - base_y);
+
+			// The rows above the top of the world repeat the last row so they don't keep the section from being uniform
+			for (int x = 0; x < CHUNK_SIZE_X; x++)
+			{
+				for (int y = 0; y < CHUNK_SECTION_SIZE_Y; y++)
+				{
+					const int source_y = base_y + std::min(y, height - 1);
+
+					memcpy(&section_light[(x * CHUNK_SECTION_SIZE_Y + y) * CHUNK_SIZE_Z], &light[(x * CHUNK_SIZE_Y + source_y) * CHUNK_SIZE_Z],
+						CHUNK_SIZE_Z * sizeof(std::uint8_t));
+				}
+			}
+
+			p_Sections[i].p_Light.Encode(section_light);
+		}
 	}
 
-	int Chunk::GetTorchLightAt(int x, int y, int z)
+	size_t Chunk::GetSectionMemoryUsage() const
 	{
-		return p_ChunkLightInformation[x][y][z];
+		size_t usage = 0;
+
+		for (const ChunkSection& section : p_Sections)
+		{
+			usage += section.p_Blocks.GetMemoryUsage() + section.p_Light.GetMemoryUsage() + section.p_SkyLight.GetMemoryUsage();
+		}
+
+		return usage;
 	}
 
 	void Chunk::SetTorchLightAt(int x, int y, int z, int light_val)
 	{
-		p_ChunkLightInformation[x][y][z] = light_val;
+		p_Sections[y / CHUNK_SECTION_SIZE_Y].p_Light.Set(x, y % CHUNK_SECTION_SIZE_Y, z, static_cast<std::uint8_t>(light_val));
 		p_LightMapState = ChunkLightMapState::ModifiedLightMap;
 	}
 
-	void Chunk::Construct()
+	void Chunk::GetLightRow(int x, int y, std::uint8_t* out) const
+	{
+		p_Sections[y / CHUNK_SECTION_SIZE_Y].p_Light.GetRow(x, y % CHUNK_SECTION_SIZE_Y, out);
+	}
+
+	void Chunk::SetSkyLightAt(int x, int y, int z, int light_val)
+	{
+		p_Sections[y / CHUNK_SECTION_SIZE_Y].p_SkyLight.Set(x, y % CHUNK_SECTION_SIZE_Y, z, static_cast<std::uint8_t>(light_val));
+	}
+
+	void Chunk::GetSkyLightRow(int x, int y, std::uint8_t* out) const
+	{
+		p_Sections[y / CHUNK_SECTION_SIZE_Y].p_SkyLight.GetRow(x, y % CHUNK_SECTION_SIZE_Y, out);
+	}
+
+	void Chunk::UpdateShadowCasterHeights()
+	{
+		memset(&m_ShadowCasterHeights, 0, CHUNK_SIZE_X * CHUNK_SIZE_Z * sizeof(std::uint8_t));
+
+		// The sections are walked down from the top until every column has found its caster. Uniform sections are settled at once
+		int columns_left = CHUNK_SIZE_X * CHUNK_SIZE_Z;
+		Block row[CHUNK_SIZE_Z];
+
+		for (int i = CHUNK_SECTION_COUNT - 1; i >= 0 && columns_left > 0; i--)
+		{
+			const PaletteBlockStorage& blocks = p_Sections[i].p_Blocks;
+			const int base_y = i * CHUNK_SECTION_SIZE_Y;
+			const int height = std::min(CHUNK_SECTION_SIZE_Y, CHUNK_SIZE_Y - base_y);
+
+			if (blocks.IsUniform())
+			{
+				const Block block = { blocks.GetUniformType() };
+
+				if (!block.CastsShadow())
+				{
+					continue;
+				}
+
+				for (int x = 0; x < CHUNK_SIZE_X; x++)
+				{
+					for (int z = 0; z < CHUNK_SIZE_Z; z++)
+					{
+						if (m_ShadowCasterHeights[x][z] == 0)
+						{
+							m_ShadowCasterHeights[x][z] = static_cast<std::uint8_t>(base_y + height);
+							columns_left--;
+						}
+					}
+				}
+
+				continue;
+			}
+
+			for (int y = base_y + height - 1; y >= base_y; y--)
+			{
+				for (int x = 0; x < CHUNK_SIZE_X; x++)
+				{
+					blocks.GetRow(x, y - base_y, row);
+
+					for (int z = 0; z < CHUNK_SIZE_Z; z++)
+					{
+						if (m_ShadowCasterHeights[x][z] == 0 && row[z].CastsShadow())
+						{
+							m_ShadowCasterHeights[x][z] = static_cast<std::uint8_t>(y + 1);
+							columns_left--;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void Chunk::UpdateSkyLight()
+	{
+		static constexpr int CHUNK_VOLUME = CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z;
+
+		auto get_index = [](int x, int y, int z) { return (x * CHUNK_SIZE_Y + y) * CHUNK_SIZE_Z + z; };
+
+		// Reused by every chunk generated on the thread
+		static thread_local std::vector<std::uint8_t> sky(CHUNK_VOLUME);
+		static thread_local std::vector<std::uint32_t> queue;
+		int highest_caster = 0;
+
+		queue.clear();
+
+		// The blocks from the caster height up see the sky
+		for (int x = 0; x < CHUNK_SIZE_X; x++)
+		{
+			for (int y = 0; y < CHUNK_SIZE_Y; y++)
+			{
+				std::uint8_t* row = &sky[get_index(x, y, 0)];
+
+				for (int z = 0; z < CHUNK_SIZE_Z; z++)
+				{
+					row[z] = y >= m_ShadowCasterHeights[x][z] ? MAX_SKY_LIGHT_LEVEL : 0;
+				}
+			}
+
+			for (int z = 0; z < CHUNK_SIZE_Z; z++)
+			{
+				highest_caster = std::max<int>(highest_caster, m_ShadowCasterHeights[x][z]);
+			}
+		}
+
+		// The light spreads sideways from the blocks next to a higher column, those are the only lit blocks that touch a dark one
+		for (int x = 0; x < CHUNK_SIZE_X; x++)
+		{
+			for (int z = 0; z < CHUNK_SIZE_Z; z++)
+			{
+				int highest_neighbour = m_ShadowCasterHeights[x][z];
+
+				if (x > 0) highest_neighbour = std::max<int>(highest_neighbour, m_ShadowCasterHeights[x - 1][z]);
+				if (x < CHUNK_SIZE_X - 1) highest_neighbour = std::max<int>(highest_neighbour, m_ShadowCasterHeights[x + 1][z]);
+				if (z > 0) highest_neighbour = std::max<int>(highest_neighbour, m_ShadowCasterHeights[x][z - 1]);
+				if (z < CHUNK_SIZE_Z - 1) highest_neighbour = std::max<int>(highest_neighbour, m_ShadowCasterHeights[x][z + 1]);
+
+				for (int y = m_ShadowCasterHeights[x][z]; y < highest_neighbour; y++)
+				{
+					queue.push_back(static_cast<std::uint32_t>(get_index(x, y, z)));
+				}
+			}
+		}
+
+		static const glm::ivec3 Directions[6] = { glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0), glm::ivec3(0, 1, 0),
+			glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1) };
+
+		for (size_t i = 0; i < queue.size(); i++)
+		{
+			const std::uint32_t index = queue[i];
+			const int light_level = sky[index];
+
+			const int x = index / (CHUNK_SIZE_Y * CHUNK_SIZE_Z);
+			const int y = (index / CHUNK_SIZE_Z) % CHUNK_SIZE_Y;
+			const int z = index % CHUNK_SIZE_Z;
+
+			for (const glm::ivec3& direction : Directions)
+			{
+				const glm::ivec3 neighbour = glm::ivec3(x, y, z) + direction;
+
+				if (neighbour.x < 0 || neighbour.x >= CHUNK_SIZE_X || neighbour.y < 0 || neighbour.y >= CHUNK_SIZE_Y ||
+					neighbour.z < 0 || neighbour.z >= CHUNK_SIZE_Z)
+				{
+					continue;
+				}
+
+				const int neighbour_index = get_index(neighbour.x, neighbour.y, neighbour.z);
+
+				if (sky[neighbour_index] + 2 <= light_level && !GetBlock(neighbour.x, neighbour.y, neighbour.z).CastsShadow())
+				{
+					sky[neighbour_index] = static_cast<std::uint8_t>(light_level - 1);
+					queue.push_back(static_cast<std::uint32_t>(neighbour_index));
+				}
+			}
+		}
+
+		// Write the sections, the ones above every caster are all sky
+		std::uint8_t section_sky[SectionLightMap::VOLUME];
+
+		for (int i = 0; i < CHUNK_SECTION_COUNT; i++)
+		{
+			SectionLightMap& section_light = p_Sections[i].p_SkyLight;
+			const int base_y = i * CHUNK_SECTION_SIZE_Y;
+			const int height = std::min(CHUNK_SECTION_SIZE_Y, CHUNK_SIZE_Y - base_y);
+
+			if (base_y >= highest_caster)
+			{
+				section_light.Fill(MAX_SKY_LIGHT_LEVEL);
+				continue;
+			}
+
+			// The rows above the top of the world repeat the last row like in SetLightMap()
+			for (int x = 0; x < CHUNK_SIZE_X; x++)
+			{
+				for (int y = 0; y < CHUNK_SECTION_SIZE_Y; y++)
+				{
+					memcpy(&section_sky[(x * CHUNK_SECTION_SIZE_Y + y) * CHUNK_SIZE_Z], &sky[get_index(x, base_y + std::min(y, height - 1), 0)],
+						CHUNK_SIZE_Z * sizeof(std::uint8_t));
+				}
+			}
+
+			section_light.Encode(section_sky);
+		}
+	}
+
+	void Chunk::SetMeshDirty()
 	{
-		if (m_ChunkMesh.ConstructMesh(this, p_Position))
+		for (ChunkSection& section : p_Sections)
 		{
-			p_MeshState = ChunkMeshState::Built;
+			section.p_MeshState = ChunkMeshState::Unbuilt;
 		}
+	}
+
+	void Chunk::SetMeshDirty(int min_y, int max_y)
+	{
+		int first = std::max(min_y - 1, 0) / CHUNK_SECTION_SIZE_Y;
+		int last = std::min(max_y + 1, CHUNK_SIZE_Y - 1) / CHUNK_SECTION_SIZE_Y;
 
-		else
+		for (int i = first; i <= last; i++)
 		{
-			p_MeshState = ChunkMeshState::Unbuilt;
+			p_Sections[i].p_MeshState = ChunkMeshState::Unbuilt;
 		}
 	}
 
-	ChunkMesh* Chunk::GetChunkMesh()
+	bool Chunk::IsSectionEmpty(int section) const
 	{
-		return &m_ChunkMesh;
+		return p_Sections[section].p_Blocks.IsFilledWith(BlockType::Air);
 	}
 
-	Block* Chunk::GetBlock(int x, int y, int z)
+	bool Chunk::IsSectionUniform(int section, BlockType& type) const
 	{
-		return &p_ChunkContents[x][y][z];
+		const PaletteBlockStorage& blocks = p_Sections[section].p_Blocks;
+
+		if (blocks.IsUniform())
+		{
+			type = blocks.GetUniformType();
+			return true;
+		}
+
+		return false;
 	}
 }
\ No newline at end of file
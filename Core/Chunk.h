@@ -12,7 +12,9 @@
 
 #include "Maths/Frustum.h"
 #include "ChunkMesh.h"
+#include "PaletteBlockStorage.h"
 #include "Lighting/Lighting.h"
+#include "Lighting/SectionLightMap.h"
 #include "World/Biome.h"
 
 namespace Omnia
@@ -21,6 +23,7 @@ namespace Omnia
 	{
 		Built = 0,
 		Unbuilt,
+		Meshing, // Queued on the chunk mesher, the old mesh is still drawn until the new one is uploaded
 		error
 	};
 
@@ -38,6 +41,22 @@ namespace Omnia
 		undefined
 	};
 
+	/*
+	A 16 block high part of a chunk. Every section is meshed, culled and drawn on its own.
+	The blocks and the light of a section are stored once while they are uniform (air above the terrain, stone below it, no lamps)
+	and only allocated when a different value is written
+	*/
+	struct ChunkSection
+	{
+		PaletteBlockStorage p_Blocks;
+		SectionLightMap p_Light;
+		SectionLightMap p_SkyLight; // Computed from the blocks (see Chunk::UpdateSkyLight()), it isn't saved
+		ChunkMesh p_Mesh;
+		ChunkMeshState p_MeshState = ChunkMeshState::Unbuilt;
+		uint32_t p_MeshVersion = 0; // Bumped every time the section is queued for meshing. Used to throw away stale meshes
+		FrustumAABB p_FrustumAABB;
+	};
+
 	class Chunk
 	{
 	public : 
@@ -45,21 +64,98 @@ namespace Omnia
 		Chunk(const glm::vec3 chunk_position);
 		~Chunk();
 
+		inline Block GetBlock(int x, int y, int z) const noexcept
+		{
+			return { p_Sections[y / CHUNK_SECTION_SIZE_Y].p_Blocks.Get(x, y % CHUNK_SECTION_SIZE_Y, z) };
+		}
+
+		void SetBlock(int x, int y, int z, BlockType type);
 		void SetBlock(BlockType type, const glm::vec3& position);
 
-		int GetTorchLightAt(int x, int y, int z);
+		// Writes the CHUNK_SIZE_Z blocks of the row at (x, y) to out. Used by the mesher to copy whole rows at once
+		void GetBlockRow(int x, int y, Block* out) const;
+
+		// Converts the blocks and the light from and to plain arrays of CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z values in x, y, z order (z innermost)
+		void GetBlocks(Block* blocks) const;
+		void SetBlocks(const Block* blocks);
+		void GetLightMap(std::uint8_t* light) const;
+		void SetLightMap(const std::uint8_t* light);
+
+		// The memory allocated for the blocks and light of the sections, in bytes
+		size_t GetSectionMemoryUsage() const;
+
+		inline int GetTorchLightAt(int x, int y, int z) const noexcept
+		{
+			return p_Sections[y / CHUNK_SECTION_SIZE_Y].p_Light.Get(x, y % CHUNK_SECTION_SIZE_Y, z);
+		}
+
 		void SetTorchLightAt(int x, int y, int z, int light_val);
 
-		void Construct();
-		ChunkMesh* GetChunkMesh();
+		// Writes the CHUNK_SIZE_Z light values of the row at (x, y) to out
+		void GetLightRow(int x, int y, std::uint8_t* out) const;
+
+		inline int GetSkyLightAt(int x, int y, int z) const noexcept
+		{
+			return p_Sections[y / CHUNK_SECTION_SIZE_Y].p_SkyLight.Get(x, y % CHUNK_SECTION_SIZE_Y, z);
+		}
+
+		// The sky light isn't saved so this doesn't mark the light map as modified
+		void SetSkyLightAt(int x, int y, int z, int light_val);
+
+		void GetSkyLightRow(int x, int y, std::uint8_t* out) const;
+
+		// The y above the highest block of a column that casts a shadow (see Block::CastsShadow()), 0 if there is none.
+		// Every block from there up sees the sky. SetBlock() keeps it up to date
+		inline int GetShadowCasterHeight(int x, int z) const noexcept { return m_ShadowCasterHeights[x][z]; }
+
+		// Finds the shadow caster heights again, for when the blocks were written without SetBlock() (the generator writes whole sections)
+		void UpdateShadowCasterHeights();
 
-		Block* GetBlock(int x, int y, int z);
+		/*
+		Computes the whole sky light of the chunk again from the shadow caster heights. The blocks from the caster height up get MAX_SKY_LIGHT_LEVEL,
+		the light spreads from there through the blocks that don't cast shadows (under overhangs, in to caves) and drops by one per block.
+		It only spreads inside of the chunk, the world evens it out across the borders when the chunk is added and updates it on edits (see World::PropogateSkyLight())
+		*/
+		void UpdateSkyLight();
+
+		// Marks every section for remeshing
+		void SetMeshDirty();
+
+		// Marks the sections that can see a change between min_y and max_y for remeshing. 
+		// The sections of the blocks right above and below the range are included since their faces use the blocks and light in it
+		void SetMeshDirty(int min_y, int max_y);
+
+		// Returns true if every block of the section is air
+		bool IsSectionEmpty(int section) const;
+
+		// Returns true if the section is made of a single block type. type is set to that type
+		bool IsSectionUniform(int section, BlockType& type) const;
+
+		// Returns true if torch light can't get in to any block of the section of y : the whole section is one block type that stops it (stone under the terrain).
+		// The light bfs checks this before reading the block of a neighbour in another section
+		inline bool IsSectionLightProof(int y) const noexcept
+		{
+			const PaletteBlockStorage& blocks = p_Sections[y / CHUNK_SECTION_SIZE_Y].p_Blocks;
+			return blocks.IsUniform() && !Block{ blocks.GetUniformType() }.IsLightPropogatable();
+		}
+
+		// Returns true if the section of y has no torch light at all, the light removal bfs has nothing to remove there
+		inline bool IsSectionUnlit(int y) const noexcept
+		{
+			const SectionLightMap& light = p_Sections[y / CHUNK_SECTION_SIZE_Y].p_Light;
+			return light.IsUniform() && light.GetUniformValue() == 0;
+		}
+
+		// Returns true if a mesher job still holds a pointer to the chunk. The chunk can't be unloaded until every job is uploaded or thrown away.
+		// The mesh states can't tell : SetMeshDirty() sets a section that is being meshed back to Unbuilt while its job keeps running
+		inline bool IsMeshing() const noexcept { return p_MeshJobsInFlight > 0; }
 
 		const glm::vec3 p_Position;
-		ChunkMeshState p_MeshState;
 		ChunkState p_ChunkState = ChunkState::Ungenerated;
-		std::array<std::array<std::array<Block, CHUNK_SIZE_X>, CHUNK_SIZE_Y>, CHUNK_SIZE_Z> p_ChunkContents;
-		std::array<std::array<std::array<uint8_t, CHUNK_SIZE_X>, CHUNK_SIZE_Y>, CHUNK_SIZE_Z> p_ChunkLightInformation;
+
+		// Set when the saved changes of the chunk couldn't be applied to the terrain (see ChunkFileHandler::ChunkSaveMode::Delta).
+		// The chunk shows the generated terrain, it can't be edited and it is never saved so the saved changes are kept
+		bool p_ReadOnly = false;
 		ChunkLightMapState p_LightMapState;
 		FrustumAABB p_ChunkFrustumAABB;
 
@@ -67,7 +163,16 @@ namespace Omnia
 		std::array<std::array<uint8_t, CHUNK_SIZE_X>, CHUNK_SIZE_Z> p_HeightMap;
 		std::array<std::array<Biome, CHUNK_SIZE_X>, CHUNK_SIZE_Z> p_BiomeMap;
 
+		std::array<ChunkSection, CHUNK_SECTION_COUNT> p_Sections;
+
+		// The last frame the chunk was within the residency distance of the player. Used to unload the least recently used chunks first
+		long long p_LastUsedFrame = 0;
+
+		// The mesher jobs of the sections that haven't reached the main thread yet (see ChunkMesher). Only touched by the main thread
+		uint32_t p_MeshJobsInFlight = 0;
+
 	private :
-		ChunkMesh m_ChunkMesh;
+
+		std::array<std::array<uint8_t, CHUNK_SIZE_Z>, CHUNK_SIZE_X> m_ShadowCasterHeights;
 	};
 }
\ No newline at end of file
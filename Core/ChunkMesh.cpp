@@ -1,12 +1,24 @@
 #include "ChunkMesh.h"
+#include "ChunkMeshArena.h"
 #include "Chunk.h"
+#include "BlockDatabase.h"
+#include "Models/Model.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OMNIA_MESHER_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 
 /*
 		-- The Chunk Meshing Process --
 
 -- Normal blocks --
-This algorithm iterates throught every block in a chunk, 
+This algorithm iterates throught every block in a chunk section, 
 if the left block is an air block, it adds that faces to the mesh, same for the other surrounding blocks;
 
 -- Transparent blocks --
@@ -14,495 +26,507 @@ This mesher adds all transparent blocks of the same type together. eg : a group
 What we are left with is like a shell of that transparent block which is quite efficient.
 
 -- Meshes --
-There are 3 meshes per chunk that are all using std::vector as it is fast and efficient. The buffer is cleared after it is uploaded to the gpu.
+There are 3 meshes per chunk section that are all using std::vector as it is fast and efficient. The buffer is cleared after it is uploaded to the gpu.
 Meshes : 
 - Normal block mesh
 - Transparent block mesh
 - Model mesh 
 
 -- Shadows -- 
-A basic algorithm is used to calculate shadows. It checks the highest block in a chunk and sets the shadow level if it is a particular range
+A top face is in shadow when there is a shadow casting block anywhere above it, which is when its sky light is below MAX_SKY_LIGHT_LEVEL.
+The chunk keeps the height of the highest caster of every column up to date, so this is one lookup per face instead of a scan up the column
 
 -- Lighting -- 
 I retrieve the light value from the 3d light value array in a chunk and store it in each vertex
 
--- Info --
-When ever a chunk is updated. The entire mesh is regenerated instead of modifying the existing vertices..
-Index buffers are used to maximize performance
+-- Sections --
+Every chunk is split into 16 block high sections (see Chunk.h) and every section has its own ChunkMesh.
+Editing a block only rebuilds the sections that can see the change instead of the whole 16x255x16 column.
+
+-- Snapshot --
+The mesher never reads the world. CreateSnapshot() copies a section and a one block border of its neighbours into a padded array
+on the main thread, so the meshing loops don't need any edge cases or bounds checks and the worker threads get a stable input.
+
+-- Greedy meshing --
+BuildGreedyMesh() goes through every face direction one slice at a time. The visible faces of a slice are written to a 2D mask
+(block type, light level and face lighting) and neighbouring mask entries that are equal are merged into rectangles.
+A merged quad can't use the per corner atlas coordinates (the texture would be stretched) so every vertex of the quad carries
+the atlas origin of the texture, the fragment shader has to repeat the texture using the block position when u_GreedyMeshing is 1.
+The chunk shaders don't do that yet, so the per face mesher (ChunkMeshingMode::PerFace) is the one the game uses.
 
-The _GetchunkDataForMeshing() functions are forward declarations and are implemented in main.cpp 
+-- Vertex formats --
+The mesh is built either with the 12 byte Vertex or with the 8 byte PackedVertex (ChunkVertexFormat). 
+Both formats carry the same data, the packed one has to be unpacked in the vertex shader (the chunk shaders don't do it yet, the game uses Vertex).
+The format of every mesh is stored with it so the renderer picks the matching shader while the world is being remeshed after the format is switched.
+
+-- Threading --
+Meshing is split in two. BuildMesh() only fills the vertex arrays of a ChunkMeshData and runs on the mesher's worker threads (see ChunkMesher.h),
+UploadMesh() copies the finished arrays to the vbos and is called from the main thread. 
+
+-- Info --
+When a block changes only the dirty sections are meshed again (Chunk::SetMeshDirty()), each one is rebuilt from a fresh snapshot
+instead of modifying its existing vertices.
+The meshes don't own any opengl objects, the vertices are copied in to a range of one large vertex buffer per vertex format (ChunkMeshArena.h)
 */
 
 namespace Omnia
 {
-	ChunkMesh::ChunkMesh() : m_VBO(GL_ARRAY_BUFFER), m_TransparentVBO(GL_ARRAY_BUFFER), m_ModelVBO(GL_ARRAY_BUFFER)
+	// The 2D planes of every face of a block
+
+	static const glm::vec4 ForwardFace[4] =
 	{
-		static bool IndexBufferInitialized = false;
+		glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+		glm::vec4(1.0f, 0.0f, 1.0f, 1.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+		glm::vec4(0.0f, 1.0f, 1.0f, 1.0f)
+	};
 
-		// Static index buffer
-		static GLClasses::IndexBuffer StaticIBO;
+	static const glm::vec4 BackFace[4] =
+	{
+		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+		glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+		glm::vec4(1.0f, 1.0f, 0.0f, 1.0f),
+		glm::vec4(0.0f, 1.0f, 0.0f, 1.0f)
+	};
+
+	static const glm::vec4 TopFace[4] =
+	{
+		glm::vec4(0.0f, 1.0f, 0.0f, 1.0f),
+		glm::vec4(1.0f, 1.0f, 0.0f, 1.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+		glm::vec4(0.0f, 1.0f, 1.0f, 1.0f)
+	};
+
+	static const glm::vec4 BottomFace[4] =
+	{
+		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+		glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+		glm::vec4(1.0f, 0.0f, 1.0f, 1.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)
+	};
+
+	static const glm::vec4 LeftFace[4] =
+	{
+		glm::vec4(0.0f, 1.0f, 1.0f, 1.0f),
+		glm::vec4(0.0f, 1.0f, 0.0f, 1.0f),
+		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)
+	};
+
+	static const glm::vec4 RightFace[4] =
+	{
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+		glm::vec4(1.0f, 1.0f, 0.0f, 1.0f),
+		glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+		glm::vec4(1.0f, 0.0f, 1.0f, 1.0f)
+	};
+
+	// The face types and the direction of the neighbouring block each face looks at
+	static const BlockFaceType FaceTypes[6] = { BlockFaceType::top, BlockFaceType::bottom, BlockFaceType::front,
+		BlockFaceType::backward, BlockFaceType::right, BlockFaceType::left };
+
+	static const glm::ivec3 FaceNormals[6] = { glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1),
+		glm::ivec3(0, 0, -1), glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0) };
+
+	/*
+		-- Face culling --
+		Transparent blocks only show faces towards other transparent blocks of a different type (the shell of a group of water blocks for example)
+		Every other block shows a face towards any block that isn't opaque
+
+		Instead of testing every neighbour with IsOpaque() and IsTransparent(), every z row of the snapshot is turned into bitmasks 
+		(one bit per block) of its opaque, transparent, model and air blocks. The visible faces of a whole row are then found with shifts and ands,
+		the neighbours along z are the same masks shifted by one bit. The flags of the blocks are looked up in BlockFlagTable, the masks are built from them
+		and the block types of two rows are compared 16 blocks at a time with SSE2 (a compare and a movemask per mask).
+		Only the set bits of the resulting masks are turned into vertices.
+	*/
+
+	enum BlockFlags : uint8_t
+	{
+		BLOCK_FLAG_OPAQUE = 1,
+		BLOCK_FLAG_TRANSPARENT = 2,
+		BLOCK_FLAG_MODEL = 4,
+		BLOCK_FLAG_AIR = 8
+	};
 
-		if (IndexBufferInitialized == false)
+	static std::array<uint8_t, 256> CreateBlockFlagTable()
+	{
+		std::array<uint8_t, 256> table;
+
+		for (int i = 0; i < 256; i++)
 		{
-			IndexBufferInitialized = true;
+			Block block;
+			block.p_BlockType = static_cast<BlockType>(i);
+
+			uint8_t flags = 0;
+			flags |= block.IsOpaque() ? BLOCK_FLAG_OPAQUE : 0;
+			flags |= block.IsTransparent() ? BLOCK_FLAG_TRANSPARENT : 0;
+			flags |= block.IsModel() ? BLOCK_FLAG_MODEL : 0;
+			flags |= block.p_BlockType == BlockType::Air ? BLOCK_FLAG_AIR : 0;
+			table[i] = flags;
+		}
 
-			GLuint* IndexBuffer = nullptr;
+		return table;
+	}
 
-			int index_size = CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z * 6;
-			int index_offset = 0;
+	static const std::array<uint8_t, 256> BlockFlagTable = CreateBlockFlagTable();
 
-			IndexBuffer = new GLuint[index_size * 6];
+	// The masks of one padded z row of the snapshot. Bit 0 is z = -1 and bit 17 is z = CHUNK_SIZE_Z
+	struct SnapshotRowMasks
+	{
+		uint32_t p_Opaque = 0;
+		uint32_t p_Transparent = 0;
+		uint32_t p_Model = 0;
+		uint32_t p_Air = 0;
+	};
+
+	// The visible faces of a section, one mask per z row. Bit 0 is z = 0
+	struct SectionFaceMasks
+	{
+		uint16_t p_Visible[6][CHUNK_SIZE_X][CHUNK_SECTION_SIZE_Y];
+		uint16_t p_Models[CHUNK_SIZE_X][CHUNK_SECTION_SIZE_Y];
+	};
 
-			for (size_t i = 0; i < index_size; i += 6)
-			{
-				IndexBuffer[i] = 0 + index_offset;
-				IndexBuffer[i + 1] = 1 + index_offset;
-				IndexBuffer[i + 2] = 2 + index_offset;
-				IndexBuffer[i + 3] = 2 + index_offset;
-				IndexBuffer[i + 4] = 3 + index_offset;
-				IndexBuffer[i + 5] = 0 + index_offset;
-
-				index_offset = index_offset + 4;
-			}
+	static_assert(sizeof(Block) == 1, "The snapshot rows are compared as bytes");
+	static_assert(CHUNK_SIZE_Z == 16, "The face masks use one 16 bit mask per z row");
+
+	// Returns a mask with a bit set for every one of the 16 blocks that has the same type in both rows
+	static inline uint16_t CompareBlockRows(const Block* a, const Block* b)
+	{
+#if defined(OMNIA_MESHER_SSE2)
+		__m128i row_a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+		__m128i row_b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+		return static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(row_a, row_b)));
+#else
+		uint16_t mask = 0;
+
+		for (int i = 0; i < 16; i++)
+		{
+			mask |= (a[i].p_BlockType == b[i].p_BlockType) << i;
+		}
 
-			StaticIBO.BufferData(index_size * 6 * sizeof(GLuint), IndexBuffer, GL_STATIC_DRAW);
-
-			delete[] IndexBuffer;
-		}
-
-		p_VAO.Bind();
-		m_VBO.Bind();
-		StaticIBO.Bind();
-		m_VBO.VertexAttribIPointer(0, 3, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-		m_VBO.VertexAttribIPointer(1, 2, GL_UNSIGNED_SHORT, sizeof(Vertex), (void*)offsetof(Vertex, texture_coords));
-		m_VBO.VertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, lighting_level));
-		m_VBO.VertexAttribIPointer(3, 1, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, block_face_lighting));
-		p_VAO.Unbind();
-
-		p_TransparentVAO.Bind();
-		m_TransparentVBO.Bind();
-		StaticIBO.Bind();
-		m_TransparentVBO.VertexAttribIPointer(0, 3, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-		m_TransparentVBO.VertexAttribIPointer(1, 2, GL_UNSIGNED_SHORT, sizeof(Vertex), (void*)offsetof(Vertex, texture_coords));
-		m_TransparentVBO.VertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, lighting_level));
-		m_TransparentVBO.VertexAttribIPointer(3, 1, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, block_face_lighting));
-		p_TransparentVAO.Unbind();
-
-		p_ModelVAO.Bind();
-		m_ModelVBO.Bind();
-		StaticIBO.Bind();
-		m_ModelVBO.VertexAttribIPointer(0, 3, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-		m_ModelVBO.VertexAttribIPointer(1, 2, GL_UNSIGNED_SHORT, sizeof(Vertex), (void*)offsetof(Vertex, texture_coords));
-		m_ModelVBO.VertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, lighting_level));
-		m_ModelVBO.VertexAttribIPointer(3, 1, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, block_face_lighting));
-		p_ModelVAO.Unbind();
-
-		// Set the values of the 2D planes
-
-		m_ForwardFace[0] = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
-		m_ForwardFace[1] = glm::vec4(1.0f, 0.0f, 1.0f, 1.0f);
-		m_ForwardFace[2] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-		m_ForwardFace[3] = glm::vec4(0.0f, 1.0f, 1.0f, 1.0f);
-
-		m_BackFace[0] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-		m_BackFace[1] = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
-		m_BackFace[2] = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
-		m_BackFace[3] = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
-
-		m_TopFace[0] = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
-		m_TopFace[1] = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
-		m_TopFace[2] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-		m_TopFace[3] = glm::vec4(0.0f, 1.0f, 1.0f, 1.0f);
-
-		m_BottomFace[0] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-		m_BottomFace[1] = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
-		m_BottomFace[2] = glm::vec4(1.0f, 0.0f, 1.0f, 1.0f);
-		m_BottomFace[3] = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
-
-		m_LeftFace[0] = glm::vec4(0.0f, 1.0f, 1.0f, 1.0f);
-		m_LeftFace[1] = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
-		m_LeftFace[2] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-		m_LeftFace[3] = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
-
-		m_RightFace[0] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-		m_RightFace[1] = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
-		m_RightFace[2] = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
-		m_RightFace[3] = glm::vec4(1.0f, 0.0f, 1.0f, 1.0f);
+		return mask;
+#endif
 	}
 
-	ChunkMesh::~ChunkMesh()
+	// Returns a mask with bit i set for every block of a padded z row that has the flag, row_flags holds the BlockFlagTable entries of the row
+	static inline uint32_t GetRowFlagMask(const uint8_t* row_flags, uint8_t flag)
 	{
-		m_Vertices.clear();
+		uint32_t mask = 0;
+		int i = 0;
+
+#if defined(OMNIA_MESHER_SSE2)
+		const __m128i bit = _mm_set1_epi8(static_cast<char>(flag));
+		const __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_flags));
+		mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(flags, bit), bit)));
+		i = 16;
+#endif
+
+		for (; i < ChunkMeshSnapshot::PADDED_SIZE_Z; i++)
+		{
+			mask |= (row_flags[i] & flag ? 1u : 0u) << i;
+		}
+
+		return mask;
 	}
 
-	// Construct mesh using greedy meshing for maximum performance
-	bool ChunkMesh::ConstructMesh(Chunk* chunk, const glm::vec3& chunk_pos)
+	static inline int CountTrailingZeros(uint32_t value)
 	{
-		ChunkDataTypePtr ChunkData = &chunk->p_ChunkContents;
-		ChunkLightDataTypePtr ChunkLData = &chunk->p_ChunkLightInformation;
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return static_cast<int>(index);
+#else
+		return __builtin_ctz(value);
+#endif
+	}
 
-		glm::vec3 world_position;
-		glm::vec3 local_position;
-		m_Vertices.clear();
+	static void BuildFaceMasks(const ChunkMeshSnapshot& snapshot, SectionFaceMasks& masks)
+	{
+		SnapshotRowMasks rows[ChunkMeshSnapshot::PADDED_SIZE_X][ChunkMeshSnapshot::PADDED_SIZE_Y];
 
-		ChunkDataTypePtr ForwardChunkData = _GetChunkDataForMeshing(static_cast<int>(chunk_pos.x), static_cast<int>(chunk_pos.z + 1));
-		ChunkDataTypePtr BackwardChunkData = _GetChunkDataForMeshing(static_cast<int>(chunk_pos.x), static_cast<int>(chunk_pos.z - 1));
-		ChunkDataTypePtr RightChunkData = _GetChunkDataForMeshing(static_cast<int>(chunk_pos.x + 1), static_cast<int>(chunk_pos.z));
-		ChunkDataTypePtr LeftChunkData = _GetChunkDataForMeshing(static_cast<int>(chunk_pos.x - 1), static_cast<int>(chunk_pos.z));
-		ChunkLightDataTypePtr ForwardChunkLData = _GetChunkLightDataForMeshing(static_cast<int>(chunk_pos.x), static_cast<int>(chunk_pos.z + 1));
-		ChunkLightDataTypePtr BackwardChunkLData = _GetChunkLightDataForMeshing(static_cast<int>(chunk_pos.x), static_cast<int>(chunk_pos.z - 1));
-		ChunkLightDataTypePtr RightChunkLData = _GetChunkLightDataForMeshing(static_cast<int>(chunk_pos.x + 1), static_cast<int>(chunk_pos.z));
-		ChunkLightDataTypePtr LeftChunkLData = _GetChunkLightDataForMeshing(static_cast<int>(chunk_pos.x - 1), static_cast<int>(chunk_pos.z));
+		// The flags of the whole snapshot are looked up in one pass, then every row mask is built 16 blocks at a time
+		uint8_t flags[ChunkMeshSnapshot::PADDED_VOLUME];
 
-		if (ForwardChunkData && BackwardChunkData && RightChunkData && LeftChunkData)
+		for (int i = 0; i < ChunkMeshSnapshot::PADDED_VOLUME; i++)
 		{
-			for (int x = 0; x < CHUNK_SIZE_X; x++)
+			flags[i] = BlockFlagTable[snapshot.p_Blocks[i].p_BlockType];
+		}
+
+		for (int x = -1; x <= CHUNK_SIZE_X; x++)
+		{
+			for (int y = snapshot.p_BaseY - 1; y <= snapshot.p_BaseY + snapshot.p_Height; y++)
 			{
-				for (int y = 0; y < CHUNK_SIZE_Y; y++)
-				{
-					for (int z = 0; z < CHUNK_SIZE_Z; z++)
-					{
-						if (ChunkData->at(x).at(y).at(z).p_BlockType != BlockType::Air)
-						{
-							Block* block = &ChunkData->at(x).at(y).at(z);
+				SnapshotRowMasks& row = rows[x + 1][y - snapshot.p_BaseY + 1];
+				const uint8_t* row_flags = &flags[snapshot.GetIndex(x, y, -1)];
 
-							// To fix chunk edge mesh building issues, both faces are added if it is in the edge
+				row.p_Opaque = GetRowFlagMask(row_flags, BLOCK_FLAG_OPAQUE);
+				row.p_Transparent = GetRowFlagMask(row_flags, BLOCK_FLAG_TRANSPARENT);
+				row.p_Model = GetRowFlagMask(row_flags, BLOCK_FLAG_MODEL);
+				row.p_Air = GetRowFlagMask(row_flags, BLOCK_FLAG_AIR);
+			}
+		}
 
-							float light_level = ChunkLData->at(x).at(y).at(z);
+		// The 16 blocks of the section in a padded row
+		const uint32_t inner = 0x1FFFE;
 
-							if (y >= 0 && y < CHUNK_SIZE_Y - 1)
-							{
-								light_level = ChunkLData->at(x).at(y + 1).at(z);
-							}
+		for (int x = 0; x < CHUNK_SIZE_X; x++)
+		{
+			for (int y = snapshot.p_BaseY; y < snapshot.p_BaseY + snapshot.p_Height; y++)
+			{
+				const int ly = y - snapshot.p_BaseY;
+				const SnapshotRowMasks& row = rows[x + 1][ly + 1];
+				const Block* blocks = &snapshot.GetBlock(x, y, 0);
 
-							world_position.x = chunk_pos.x * CHUNK_SIZE_X + x;
-							world_position.y = 0 * CHUNK_SIZE_Y + y;
-							world_position.z = chunk_pos.z * CHUNK_SIZE_Z + z;
-							local_position = glm::vec3(x, y, z);
+				// Air and models are transparent, so everything else gets the normal faces
+				const uint32_t solid = ~row.p_Transparent & inner;
+				const uint32_t transparent = row.p_Transparent & ~row.p_Air & ~row.p_Model & inner;
 
-							if (block->IsModel())
-							{
-								AddModel(chunk, local_position, block->p_BlockType, light_level);
-								continue;
-							}
+				masks.p_Models[x][ly] = static_cast<uint16_t>((row.p_Model & inner) >> 1);
 
-							if (z <= 0)
-							{
-								if (block->IsTransparent())
-								{
-									if (BackwardChunkData->at(x).at(y).at(CHUNK_SIZE_Z - 1).IsTransparent() &&
-										BackwardChunkData->at(x).at(y).at(CHUNK_SIZE_Z - 1).p_BlockType != block->p_BlockType)
-									{
-										light_level = BackwardChunkLData->at(x).at(y).at(CHUNK_SIZE_Z - 1);
-										AddFace(chunk, BlockFaceType::front, local_position, block->p_BlockType, light_level, false);
-										AddFace(chunk, BlockFaceType::backward, local_position, block->p_BlockType, light_level, false);
-									}
-
-									else if (ChunkData->at(x).at(y).at(1).IsTransparent() &&
-										ChunkData->at(x).at(y).at(1).p_BlockType != block->p_BlockType)
-									{
-										light_level = ChunkLData->at(x).at(y).at(1);
-										AddFace(chunk, BlockFaceType::front, local_position, block->p_BlockType, light_level, false);
-										AddFace(chunk, BlockFaceType::backward, local_position, block->p_BlockType, light_level, false);
-									}
-								}
+				for (int f = 0; f < 6; f++)
+				{
+					uint32_t neighbour_opaque;
+					uint32_t neighbour_transparent;
+					uint32_t same_type;
 
-								else
-								{
-									if (BackwardChunkData->at(x).at(y).at(CHUNK_SIZE_Z - 1).IsOpaque() == false)
-									{
-										light_level = BackwardChunkLData->at(x).at(y).at(CHUNK_SIZE_Z - 1);
-										AddFace(chunk, BlockFaceType::front, local_position, block->p_BlockType, light_level);
-										AddFace(chunk, BlockFaceType::backward, local_position, block->p_BlockType, light_level);
-									}
-
-									else if (ChunkData->at(x).at(y).at(1).IsOpaque() == false)
-									{
-										light_level = ChunkLData->at(x).at(y).at(1);
-										AddFace(chunk, BlockFaceType::front, local_position, block->p_BlockType, light_level);
-										AddFace(chunk, BlockFaceType::backward, local_position, block->p_BlockType, light_level);
-									}
-								}
-							}
+					if (FaceNormals[f].z != 0)
+					{
+						// The neighbours along z are in the same row
+						const int dz = FaceNormals[f].z;
 
-							else if (z >= CHUNK_SIZE_Z - 1)
-							{
-								if (block->IsTransparent())
-								{
-									if (ForwardChunkData->at(x).at(y).at(0).IsTransparent() &&
-										ForwardChunkData->at(x).at(y).at(0).p_BlockType != block->p_BlockType)
-									{
-										light_level = ForwardChunkLData->at(x).at(y).at(0);
-										AddFace(chunk, BlockFaceType::front, local_position, block->p_BlockType, light_level, false);
-										AddFace(chunk, BlockFaceType::backward, local_position, block->p_BlockType, light_level, false);
-									}
-
-									else if (ChunkData->at(x).at(y).at(CHUNK_SIZE_Z - 2).IsTransparent() &&
-										ChunkData->at(x).at(y).at(CHUNK_SIZE_Z - 2).p_BlockType != block->p_BlockType)
-									{
-										light_level = ChunkLData->at(x).at(y).at(CHUNK_SIZE_Z - 2);
-										AddFace(chunk, BlockFaceType::front, local_position, block->p_BlockType, light_level, false);
-										AddFace(chunk, BlockFaceType::backward, local_position, block->p_BlockType, light_level, false);
-									}
-								}
+						neighbour_opaque = dz > 0 ? row.p_Opaque >> 1 : row.p_Opaque << 1;
+						neighbour_transparent = dz > 0 ? row.p_Transparent >> 1 : row.p_Transparent << 1;
+						same_type = static_cast<uint32_t>(CompareBlockRows(blocks, blocks + dz)) << 1;
+					}
 
-								else
-								{
-									if (ForwardChunkData->at(x).at(y).at(0).IsOpaque() == false)
-									{
-										light_level = ForwardChunkLData->at(x).at(y).at(0);
-										AddFace(chunk, BlockFaceType::front, local_position, block->p_BlockType, light_level);
-										AddFace(chunk, BlockFaceType::backward, local_position, block->p_BlockType, light_level);
-									}
-
-									else if (ChunkData->at(x).at(y).at(CHUNK_SIZE_Z - 2).IsOpaque() == false)
-									{
-										light_level = ChunkLData->at(x).at(y).at(CHUNK_SIZE_Z - 2);
-										AddFace(chunk, BlockFaceType::front, local_position, block->p_BlockType, light_level);
-										AddFace(chunk, BlockFaceType::backward, local_position, block->p_BlockType, light_level);
-									}
-								}
-							}
+					else
+					{
+						const int nx = x + FaceNormals[f].x;
+						const int ny = y + FaceNormals[f].y;
+						const SnapshotRowMasks& neighbour_row = rows[nx + 1][ny - snapshot.p_BaseY + 1];
 
-							else
-							{
-								if (block->IsTransparent())
-								{
-									if (ChunkData->at(x).at(y).at(z + 1).IsTransparent() &&
-										ChunkData->at(x).at(y).at(z + 1).p_BlockType != block->p_BlockType)
-									{
-										light_level = ChunkLData->at(x).at(y).at(z + 1);
-										AddFace(chunk, BlockFaceType::front, local_position, block->p_BlockType, light_level, false);
-									}
-
-									if (ChunkData->at(x).at(y).at(z - 1).IsTransparent() &&
-										ChunkData->at(x).at(y).at(z - 1).p_BlockType != block->p_BlockType)
-									{
-										light_level = ChunkLData->at(x).at(y).at(z - 1);
-										AddFace(chunk, BlockFaceType::backward, local_position, block->p_BlockType, light_level, false);
-									}
-								}
+						neighbour_opaque = neighbour_row.p_Opaque;
+						neighbour_transparent = neighbour_row.p_Transparent;
+						same_type = static_cast<uint32_t>(CompareBlockRows(blocks, &snapshot.GetBlock(nx, ny, 0))) << 1;
+					}
 
-								else
-								{
-									//If the forward block is an air block, add the forward face to the mesh
-									if (ChunkData->at(x).at(y).at(z + 1).IsOpaque() == false)
-									{
-										light_level = ChunkLData->at(x).at(y).at(z + 1);
-										AddFace(chunk, BlockFaceType::front, local_position, block->p_BlockType, light_level);
-									}
-
-									// If the back (-forward) block is an air block, add the back face to the mesh
-									if (ChunkData->at(x).at(y).at(z - 1).IsOpaque() == false)
-									{
-										light_level = ChunkLData->at(x).at(y).at(z - 1);
-										AddFace(chunk, BlockFaceType::backward, local_position, block->p_BlockType, light_level);
-									}
-								}
-							}
+					const uint32_t visible = (solid & ~neighbour_opaque) | (transparent & neighbour_transparent & ~same_type);
+					masks.p_Visible[f][x][ly] = static_cast<uint16_t>((visible & inner) >> 1);
+				}
+			}
+		}
+	}
 
-							if (x <= 0)
-							{
-								if (block->IsTransparent())
-								{
-									if (LeftChunkData->at(CHUNK_SIZE_X - 1).at(y).at(z).IsTransparent() &&
-										LeftChunkData->at(CHUNK_SIZE_X - 1).at(y).at(z).p_BlockType != block->p_BlockType)
-									{
-										light_level = LeftChunkLData->at(CHUNK_SIZE_X - 1).at(y).at(z);
-										AddFace(chunk, BlockFaceType::left, local_position, block->p_BlockType, light_level, false);
-										AddFace(chunk, BlockFaceType::right, local_position, block->p_BlockType, light_level, false);
-									}
-
-									else if (ChunkData->at(1).at(y).at(z).IsTransparent() &&
-										ChunkData->at(1).at(y).at(z).p_BlockType != block->p_BlockType)
-									{
-										light_level = ChunkLData->at(1).at(y).at(z);
-										AddFace(chunk, BlockFaceType::right, local_position, block->p_BlockType, light_level, false);
-										AddFace(chunk, BlockFaceType::left, local_position, block->p_BlockType, light_level, false);
-									}
+	static bool IsUniformOpaque(const Chunk* chunk, int section)
+	{
+		BlockType type;
 
-								}
+		if (!chunk || !chunk->IsSectionUniform(section, type))
+		{
+			return false;
+		}
 
-								else
-								{
-									if (LeftChunkData->at(CHUNK_SIZE_X - 1).at(y).at(z).IsOpaque() == false)
-									{
-										light_level = LeftChunkLData->at(CHUNK_SIZE_X - 1).at(y).at(z);
-										AddFace(chunk, BlockFaceType::left, local_position, block->p_BlockType, light_level);
-										AddFace(chunk, BlockFaceType::right, local_position, block->p_BlockType, light_level);
-									}
-
-									else if (ChunkData->at(1).at(y).at(z).IsOpaque() == false)
-									{
-										light_level = ChunkLData->at(1).at(y).at(z);
-										AddFace(chunk, BlockFaceType::right, local_position, block->p_BlockType, light_level);
-										AddFace(chunk, BlockFaceType::left, local_position, block->p_BlockType, light_level);
-									}
-								}
-							}
+		Block block = { type };
+		return block.IsOpaque() && !block.IsTransparent();
+	}
 
-							else if (x >= CHUNK_SIZE_X - 1)
-							{
-								if (block->IsTransparent())
-								{
-									if (RightChunkData->at(0).at(y).at(z).IsTransparent() &&
-										RightChunkData->at(0).at(y).at(z).p_BlockType != block->p_BlockType)
-									{
-										light_level = RightChunkLData->at(0).at(y).at(z);
-										AddFace(chunk, BlockFaceType::left, local_position, block->p_BlockType, light_level, false);
-										AddFace(chunk, BlockFaceType::right, local_position, block->p_BlockType, light_level, false);
-									}
-
-									else if (ChunkData->at(CHUNK_SIZE_X - 2).at(y).at(z).IsTransparent() &&
-										ChunkData->at(CHUNK_SIZE_X - 2).at(y).at(z).p_BlockType != block->p_BlockType)
-									{
-										light_level = ChunkLData->at(CHUNK_SIZE_X - 2).at(y).at(z);
-										AddFace(chunk, BlockFaceType::left, local_position, block->p_BlockType, light_level, false);
-										AddFace(chunk, BlockFaceType::right, local_position, block->p_BlockType, light_level, false);
-									}
-								}
+	bool ChunkMesh::IsSectionHidden(const Chunk* chunk, int section)
+	{
+		const int cx = static_cast<int>(chunk->p_Position.x);
+		const int cz = static_cast<int>(chunk->p_Position.z);
 
-								else
-								{
-									if (RightChunkData->at(0).at(y).at(z).IsOpaque() == false)
-									{
-										light_level = RightChunkLData->at(0).at(y).at(z);
-										AddFace(chunk, BlockFaceType::left, local_position, block->p_BlockType, light_level);
-										AddFace(chunk, BlockFaceType::right, local_position, block->p_BlockType, light_level);
-									}
-
-									else if (ChunkData->at(CHUNK_SIZE_X - 2).at(y).at(z).IsOpaque() == false)
-									{
-										light_level = ChunkLData->at(CHUNK_SIZE_X - 2).at(y).at(z);
-										AddFace(chunk, BlockFaceType::left, local_position, block->p_BlockType, light_level);
-										AddFace(chunk, BlockFaceType::right, local_position, block->p_BlockType, light_level);
-									}
-								}
+		// The top of the world is open. The bottom section has no faces below, the layer under the world mirrors it
+		if (section == CHUNK_SECTION_COUNT - 1 || !IsUniformOpaque(chunk, section))
+		{
+			return false;
+		}
 
-							}
+		return (section == 0 || IsUniformOpaque(chunk, section - 1)) &&
+			IsUniformOpaque(chunk, section + 1) &&
+			IsUniformOpaque(_GetChunkForMeshing(cx, cz + 1), section) &&
+			IsUniformOpaque(_GetChunkForMeshing(cx, cz - 1), section) &&
+			IsUniformOpaque(_GetChunkForMeshing(cx + 1, cz), section) &&
+			IsUniformOpaque(_GetChunkForMeshing(cx - 1, cz), section);
+	}
 
-							else
-							{
-								if (block->IsTransparent())
-								{
-									if (ChunkData->at(x + 1).at(y).at(z).IsTransparent() &&
-										ChunkData->at(x + 1).at(y).at(z).p_BlockType != block->p_BlockType)
-									{
-										light_level = ChunkLData->at(x + 1).at(y).at(z);
-										AddFace(chunk, BlockFaceType::right, local_position, block->p_BlockType, light_level, false);
-									}
-
-									if (ChunkData->at(x - 1).at(y).at(z).IsTransparent() &&
-										ChunkData->at(x - 1).at(y).at(z).p_BlockType != block->p_BlockType)
-									{
-										light_level = ChunkLData->at(x - 1).at(y).at(z);
-										AddFace(chunk, BlockFaceType::left, local_position, block->p_BlockType, light_level, false);
-									}
-								}
+	bool ChunkMesh::CreateSnapshot(Chunk* chunk, int section, ChunkMeshSnapshot& snapshot)
+	{
+		const int cx = static_cast<int>(chunk->p_Position.x);
+		const int cz = static_cast<int>(chunk->p_Position.z);
 
-								else
-								{
-									// If the next block is an air block, add the right face to the mesh
-									if (ChunkData->at(x + 1).at(y).at(z).IsOpaque() == false)
-									{
-										light_level = ChunkLData->at(x + 1).at(y).at(z);
-										AddFace(chunk, BlockFaceType::right, local_position, block->p_BlockType, light_level);
-									}
-
-									// If the previous block is an air block, add the left face to the mesh
-									if (ChunkData->at(x - 1).at(y).at(z).IsOpaque() == false)
-									{
-										light_level = ChunkLData->at(x - 1).at(y).at(z);
-										AddFace(chunk, BlockFaceType::left, local_position, block->p_BlockType, light_level);
-									}
-								}
-							}
+		const Chunk* ForwardChunk = _GetChunkForMeshing(cx, cz + 1);
+		const Chunk* BackwardChunk = _GetChunkForMeshing(cx, cz - 1);
+		const Chunk* RightChunk = _GetChunkForMeshing(cx + 1, cz);
+		const Chunk* LeftChunk = _GetChunkForMeshing(cx - 1, cz);
 
-							if (y <= 0)
-							{
-								if (ChunkData->at(x).at(y + 1).at(z).IsOpaque() == false)
-								{
-									AddFace(chunk, BlockFaceType::bottom, local_position, block->p_BlockType, light_level);
-								}
-							}
+		if (!ForwardChunk || !BackwardChunk || !RightChunk || !LeftChunk)
+		{
+			return false;
+		}
 
-							else if (y >= CHUNK_SIZE_Y - 1)
-							{
-								AddFace(chunk, BlockFaceType::top, local_position, block->p_BlockType, light_level);
-							}
+		snapshot.p_BaseY = section * CHUNK_SECTION_SIZE_Y;
+		snapshot.p_Height = std::min(CHUNK_SECTION_SIZE_Y, CHUNK_SIZE_Y - snapshot.p_BaseY);
 
-							else
-							{
-								if (block->IsTransparent())
-								{
-									if (ChunkData->at(x).at(y - 1).at(z).IsTransparent() &&
-										ChunkData->at(x).at(y - 1).at(z).p_BlockType != block->p_BlockType)
-									{
-										light_level = ChunkLData->at(x).at(y - 1).at(z);
-										AddFace(chunk, BlockFaceType::bottom, local_position, block->p_BlockType, light_level, false);
-									}
-
-									if (ChunkData->at(x).at(y + 1).at(z).IsTransparent() &&
-										ChunkData->at(x).at(y + 1).at(z).p_BlockType != block->p_BlockType)
-									{
-										light_level = ChunkLData->at(x).at(y + 1).at(z);
-										AddFace(chunk, BlockFaceType::top, local_position, block->p_BlockType, light_level, false);
-									}
-								}
+		snapshot.p_Blocks.fill(Block{ BlockType::Air });
+		snapshot.p_Light.fill(0);
+		snapshot.p_SkyLight.fill(MAX_SKY_LIGHT_LEVEL);
 
-								else
-								{
-									// If the top block is an air block, add the top face to the mesh
-									if (ChunkData->at(x).at(y - 1).at(z).IsOpaque() == false)
-									{
-										light_level = ChunkLData->at(x).at(y - 1).at(z);
-										AddFace(chunk, BlockFaceType::bottom, local_position, block->p_BlockType, light_level);
-									}
-
-									// If the bottom block is an air block, add the top face to the mesh
-									if (ChunkData->at(x).at(y + 1).at(z).IsOpaque() == false)
-									{
-										light_level = ChunkLData->at(x).at(y + 1).at(z);
-										AddFace(chunk, BlockFaceType::top, local_position, block->p_BlockType, light_level);
-									}
-								}
-							}
-						}
-					}
-				}
-			}
+		// The section with one layer above and below it, clamped to the world
+		const int min_y = std::max(snapshot.p_BaseY - 1, 0);
+		const int max_y = std::min(snapshot.p_BaseY + snapshot.p_Height, CHUNK_SIZE_Y - 1);
+
+		// z is the innermost axis in the snapshot, the palette storage and the light map, so every row is decoded or copied at once
+		for (int y = min_y; y <= max_y; y++)
+		{
+			for (int x = 0; x < CHUNK_SIZE_X; x++)
+			{
+				const int index = snapshot.GetIndex(x, y, 0);
 
-			// Upload the data to the GPU whenever the mesh is reconstructed
+				chunk->GetBlockRow(x, y, &snapshot.p_Blocks[index]);
+				chunk->GetLightRow(x, y, &snapshot.p_Light[index]);
 
-			p_VerticesCount = 0;
-			p_TransparentVerticesCount = 0;
-			p_ModelVerticesCount = 0;
+				// The forward and backward borders
+				snapshot.p_Blocks[snapshot.GetIndex(x, y, -1)] = BackwardChunk->GetBlock(x, y, CHUNK_SIZE_Z - 1);
+				snapshot.p_Light[snapshot.GetIndex(x, y, -1)] = BackwardChunk->GetTorchLightAt(x, y, CHUNK_SIZE_Z - 1);
+				snapshot.p_Blocks[snapshot.GetIndex(x, y, CHUNK_SIZE_Z)] = ForwardChunk->GetBlock(x, y, 0);
+				snapshot.p_Light[snapshot.GetIndex(x, y, CHUNK_SIZE_Z)] = ForwardChunk->GetTorchLightAt(x, y, 0);
+			}
 
-			if (m_Vertices.size() > 0)
+			// The left and right borders
+			LeftChunk->GetBlockRow(CHUNK_SIZE_X - 1, y, &snapshot.p_Blocks[snapshot.GetIndex(-1, y, 0)]);
+			LeftChunk->GetLightRow(CHUNK_SIZE_X - 1, y, &snapshot.p_Light[snapshot.GetIndex(-1, y, 0)]);
+			RightChunk->GetBlockRow(0, y, &snapshot.p_Blocks[snapshot.GetIndex(CHUNK_SIZE_X, y, 0)]);
+			RightChunk->GetLightRow(0, y, &snapshot.p_Light[snapshot.GetIndex(CHUNK_SIZE_X, y, 0)]);
+		}
+
+		// The layer below the world mirrors the bottom layer and the top layer of light is repeated above the world
+		for (int x = -1; x <= CHUNK_SIZE_X; x++)
+		{
+			for (int z = -1; z <= CHUNK_SIZE_Z; z++)
 			{
-				m_VBO.BufferData(this->m_Vertices.size() * sizeof(Vertex), &this->m_Vertices.front(), GL_STATIC_DRAW);
-				p_VerticesCount = m_Vertices.size();
-				m_Vertices.clear();
+				if (snapshot.p_BaseY == 0)
+				{
+					snapshot.p_Blocks[snapshot.GetIndex(x, -1, z)] = snapshot.p_Blocks[snapshot.GetIndex(x, 0, z)];
+				}
+
+				if (snapshot.p_BaseY + snapshot.p_Height >= CHUNK_SIZE_Y)
+				{
+					snapshot.p_Light[snapshot.GetIndex(x, CHUNK_SIZE_Y, z)] = snapshot.p_Light[snapshot.GetIndex(x, CHUNK_SIZE_Y - 1, z)];
+				}
 			}
+		}
 
-			if (m_TransparentVertices.size() > 0)
+		// The sky light of the section and the layer above it, that is all HasShadow() reads. Above the world it stays at the maximum
+		for (int y = snapshot.p_BaseY; y <= max_y; y++)
+		{
+			for (int x = 0; x < CHUNK_SIZE_X; x++)
 			{
-				m_TransparentVBO.BufferData(this->m_TransparentVertices.size() * sizeof(Vertex), &this->m_TransparentVertices.front(), GL_STATIC_DRAW);
-				p_TransparentVerticesCount = m_TransparentVertices.size();
-				m_TransparentVertices.clear();
+				chunk->GetSkyLightRow(x, y, &snapshot.p_SkyLight[snapshot.GetIndex(x, y, 0)]);
 			}
+		}
+
+		return true;
+	}
+
+	void ChunkMesh::BuildMesh(const ChunkMeshSnapshot& snapshot, ChunkMeshData& data, ChunkMeshingMode mode, ChunkVertexFormat format)
+	{
+		data.p_MeshingMode = mode;
+		data.p_VertexFormat = format;
+		data.p_Vertices.clear();
+		data.p_TransparentVertices.clear();
+		data.p_ModelVertices.clear();
+		data.p_PackedVertices.clear();
+		data.p_PackedTransparentVertices.clear();
+		data.p_PackedModelVertices.clear();
+
+		if (mode == ChunkMeshingMode::Greedy)
+		{
+			BuildGreedyMesh(snapshot, data);
+			return;
+		}
+
+		BuildPerFaceMesh(snapshot, data);
+	}
+
+	// Adds one quad for every visible face
+	void ChunkMesh::BuildPerFaceMesh(const ChunkMeshSnapshot& snapshot, ChunkMeshData& data)
+	{
+		SectionFaceMasks masks;
+		BuildFaceMasks(snapshot, masks);
 
-			if (m_ModelVertices.size() > 0)
+		for (int x = 0; x < CHUNK_SIZE_X; x++)
+		{
+			for (int y = snapshot.p_BaseY; y < snapshot.p_BaseY + snapshot.p_Height; y++)
 			{
-				m_ModelVBO.BufferData(this->m_ModelVertices.size() * sizeof(Vertex), &this->m_ModelVertices.front(), GL_STATIC_DRAW);
-				p_ModelVerticesCount = m_ModelVertices.size();
-				m_ModelVertices.clear();
+				const int ly = y - snapshot.p_BaseY;
+
+				for (uint32_t models = masks.p_Models[x][ly]; models != 0; models &= models - 1)
+				{
+					const int z = CountTrailingZeros(models);
+					AddModel(snapshot, data, glm::vec3(x, y, z), snapshot.GetBlock(x, y, z).p_BlockType, snapshot.GetLight(x, y + 1, z));
+				}
+
+				for (int f = 0; f < 6; f++)
+				{
+					for (uint32_t visible = masks.p_Visible[f][x][ly]; visible != 0; visible &= visible - 1)
+					{
+						const int z = CountTrailingZeros(visible);
+						const Block& block = snapshot.GetBlock(x, y, z);
+						const uint8_t light_level = snapshot.GetLight(x + FaceNormals[f].x, y + FaceNormals[f].y, z + FaceNormals[f].z);
+
+						AddFace(snapshot, data, FaceTypes[f], glm::vec3(x, y, z), block.p_BlockType, light_level, !block.IsTransparent());
+					}
+				}
 			}
+		}
+	}
 
-			return true;
+	// Copies one vertex array in to a new range of the arena and returns the amount of vertices in it
+	template <typename T>
+	static std::uint32_t UploadVertices(ChunkMeshArena& arena, std::vector<T>& vertices, std::uint32_t& first_vertex)
+	{
+		if (vertices.empty())
+		{
+			return 0;
+		}
+
+		std::uint32_t count = vertices.size();
+		first_vertex = arena.Allocate(count);
+		arena.Upload(first_vertex, vertices.data(), count);
+		vertices.clear();
+
+		return count;
+	}
+
+	// Upload the data to the GPU whenever the mesh is reconstructed
+	void ChunkMesh::UploadMesh(ChunkMeshData& data)
+	{
+		ClearMesh();
+
+		p_MeshingMode = data.p_MeshingMode;
+		p_VertexFormat = data.p_VertexFormat;
+
+		if (data.p_Vertices.empty() && data.p_TransparentVertices.empty() && data.p_ModelVertices.empty() &&
+			data.p_PackedVertices.empty() && data.p_PackedTransparentVertices.empty() && data.p_PackedModelVertices.empty())
+		{
+			return;
+		}
+
+		ChunkMeshArena& arena = ChunkMeshArena::Get(p_VertexFormat);
+
+		if (data.p_VertexFormat == ChunkVertexFormat::Packed)
+		{
+			p_VerticesCount = UploadVertices(arena, data.p_PackedVertices, p_FirstVertex);
+			p_TransparentVerticesCount = UploadVertices(arena, data.p_PackedTransparentVertices, p_FirstTransparentVertex);
+			p_ModelVerticesCount = UploadVertices(arena, data.p_PackedModelVertices, p_FirstModelVertex);
 		}
 
-		return false;
+		else
+		{
+			p_VerticesCount = UploadVertices(arena, data.p_Vertices, p_FirstVertex);
+			p_TransparentVerticesCount = UploadVertices(arena, data.p_TransparentVertices, p_FirstTransparentVertex);
+			p_ModelVerticesCount = UploadVertices(arena, data.p_ModelVertices, p_FirstModelVertex);
+		}
 	}
 
 	glm::ivec3 ConvertWorldPosToBlock(const glm::vec3& position)
@@ -516,25 +540,43 @@ namespace Omnia
 		return glm::ivec3(lx, ly, lz);
 	}
 
-	bool HasShadow(Chunk* chunk, int x, int y, int z)
+	// The face index stored in a packed vertex, in the order listed in Utils/Vertex.h
+	static uint8_t GetPackedFaceIndex(BlockFaceType face_type)
 	{
-		constexpr int max_shadow = 24;
-		for (int i = y + 1; i < y + max_shadow; i++)
+		switch (face_type)
 		{
-			if (i < CHUNK_SIZE_Y)
-			{
-				if (chunk->p_ChunkContents.at(x).at(i).at(z).CastsShadow())
-				{
-					return true;
-				}
-			}
+		case BlockFaceType::top: return 0;
+		case BlockFaceType::bottom: return 1;
+		case BlockFaceType::front: return 2;
+		case BlockFaceType::backward: return 3;
+		case BlockFaceType::right: return 4;
+		case BlockFaceType::left: return 5;
+		default: return 7;
+		}
+	}
+
+	static constexpr uint8_t PACKED_MODEL_FACE_INDEX = 6;
+
+	// Appends one vertex in the format the mesh data is being built in. The corner is the index of the vertex in its quad
+	static inline void PushVertex(ChunkMeshData& data, std::vector<Vertex>& vertices, std::vector<PackedVertex>& packed_vertices, 
+		const Vertex& vertex, uint8_t face, uint8_t corner)
+	{
+		if (data.p_VertexFormat == ChunkVertexFormat::Packed)
+		{
+			packed_vertices.push_back(PackVertex(vertex, face, corner));
+			return;
 		}
 
-		return false;
+		vertices.push_back(vertex);
 	}
 
-	void ChunkMesh::AddFace(Chunk* chunk, BlockFaceType face_type, const glm::vec3& position, BlockType type, uint8_t light_level,
-		bool buffer)
+	static bool HasShadow(const ChunkMeshSnapshot& snapshot, int x, int y, int z)
+	{
+		return snapshot.GetSkyLight(x, y + 1, z) < MAX_SKY_LIGHT_LEVEL;
+	}
+
+	void ChunkMesh::AddFace(const ChunkMeshSnapshot& snapshot, ChunkMeshData& data, BlockFaceType face_type, const glm::vec3& position, BlockType type, 
+		uint8_t light_level, bool buffer)
 	{
 		glm::vec4 translation = glm::vec4(position, 0.0f); // No need to create a model matrix. 
 		// Adding the position to the translation will do the samething but much much faster
@@ -554,15 +596,15 @@ namespace Omnia
 		{
 			uint8_t face_light_level = 10;
 
-			if (HasShadow(chunk, position.x, position.y, position.z))
+			if (HasShadow(snapshot, position.x, position.y, position.z))
 			{
 				face_light_level -= 2;
 			}
 
-			v1.position = translation + m_TopFace[0];
-			v2.position = translation + m_TopFace[1];
-			v3.position = translation + m_TopFace[2];
-			v4.position = translation + m_TopFace[3];
+			v1.position = translation + TopFace[0];
+			v2.position = translation + TopFace[1];
+			v3.position = translation + TopFace[2];
+			v4.position = translation + TopFace[3];
 
 			// Set the lighting level for the vertex
 			v1.lighting_level = light_level;
@@ -580,10 +622,10 @@ namespace Omnia
 
 		case BlockFaceType::bottom:
 		{
-			v1.position = translation + m_BottomFace[3];
-			v2.position = translation + m_BottomFace[2];
-			v3.position = translation + m_BottomFace[1];
-			v4.position = translation + m_BottomFace[0];
+			v1.position = translation + BottomFace[3];
+			v2.position = translation + BottomFace[2];
+			v3.position = translation + BottomFace[1];
+			v4.position = translation + BottomFace[0];
 
 			// Set the lighting level for the vertex
 			v1.lighting_level = light_level;
@@ -603,10 +645,10 @@ namespace Omnia
 
 		case BlockFaceType::front:
 		{
-			v1.position = translation + m_ForwardFace[3];
-			v2.position = translation + m_ForwardFace[2];
-			v3.position = translation + m_ForwardFace[1];
-			v4.position = translation + m_ForwardFace[0];
+			v1.position = translation + ForwardFace[3];
+			v2.position = translation + ForwardFace[2];
+			v3.position = translation + ForwardFace[1];
+			v4.position = translation + ForwardFace[0];
 
 			// Set the lighting level for the vertex
 			v1.lighting_level = light_level;
@@ -626,10 +668,10 @@ namespace Omnia
 
 		case BlockFaceType::backward:
 		{
-			v1.position = translation + m_BackFace[0];
-			v2.position = translation + m_BackFace[1];
-			v3.position = translation + m_BackFace[2];
-			v4.position = translation + m_BackFace[3];
+			v1.position = translation + BackFace[0];
+			v2.position = translation + BackFace[1];
+			v3.position = translation + BackFace[2];
+			v4.position = translation + BackFace[3];
 
 			v1.lighting_level = light_level;
 			v2.lighting_level = light_level;
@@ -646,10 +688,10 @@ namespace Omnia
 
 		case BlockFaceType::left:
 		{
-			v1.position = translation + m_LeftFace[3];
-			v2.position = translation + m_LeftFace[2];
-			v3.position = translation + m_LeftFace[1];
-			v4.position = translation + m_LeftFace[0];
+			v1.position = translation + LeftFace[3];
+			v2.position = translation + LeftFace[2];
+			v3.position = translation + LeftFace[1];
+			v4.position = translation + LeftFace[0];
 
 			v1.lighting_level = light_level;
 			v2.lighting_level = light_level;
@@ -668,10 +710,10 @@ namespace Omnia
 
 		case BlockFaceType::right:
 		{
-			v1.position = translation + m_RightFace[0];
-			v2.position = translation + m_RightFace[1];
-			v3.position = translation + m_RightFace[2];
-			v4.position = translation + m_RightFace[3];
+			v1.position = translation + RightFace[0];
+			v2.position = translation + RightFace[1];
+			v3.position = translation + RightFace[2];
+			v4.position = translation + RightFace[3];
 
 			v1.lighting_level = light_level;
 			v2.lighting_level = light_level;
@@ -721,32 +763,25 @@ namespace Omnia
 			v4.texture_coords = { TextureCoordinates[6], TextureCoordinates[7] };
 		}
 
-		if (buffer)
-		{
-			m_Vertices.push_back(v1);
-			m_Vertices.push_back(v2);
-			m_Vertices.push_back(v3);
-			m_Vertices.push_back(v4);
-		}
+		std::vector<Vertex>& vertices = buffer ? data.p_Vertices : data.p_TransparentVertices;
+		std::vector<PackedVertex>& packed_vertices = buffer ? data.p_PackedVertices : data.p_PackedTransparentVertices;
+		const uint8_t face = GetPackedFaceIndex(face_type);
 
-		else if (!buffer)
-		{
-			m_TransparentVertices.push_back(v1);
-			m_TransparentVertices.push_back(v2);
-			m_TransparentVertices.push_back(v3);
-			m_TransparentVertices.push_back(v4);
-		}
+		PushVertex(data, vertices, packed_vertices, v1, face, 0);
+		PushVertex(data, vertices, packed_vertices, v2, face, 1);
+		PushVertex(data, vertices, packed_vertices, v3, face, 2);
+		PushVertex(data, vertices, packed_vertices, v4, face, 3);
 	}
 
 	// Adds a model such as a flower or a deadbush to the chunk mesh
-	void ChunkMesh::AddModel(Chunk* chunk, const glm::vec3& local_pos, BlockType type, float light_level)
+	void ChunkMesh::AddModel(const ChunkMeshSnapshot& snapshot, ChunkMeshData& data, const glm::vec3& local_pos, BlockType type, float light_level)
 	{
 		glm::mat4 translation = glm::translate(glm::mat4(1.0f), local_pos);
 		Model model(type);
 
 		uint8_t face_light = 10;
 
-		if (HasShadow(chunk, local_pos.x, local_pos.y, local_pos.z))
+		if (HasShadow(snapshot, local_pos.x, local_pos.y, local_pos.z))
 		{
 			face_light -= 2;
 		}
@@ -763,7 +798,219 @@ namespace Omnia
 			vertex.lighting_level = light_level;
 			vertex.block_face_lighting = face_light;
 
-			m_ModelVertices.push_back(vertex);
+			PushVertex(data, data.p_ModelVertices, data.p_PackedModelVertices, vertex, PACKED_MODEL_FACE_INDEX, i % 4);
+		}
+	}
+
+	/*
+		Greedy meshing
+	*/
+
+	struct GreedyMaskFace
+	{
+		BlockType p_Type = BlockType::Air;
+		uint8_t p_LightLevel = 0;
+		uint8_t p_FaceLighting = 0;
+		bool p_Transparent = false;
+		bool p_Visible = false;
+
+		bool operator==(const GreedyMaskFace& other) const
+		{
+			return p_Visible == other.p_Visible && p_Type == other.p_Type && p_LightLevel == other.p_LightLevel &&
+				p_FaceLighting == other.p_FaceLighting && p_Transparent == other.p_Transparent;
+		}
+	};
+
+	void ChunkMesh::BuildGreedyMesh(const ChunkMeshSnapshot& snapshot, ChunkMeshData& data)
+	{
+		SectionFaceMasks masks;
+		BuildFaceMasks(snapshot, masks);
+
+		// Models are never merged
+		for (int x = 0; x < CHUNK_SIZE_X; x++)
+		{
+			for (int y = snapshot.p_BaseY; y < snapshot.p_BaseY + snapshot.p_Height; y++)
+			{
+				for (uint32_t models = masks.p_Models[x][y - snapshot.p_BaseY]; models != 0; models &= models - 1)
+				{
+					const int z = CountTrailingZeros(models);
+					AddModel(snapshot, data, glm::vec3(x, y, z), snapshot.GetBlock(x, y, z).p_BlockType, snapshot.GetLight(x, y + 1, z));
+				}
+			}
+		}
+
+		// Same order as FaceTypes
+		static const uint8_t lighting_levels[6] = { 10, 3, 6, 7, 7, 6 };
+
+		// The axis each face points along (0 = x, 1 = y, 2 = z) and the two axes of the face plane
+		static const int face_axis[6] = { 1, 1, 2, 2, 0, 0 };
+		static const int face_u_axis[6] = { 0, 0, 0, 0, 2, 2 };
+		static const int face_v_axis[6] = { 2, 2, 1, 1, 1, 1 };
+
+		const int section_base[3] = { 0, snapshot.p_BaseY, 0 };
+		const int section_size[3] = { CHUNK_SIZE_X, snapshot.p_Height, CHUNK_SIZE_Z };
+		std::vector<GreedyMaskFace> mask;
+
+		for (int f = 0; f < 6; f++)
+		{
+			const int d = face_axis[f];
+			const int u = face_u_axis[f];
+			const int v = face_v_axis[f];
+			const int size_u = section_size[u];
+			const int size_v = section_size[v];
+
+			mask.resize(size_u * size_v);
+
+			for (int slice = 0; slice < section_size[d]; slice++)
+			{
+				// Write the visible faces of this slice to the mask
+				for (int j = 0; j < size_v; j++)
+				{
+					for (int i = 0; i < size_u; i++)
+					{
+						glm::ivec3 pos;
+						pos[d] = section_base[d] + slice;
+						pos[u] = section_base[u] + i;
+						pos[v] = section_base[v] + j;
+
+						GreedyMaskFace& face = mask[i + j * size_u];
+						face = GreedyMaskFace();
+
+						if (((masks.p_Visible[f][pos.x][pos.y - snapshot.p_BaseY] >> pos.z) & 1) == 0)
+						{
+							continue;
+						}
+
+						const Block& block = snapshot.GetBlock(pos.x, pos.y, pos.z);
+						const glm::ivec3 neighbour_pos = pos + FaceNormals[f];
+
+						face.p_Visible = true;
+						face.p_Type = block.p_BlockType;
+						face.p_LightLevel = snapshot.GetLight(neighbour_pos.x, neighbour_pos.y, neighbour_pos.z);
+						face.p_Transparent = block.IsTransparent();
+						face.p_FaceLighting = lighting_levels[f];
+
+						if (FaceTypes[f] == BlockFaceType::top && HasShadow(snapshot, pos.x, pos.y, pos.z))
+						{
+							face.p_FaceLighting -= 2;
+						}
+
+						if (block.p_BlockType == BlockType::Water)
+						{
+							face.p_FaceLighting = 85;
+						}
+					}
+				}
+
+				// Merge equal faces into rectangles, first along u then along v
+				for (int j = 0; j < size_v; j++)
+				{
+					for (int i = 0; i < size_u;)
+					{
+						const GreedyMaskFace face = mask[i + j * size_u];
+
+						if (!face.p_Visible)
+						{
+							i++;
+							continue;
+						}
+
+						int width = 1;
+
+						while (i + width < size_u && mask[i + width + j * size_u] == face)
+						{
+							width++;
+						}
+
+						int height = 1;
+						bool done = false;
+
+						while (j + height < size_v)
+						{
+							for (int k = 0; k < width; k++)
+							{
+								if (!(mask[i + k + (j + height) * size_u] == face))
+								{
+									done = true;
+									break;
+								}
+							}
+
+							if (done)
+							{
+								break;
+							}
+
+							height++;
+						}
+
+						// Clear the merged faces so they aren't added again
+						for (int h = 0; h < height; h++)
+						{
+							for (int w = 0; w < width; w++)
+							{
+								mask[i + w + (j + h) * size_u].p_Visible = false;
+							}
+						}
+
+						glm::ivec3 origin;
+						glm::ivec3 size;
+						origin[d] = section_base[d] + slice;
+						origin[u] = section_base[u] + i;
+						origin[v] = section_base[v] + j;
+						size[d] = 1;
+						size[u] = width;
+						size[v] = height;
+
+						AddGreedyFace(data, FaceTypes[f], origin, size, face.p_Type, face.p_LightLevel, face.p_FaceLighting, !face.p_Transparent);
+
+						i += width;
+					}
+				}
+			}
+		}
+	}
+
+	void ChunkMesh::AddGreedyFace(ChunkMeshData& data, BlockFaceType face_type, const glm::ivec3& origin, const glm::ivec3& size, BlockType type,
+		uint8_t light_level, uint8_t face_lighting, bool buffer)
+	{
+		const glm::vec4* face = nullptr;
+
+		// Same vertex order as AddFace() so the winding order matches
+		bool reverse_vertices = false;
+
+		switch (face_type)
+		{
+		case BlockFaceType::top: face = TopFace; break;
+		case BlockFaceType::bottom: face = BottomFace; reverse_vertices = true; break;
+		case BlockFaceType::front: face = ForwardFace; reverse_vertices = true; break;
+		case BlockFaceType::backward: face = BackFace; break;
+		case BlockFaceType::left: face = LeftFace; reverse_vertices = true; break;
+		case BlockFaceType::right: face = RightFace; break;
+		default: return;
+		}
+
+		// The shader repeats the texture starting from its origin in the atlas
+		const std::array<uint16_t, 8>& TextureCoordinates = BlockDatabase::GetBlockTexture(type, face_type);
+		i16Vec2 texture_origin;
+		texture_origin.x = std::min(std::min(TextureCoordinates[0], TextureCoordinates[2]), std::min(TextureCoordinates[4], TextureCoordinates[6]));
+		texture_origin.y = std::min(std::min(TextureCoordinates[1], TextureCoordinates[3]), std::min(TextureCoordinates[5], TextureCoordinates[7]));
+
+		std::vector<Vertex>& vertices = buffer ? data.p_Vertices : data.p_TransparentVertices;
+		std::vector<PackedVertex>& packed_vertices = buffer ? data.p_PackedVertices : data.p_PackedTransparentVertices;
+		const uint8_t face_index = GetPackedFaceIndex(face_type);
+
+		for (int i = 0; i < 4; i++)
+		{
+			const glm::vec4& corner = face[reverse_vertices ? 3 - i : i];
+			Vertex vertex;
+
+			vertex.position = glm::vec3(origin) + glm::vec3(corner) * glm::vec3(size);
+			vertex.texture_coords = texture_origin;
+			vertex.lighting_level = light_level;
+			vertex.block_face_lighting = face_lighting;
+
+			PushVertex(data, vertices, packed_vertices, vertex, face_index, i);
 		}
 	}
 }
\ No newline at end of file
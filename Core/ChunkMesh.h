@@ -1,8 +1,5 @@
 #pragma once
 
-#define GLEW_STATIC
-#include <GL/glew.h>
-
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -10,63 +7,179 @@
 #include <iostream>
 #include <vector>
 #include <array>
+#include <memory>
+#include <cstdint>
 
-#include "OpenGL Classes/VertexBuffer.h"
-#include "OpenGL Classes/IndexBuffer.h"
-#include "OpenGL Classes/VertexArray.h"
-#include "OpenGL Classes/Shader.h"
-#include "OpenGL Classes/Texture.h"
-
-#include "Models/Model.h"
-
-//#include "Utils/Vertex.h"
-#include "BlockDatabase.h"
+// No opengl here : every chunk section holds a ChunkMesh, and the generator and the chunk files are built without opengl (see Tools/WorldPregen.cpp)
+#include "Block.h"
+#include "Utils/Defs.h"
+#include "Utils/Enums.h"
+#include "Utils/Vertex.h"
 
 namespace Omnia
 {
 	class Chunk;
-	typedef std::array<std::array<std::array<Block, CHUNK_SIZE_X>, CHUNK_SIZE_Y>, CHUNK_SIZE_Z>* ChunkDataTypePtr;
-	typedef std::array<std::array<std::array<uint8_t, CHUNK_SIZE_X>, CHUNK_SIZE_Y>, CHUNK_SIZE_Z>* ChunkLightDataTypePtr;
 
 	// Forward declarations
-	ChunkDataTypePtr _GetChunkDataForMeshing(int cx, int cz);
-	ChunkLightDataTypePtr _GetChunkLightDataForMeshing(int cx, int cz);
+	const Chunk* _GetChunkForMeshing(int cx, int cz);
+
+	/*
+	A copy of one section of a chunk with a one block border taken from its neighbours (the four neighbouring chunks and
+	the sections above and below), stored in one contiguous padded array (18x18x18).
+	This is the only input of the mesher, so the mesh can be built on any thread while the world keeps changing.
+	The corner columns of the border are never used and stay air. 
+	The layer above the world is air and the layer below the world mirrors y = 0 so no faces are built towards the void.
+	Top faces get darker when they can't see the sky, the sky light (see Chunk::UpdateSkyLight()) is only copied for the section and the layer above it.
+	*/
+	struct ChunkMeshSnapshot
+	{
+		static constexpr int PADDED_SIZE_X = CHUNK_SIZE_X + 2;
+		static constexpr int PADDED_SIZE_Y = CHUNK_SECTION_SIZE_Y + 2;
+		static constexpr int PADDED_SIZE_Z = CHUNK_SIZE_Z + 2;
+		static constexpr int PADDED_VOLUME = PADDED_SIZE_X * PADDED_SIZE_Y * PADDED_SIZE_Z;
+
+		// x and z are relative to the chunk, y is relative to the chunk (not the section). They can go one block outside of the section on every side
+		inline int GetIndex(int x, int y, int z) const noexcept
+		{
+			return ((x + 1) * PADDED_SIZE_Y + (y - p_BaseY + 1)) * PADDED_SIZE_Z + (z + 1);
+		}
+
+		inline const Block& GetBlock(int x, int y, int z) const noexcept { return p_Blocks[GetIndex(x, y, z)]; }
+		inline uint8_t GetLight(int x, int y, int z) const noexcept { return p_Light[GetIndex(x, y, z)]; }
+		inline uint8_t GetSkyLight(int x, int y, int z) const noexcept { return p_SkyLight[GetIndex(x, y, z)]; }
+
+		int p_BaseY = 0; // The y of the first block of the section
+		int p_Height = CHUNK_SECTION_SIZE_Y;
+		std::array<Block, PADDED_VOLUME> p_Blocks;
+		std::array<uint8_t, PADDED_VOLUME> p_Light;
+		std::array<uint8_t, PADDED_VOLUME> p_SkyLight; // The border columns are left at MAX_SKY_LIGHT_LEVEL
+	};
+
+	/*
+	PerFace : One quad for every visible block face
+	Greedy : Coplanar faces with the same block type and lighting are merged into larger quads. 
+	The quads carry the atlas origin of the block texture instead of the per corner texture coordinates, 
+	the chunk shader has to repeat the texture over the quad when u_GreedyMeshing is set. The shaders don't do that yet,
+	so the settings menu doesn't offer this mode (the textures would be stretched)
+	*/
+	enum class ChunkMeshingMode : std::uint8_t
+	{
+		PerFace = 0,
+		Greedy
+	};
+
+	/*
+	Standard : 12 byte Vertex with one attribute per field
+	Packed : 8 byte PackedVertex (see Utils/Vertex.h) that has to be decoded in the vertex shader. Drawn with the OMNIA_PACKED_VERTICES variant of the chunk shaders,
+	the shaders don't have the decode yet so the settings menu doesn't offer this format
+	*/
+	enum class ChunkVertexFormat : std::uint8_t
+	{
+		Standard = 0,
+		Packed
+	};
+
+	// The cpu side vertices of a chunk mesh. Owned by whoever builds the mesh until it is uploaded
+	struct ChunkMeshData
+	{
+		ChunkMeshingMode p_MeshingMode = ChunkMeshingMode::PerFace;
+		ChunkVertexFormat p_VertexFormat = ChunkVertexFormat::Standard;
+		std::vector<Vertex> p_Vertices;
+		std::vector<Vertex> p_TransparentVertices;
+		std::vector<Vertex> p_ModelVertices;
+
+		// Only used when p_VertexFormat is Packed
+		std::vector<PackedVertex> p_PackedVertices;
+		std::vector<PackedVertex> p_PackedTransparentVertices;
+		std::vector<PackedVertex> p_PackedModelVertices;
+	};
+
+	/*
+	What a mesh gives its vertex ranges back to, implemented by ChunkMeshArena.
+	The meshes only use this interface so that the chunks don't need the arena or opengl
+	*/
+	class ChunkMeshAllocator
+	{
+	public :
+
+		virtual ~ChunkMeshAllocator() = default;
+		virtual void Free(std::uint32_t first_vertex, std::uint32_t vertex_count) = 0;
+
+		// nullptr until something of the format is uploaded, and after the arenas are destroyed
+		static inline ChunkMeshAllocator* Find(ChunkVertexFormat format) noexcept { return s_Allocators[static_cast<int>(format)]; }
+
+	protected :
+
+		// Set by the arena of each format while it exists
+		static inline ChunkMeshAllocator* s_Allocators[2] = {};
+	};
 
 	class ChunkMesh
 	{
 	public : 
 
-		ChunkMesh();
-		~ChunkMesh();
+		ChunkMesh() = default;
+		~ChunkMesh() { ClearMesh(); }
+
+		// A mesh owns ranges in the chunk mesh arena, it can't be copied
+		ChunkMesh(const ChunkMesh&) = delete;
+		ChunkMesh& operator=(const ChunkMesh&) = delete;
+
+		// Copies a section and the borders of its neighbours. Returns false if a neighbour isn't loaded yet. Has to be called from the main thread
+		static bool CreateSnapshot(Chunk* chunk, int section, ChunkMeshSnapshot& snapshot);
+
+		// Returns true if the section can't have any faces : it is uniform and opaque and so are all the sections around it.
+		// Those sections (deep underground) are skipped without taking a snapshot
+		static bool IsSectionHidden(const Chunk* chunk, int section);
+
+		// Fills the vertex arrays from a snapshot. Doesn't touch any opengl or world state so it can be called from a worker thread
+		static void BuildMesh(const ChunkMeshSnapshot& snapshot, ChunkMeshData& data, ChunkMeshingMode mode = ChunkMeshingMode::PerFace,
+			ChunkVertexFormat format = ChunkVertexFormat::Standard);
+
+		// Copies the vertices in to the arena of their vertex format (see ChunkMeshArena.h). Has to be called from the main thread
+		void UploadMesh(ChunkMeshData& data);
+
+		// Gives the ranges of the mesh back to the arena. The arena is gone when the renderer was destroyed first, there is nothing to give back then
+		inline void ClearMesh()
+		{
+			ChunkMeshAllocator* allocator = ChunkMeshAllocator::Find(p_VertexFormat);
+
+			if (allocator && (p_VerticesCount > 0 || p_TransparentVerticesCount > 0 || p_ModelVerticesCount > 0))
+			{
+				allocator->Free(p_FirstVertex, p_VerticesCount);
+				allocator->Free(p_FirstTransparentVertex, p_TransparentVerticesCount);
+				allocator->Free(p_FirstModelVertex, p_ModelVerticesCount);
+			}
+
+			p_VerticesCount = 0;
+			p_TransparentVerticesCount = 0;
+			p_ModelVerticesCount = 0;
+		}
+
+		std::uint32_t p_VerticesCount = 0;
+		std::uint32_t p_TransparentVerticesCount = 0;
+		std::uint32_t p_ModelVerticesCount = 0;
+
+		// Where the meshes start in the arena of p_VertexFormat
+		std::uint32_t p_FirstVertex = 0;
+		std::uint32_t p_FirstTransparentVertex = 0;
+		std::uint32_t p_FirstModelVertex = 0;
 
-		bool ConstructMesh(Chunk* chunk, const glm::vec3& chunk_pos);
-		
-		std::uint32_t p_VerticesCount;
-		std::uint32_t p_TransparentVerticesCount;
-		std::uint32_t p_ModelVerticesCount;
-		GLClasses::VertexArray p_VAO;
-		GLClasses::VertexArray p_TransparentVAO;
-		GLClasses::VertexArray p_ModelVAO;
+		ChunkMeshingMode p_MeshingMode = ChunkMeshingMode::PerFace; // The mode of the mesh that is currently uploaded
+		ChunkVertexFormat p_VertexFormat = ChunkVertexFormat::Standard; // The vertex format of the mesh that is currently uploaded
 
 	private : 
 
-		void AddFace(Chunk* chunk, BlockFaceType face_type, const glm::vec3& position, BlockType type, uint8_t light_level,
-			bool buffer = true);
+		static void BuildPerFaceMesh(const ChunkMeshSnapshot& snapshot, ChunkMeshData& data);
+		static void BuildGreedyMesh(const ChunkMeshSnapshot& snapshot, ChunkMeshData& data);
 
-		void AddModel(Chunk* chunk, const glm::vec3& local_pos, BlockType type, float light_level);
+		static void AddFace(const ChunkMeshSnapshot& snapshot, ChunkMeshData& data, BlockFaceType face_type, const glm::vec3& position, BlockType type, 
+			uint8_t light_level, bool buffer = true);
 
-		std::vector<Vertex> m_Vertices;
-		std::vector<Vertex> m_TransparentVertices;
-		std::vector<Vertex> m_ModelVertices;
-		glm::vec4 m_TopFace[4];
-		glm::vec4 m_BottomFace[4];
-		glm::vec4 m_ForwardFace[4];
-		glm::vec4 m_BackFace[4];
-		glm::vec4 m_LeftFace[4];
-		glm::vec4 m_RightFace[4];
+		static void AddModel(const ChunkMeshSnapshot& snapshot, ChunkMeshData& data, const glm::vec3& local_pos, BlockType type, float light_level);
 
-		GLClasses::VertexBuffer m_VBO;
-		GLClasses::VertexBuffer m_TransparentVBO; // Vertex buffer for trasparent blocks
-		GLClasses::VertexBuffer m_ModelVBO; // Vertex buffer for trasparent blocks
+		// Adds a merged quad. origin is the first block of the quad and size is the amount of blocks it covers on each axis
+		static void AddGreedyFace(ChunkMeshData& data, BlockFaceType face_type, const glm::ivec3& origin, const glm::ivec3& size, BlockType type,
+			uint8_t light_level, uint8_t face_lighting, bool buffer);
 	};
 }
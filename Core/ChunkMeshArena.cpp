@@ -0,0 +1,296 @@
+#include "ChunkMeshArena.h"
+#include "Utils/Logger.h"
+
+#include <algorithm>
+
+namespace Omnia
+{
+	/*
+	One index pattern (0 1 2 2 3 0 + 4 * quad) with 16 bit indices that is shared by both arenas.
+	Every draw starts at index 0 and uses the first vertex of its range as the base vertex
+	*/
+	static std::unique_ptr<GLClasses::IndexBuffer> QuadIBO;
+
+	static GLClasses::IndexBuffer& GetQuadIndexBuffer()
+	{
+		if (!QuadIBO)
+		{
+			QuadIBO = std::make_unique<GLClasses::IndexBuffer>();
+
+			std::vector<GLushort> indices(ChunkMeshArena::MAX_QUADS_PER_DRAW * 6);
+			GLushort index_offset = 0;
+
+			for (size_t i = 0; i < indices.size(); i += 6)
+			{
+				indices[i] = 0 + index_offset;
+				indices[i + 1] = 1 + index_offset;
+				indices[i + 2] = 2 + index_offset;
+				indices[i + 3] = 2 + index_offset;
+				indices[i + 4] = 3 + index_offset;
+				indices[i + 5] = 0 + index_offset;
+
+				index_offset = index_offset + 4;
+			}
+
+			QuadIBO->BufferData(indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+		}
+
+		return *QuadIBO;
+	}
+
+	static std::unique_ptr<ChunkMeshArena> Arenas[2];
+
+	ChunkMeshArena& ChunkMeshArena::Get(ChunkVertexFormat format)
+	{
+		std::unique_ptr<ChunkMeshArena>& arena = Arenas[static_cast<int>(format)];
+
+		if (!arena)
+		{
+			arena = std::make_unique<ChunkMeshArena>(format);
+		}
+
+		return *arena;
+	}
+
+	ChunkMeshArena* ChunkMeshArena::Find(ChunkVertexFormat format)
+	{
+		return Arenas[static_cast<int>(format)].get();
+	}
+
+	void ChunkMeshArena::DestroyArenas()
+	{
+		for (std::unique_ptr<ChunkMeshArena>& arena : Arenas)
+		{
+			arena.reset();
+		}
+
+		QuadIBO.reset();
+	}
+
+	ChunkMeshArena::ChunkMeshArena(ChunkVertexFormat format) : m_Format(format), m_Capacity(0), m_UsedVertices(0)
+	{
+		m_VertexSize = format == ChunkVertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+
+		m_VAO.Bind();
+		GetQuadIndexBuffer().Bind();
+		m_VAO.Unbind();
+
+		Grow(INITIAL_CAPACITY);
+		s_Allocators[static_cast<int>(format)] = this;
+
+		Logger::LogToConsole(std::string("Created the chunk mesh arena (") + (format == ChunkVertexFormat::Packed ? "packed" : "standard") +
+			" vertices)");
+	}
+
+	ChunkMeshArena::~ChunkMeshArena()
+	{
+		s_Allocators[static_cast<int>(m_Format)] = nullptr;
+	}
+
+	// Creates a larger buffer and copies the old vertices over, the ranges keep their offsets
+	void ChunkMeshArena::Grow(std::uint32_t min_capacity)
+	{
+		std::uint32_t new_capacity = std::max(m_Capacity * 2, INITIAL_CAPACITY);
+
+		while (new_capacity < min_capacity)
+		{
+			new_capacity *= 2;
+		}
+
+		std::unique_ptr<GLClasses::VertexBuffer> new_vbo = std::make_unique<GLClasses::VertexBuffer>(GL_ARRAY_BUFFER);
+		new_vbo->BufferData(static_cast<GLsizeiptr>(new_capacity) * m_VertexSize, nullptr, GL_DYNAMIC_DRAW);
+
+		if (m_VBO && m_Capacity > 0)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, m_VBO->GetID());
+			glBindBuffer(GL_COPY_WRITE_BUFFER, new_vbo->GetID());
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(m_Capacity) * m_VertexSize);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+
+		m_VBO = std::move(new_vbo);
+
+		// Add the new space to the free ranges, merging it with the last range if that one was free
+		std::uint32_t first_new_vertex = m_Capacity;
+		std::uint32_t new_vertices = new_capacity - m_Capacity;
+
+		if (!m_FreeRanges.empty())
+		{
+			auto last = std::prev(m_FreeRanges.end());
+
+			if (last->first + last->second == m_Capacity)
+			{
+				first_new_vertex = last->first;
+				new_vertices += last->second;
+				m_FreeRanges.erase(last);
+			}
+		}
+
+		m_FreeRanges[first_new_vertex] = new_vertices;
+		m_Capacity = new_capacity;
+
+		SetVertexAttributes();
+	}
+
+	void ChunkMeshArena::SetVertexAttributes()
+	{
+		m_VAO.Bind();
+
+		if (m_Format == ChunkVertexFormat::Packed)
+		{
+			// Both words are read as a uvec2 and unpacked in the shader
+			m_VBO->VertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(PackedVertex), (void*)offsetof(PackedVertex, data0));
+		}
+
+		else
+		{
+			m_VBO->VertexAttribIPointer(0, 3, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+			m_VBO->VertexAttribIPointer(1, 2, GL_UNSIGNED_SHORT, sizeof(Vertex), (void*)offsetof(Vertex, texture_coords));
+			m_VBO->VertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, lighting_level));
+			m_VBO->VertexAttribIPointer(3, 1, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, block_face_lighting));
+		}
+
+		m_VAO.Unbind();
+	}
+
+	// First fit
+	std::uint32_t ChunkMeshArena::Allocate(std::uint32_t vertex_count)
+	{
+		for (auto range = m_FreeRanges.begin(); range != m_FreeRanges.end(); range++)
+		{
+			if (range->second >= vertex_count)
+			{
+				const std::uint32_t first_vertex = range->first;
+				const std::uint32_t remaining = range->second - vertex_count;
+
+				m_FreeRanges.erase(range);
+
+				if (remaining > 0)
+				{
+					m_FreeRanges[first_vertex + vertex_count] = remaining;
+				}
+
+				m_UsedVertices += vertex_count;
+				return first_vertex;
+			}
+		}
+
+		Grow(m_Capacity + vertex_count);
+		return Allocate(vertex_count);
+	}
+
+	void ChunkMeshArena::Free(std::uint32_t first_vertex, std::uint32_t vertex_count)
+	{
+		if (vertex_count == 0)
+		{
+			return;
+		}
+
+		m_UsedVertices -= vertex_count;
+
+		auto next = m_FreeRanges.lower_bound(first_vertex);
+
+		// Merge with the following range
+		if (next != m_FreeRanges.end() && first_vertex + vertex_count == next->first)
+		{
+			vertex_count += next->second;
+			next = m_FreeRanges.erase(next);
+		}
+
+		// Merge with the previous range
+		if (next != m_FreeRanges.begin())
+		{
+			auto prev = std::prev(next);
+
+			if (prev->first + prev->second == first_vertex)
+			{
+				prev->second += vertex_count;
+				return;
+			}
+		}
+
+		m_FreeRanges[first_vertex] = vertex_count;
+	}
+
+	void ChunkMeshArena::Upload(std::uint32_t first_vertex, const void* vertices, std::uint32_t vertex_count)
+	{
+		m_VBO->BufferSubData(static_cast<GLintptr>(first_vertex) * m_VertexSize, static_cast<GLsizeiptr>(vertex_count) * m_VertexSize,
+			const_cast<void*>(vertices));
+	}
+
+	void ChunkMeshArena::QueueDraw(std::uint32_t first_vertex, std::uint32_t vertex_count, int chunk_x, int chunk_z, bool greedy_meshing)
+	{
+		const std::uint32_t quad_count = vertex_count / 4;
+		auto batch = m_DrawBatchIndices.find(std::make_tuple(chunk_x, chunk_z, greedy_meshing));
+
+		if (batch == m_DrawBatchIndices.end())
+		{
+			batch = m_DrawBatchIndices.emplace(std::make_tuple(chunk_x, chunk_z, greedy_meshing), m_DrawBatches.size()).first;
+			m_DrawBatches.push_back({ chunk_x, chunk_z, greedy_meshing ? 1 : 0 });
+		}
+
+		for (std::uint32_t first_quad = 0; first_quad < quad_count; first_quad += MAX_QUADS_PER_DRAW)
+		{
+			DrawRange range;
+
+			range.count = std::min(quad_count - first_quad, MAX_QUADS_PER_DRAW) * 6;
+			range.base_vertex = first_vertex + first_quad * 4;
+			range.batch = batch->second;
+
+			m_DrawRanges.push_back(range);
+		}
+	}
+
+	void ChunkMeshArena::DrawQueued(GLClasses::Shader& shader, bool keep_order)
+	{
+		if (m_DrawRanges.empty())
+		{
+			return;
+		}
+
+		// The batches are numbered in the order their chunks were first queued, so the groups keep the front to back order of their closest section
+		if (!keep_order)
+		{
+			std::stable_sort(m_DrawRanges.begin(), m_DrawRanges.end(), [](const DrawRange& a, const DrawRange& b) { return a.batch < b.batch; });
+		}
+
+		m_VAO.Bind();
+
+		for (size_t first = 0; first < m_DrawRanges.size();)
+		{
+			const std::uint32_t batch = m_DrawRanges[first].batch;
+			const ChunkDrawBatch& info = m_DrawBatches[batch];
+
+			m_MultiDrawCounts.clear();
+			m_MultiDrawBaseVertices.clear();
+
+			size_t last = first;
+
+			for (; last < m_DrawRanges.size() && m_DrawRanges[last].batch == batch; last++)
+			{
+				m_MultiDrawCounts.push_back(m_DrawRanges[last].count);
+				m_MultiDrawBaseVertices.push_back(m_DrawRanges[last].base_vertex);
+			}
+
+			// Every range starts at index 0 of the shared index buffer
+			if (m_MultiDrawIndices.size() < m_MultiDrawCounts.size())
+			{
+				m_MultiDrawIndices.resize(m_MultiDrawCounts.size(), nullptr);
+			}
+
+			shader.SetInteger("u_ChunkX", info.chunk_x);
+			shader.SetInteger("u_ChunkZ", info.chunk_z);
+			shader.SetInteger("u_GreedyMeshing", info.greedy_meshing);
+			glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_MultiDrawCounts.data(), GL_UNSIGNED_SHORT, m_MultiDrawIndices.data(), 
+				static_cast<GLsizei>(m_MultiDrawCounts.size()), m_MultiDrawBaseVertices.data());
+
+			first = last;
+		}
+
+		m_VAO.Unbind();
+		m_DrawRanges.clear();
+		m_DrawBatches.clear();
+		m_DrawBatchIndices.clear();
+	}
+}
\ No newline at end of file
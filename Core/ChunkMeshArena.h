@@ -0,0 +1,116 @@
+#pragma once
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+
+#include "OpenGL Classes/VertexBuffer.h"
+#include "OpenGL Classes/VertexArray.h"
+#include "OpenGL Classes/IndexBuffer.h"
+#include "OpenGL Classes/Shader.h"
+
+#include "ChunkMesh.h"
+
+namespace Omnia
+{
+	/*
+	One vertex buffer that holds the meshes of every chunk section that uses the same vertex format.
+	Meshes get a range of vertices in the buffer (Allocate()/Free()) instead of owning their own vbos and vaos,
+	so a whole pass can be drawn from a single vertex array.
+
+	Draws are queued with QueueDraw() and submitted with DrawQueued(). The chunk shaders read the chunk position from the u_ChunkX and u_ChunkZ uniforms
+	(and u_GreedyMeshing), so the queued ranges are grouped by chunk and every group is drawn with one glMultiDrawElementsBaseVertex after its uniforms are set.
+	That is one draw call per chunk and pass, like the vao of every chunk before the sections, instead of one per section.
+	Drawing a whole pass with one call would need the shaders to read the chunk position per draw (gl_DrawID or an instanced attribute),
+	the shader sources aren't part of this tree.
+
+	The arenas are only used from the main thread. They are destroyed with DestroyArenas() while the opengl context is still alive,
+	the renderer does it when it is destroyed. The meshes give their ranges back through ChunkMeshAllocator, which finds no arena after that.
+	*/
+
+	class ChunkMeshArena : public ChunkMeshAllocator
+	{
+	public :
+
+		ChunkMeshArena(ChunkVertexFormat format);
+		~ChunkMeshArena() override;
+
+		ChunkMeshArena(const ChunkMeshArena&) = delete;
+		ChunkMeshArena& operator=(const ChunkMeshArena&) = delete;
+
+		// Returns the first vertex of a free range of vertex_count vertices. The buffer grows when there is no free range large enough
+		std::uint32_t Allocate(std::uint32_t vertex_count);
+		void Free(std::uint32_t first_vertex, std::uint32_t vertex_count) override;
+		void Upload(std::uint32_t first_vertex, const void* vertices, std::uint32_t vertex_count);
+
+		// greedy_meshing is passed to the shader with the chunk position since it can differ between meshes
+		void QueueDraw(std::uint32_t first_vertex, std::uint32_t vertex_count, int chunk_x, int chunk_z, bool greedy_meshing);
+
+		// Draws the queued ranges with the shader (it has to be bound) and clears the queue. 
+		// Every range of a chunk is drawn together, with keep_order the ranges are drawn in the order they were queued (back to front for blending)
+		// and only the ranges of a chunk that were queued one after another are drawn together
+		void DrawQueued(GLClasses::Shader& shader, bool keep_order);
+
+		inline bool HasQueuedDraws() const noexcept { return m_DrawRanges.size() > 0; }
+		inline std::uint32_t GetCapacity() const noexcept { return m_Capacity; }
+		inline std::uint32_t GetUsedVertices() const noexcept { return m_UsedVertices; }
+
+		// Creates the arena of a format the first time it is needed. Needs an opengl context
+		static ChunkMeshArena& Get(ChunkVertexFormat format);
+
+		// Returns nullptr if nothing of that format was uploaded yet
+		static ChunkMeshArena* Find(ChunkVertexFormat format);
+
+		// Deletes the arenas and the shared index buffer. The ranges the meshes still hold are forgotten, ChunkMesh::ClearMesh() skips them
+		static void DestroyArenas();
+
+		// The amount of quads covered by the shared 16 bit index buffer (65536 vertices). Larger ranges are drawn in several parts
+		static constexpr std::uint32_t MAX_QUADS_PER_DRAW = 16384;
+
+		// In vertices, the buffer doubles when it is full
+		static constexpr std::uint32_t INITIAL_CAPACITY = 1 << 20;
+
+	private :
+
+		struct DrawRange
+		{
+			GLsizei count; // In indices
+			GLint base_vertex;
+			std::uint32_t batch;
+		};
+
+		// The uniforms of the ranges of one chunk
+		struct ChunkDrawBatch
+		{
+			GLint chunk_x;
+			GLint chunk_z;
+			GLint greedy_meshing;
+		};
+
+		void Grow(std::uint32_t min_capacity);
+		void SetVertexAttributes();
+
+		ChunkVertexFormat m_Format;
+		std::uint32_t m_VertexSize;
+		std::uint32_t m_Capacity;
+		std::uint32_t m_UsedVertices;
+		std::map<std::uint32_t, std::uint32_t> m_FreeRanges; // First vertex -> vertex count. Neighbouring ranges are always merged
+
+		GLClasses::VertexArray m_VAO;
+		std::unique_ptr<GLClasses::VertexBuffer> m_VBO;
+
+		std::vector<DrawRange> m_DrawRanges;
+		std::vector<ChunkDrawBatch> m_DrawBatches;
+		std::map<std::tuple<int, int, bool>, std::uint32_t> m_DrawBatchIndices; // Chunk position and greedy meshing -> batch
+
+		// The arguments of one glMultiDrawElementsBaseVertex, reused every draw
+		std::vector<GLsizei> m_MultiDrawCounts;
+		std::vector<GLint> m_MultiDrawBaseVertices;
+		std::vector<const void*> m_MultiDrawIndices;
+	};
+}
@@ -0,0 +1,129 @@
+#include "ChunkMesher.h"
+#include "Chunk.h"
+#include "BlockDatabase.h"
+#include "Utils/Logger.h"
+
+namespace Omnia
+{
+	ChunkMesher::ChunkMesher(unsigned int thread_count) : m_WorkerPool(thread_count), m_JobsInFlight(0), m_MeshingMode(ChunkMeshingMode::PerFace), 
+		m_VertexFormat(ChunkVertexFormat::Standard)
+	{
+		// The block database loads the atlas (an opengl texture) the first time it is used, so it has to be initialized on the main thread
+		// before any of the workers need it
+		BlockDatabase::GetBlockTexture(BlockType::Grass, BlockFaceType::top);
+
+		std::stringstream s;
+		s << "Chunk mesher started with " << m_WorkerPool.GetThreadCount() << " worker threads";
+		Logger::LogToConsole(s.str());
+	}
+
+	ChunkMesher::~ChunkMesher()
+	{
+		WaitForJobs();
+	}
+
+	bool ChunkMesher::QueueSection(Chunk* chunk, int section)
+	{
+		ChunkSection& chunk_section = chunk->p_Sections[section];
+
+		// Nothing to mesh, clear the old mesh without going through the workers
+		if (chunk->IsSectionEmpty(section) || ChunkMesh::IsSectionHidden(chunk, section))
+		{
+			ChunkMeshData empty_data;
+
+			chunk_section.p_MeshVersion++;
+			chunk_section.p_Mesh.UploadMesh(empty_data);
+			chunk_section.p_MeshState = ChunkMeshState::Built;
+
+			return true;
+		}
+
+		if (m_JobsInFlight >= MAX_JOBS_IN_FLIGHT)
+		{
+			return false;
+		}
+
+		std::unique_ptr<MeshJob> job = std::make_unique<MeshJob>();
+
+		// The snapshot is taken here so that the workers never touch the world
+		if (!ChunkMesh::CreateSnapshot(chunk, section, job->p_Snapshot))
+		{
+			return false;
+		}
+
+		chunk_section.p_MeshVersion++;
+		chunk_section.p_MeshState = ChunkMeshState::Meshing;
+
+		job->p_Chunk = chunk;
+		job->p_Section = section;
+		job->p_MeshVersion = chunk_section.p_MeshVersion;
+		job->p_MeshingMode = m_MeshingMode;
+		job->p_VertexFormat = m_VertexFormat;
+		chunk->p_MeshJobsInFlight++;
+		m_JobsInFlight++;
+
+		MeshJob* job_ptr = job.release();
+
+		m_WorkerPool.Enqueue([this, job_ptr]() 
+		{
+			std::unique_ptr<MeshJob> finished_job(job_ptr);
+			ChunkMesh::BuildMesh(finished_job->p_Snapshot, finished_job->p_Data, finished_job->p_MeshingMode, finished_job->p_VertexFormat);
+
+			std::lock_guard<std::mutex> lock(m_FinishedMutex);
+			m_FinishedJobs.push_back(std::move(finished_job));
+		});
+
+		return true;
+	}
+
+	uint32_t ChunkMesher::UploadFinishedMeshes(uint32_t max_uploads)
+	{
+		std::vector<std::unique_ptr<MeshJob>> finished_jobs;
+
+		{
+			std::lock_guard<std::mutex> lock(m_FinishedMutex);
+			finished_jobs.swap(m_FinishedJobs);
+		}
+
+		uint32_t uploads = 0;
+
+		for (size_t i = 0; i < finished_jobs.size(); i++)
+		{
+			std::unique_ptr<MeshJob>& job = finished_jobs[i];
+
+			// Keep the rest for the next frame once the upload budget is used up
+			if (uploads >= max_uploads)
+			{
+				std::lock_guard<std::mutex> lock(m_FinishedMutex);
+
+				for (size_t j = i; j < finished_jobs.size(); j++)
+				{
+					m_FinishedJobs.push_back(std::move(finished_jobs[j]));
+				}
+
+				break;
+			}
+
+			ChunkSection& section = job->p_Chunk->p_Sections[job->p_Section];
+			job->p_Chunk->p_MeshJobsInFlight--;
+			m_JobsInFlight--;
+
+			// The section was edited after this job was queued, this mesh is stale
+			if (job->p_MeshVersion != section.p_MeshVersion || section.p_MeshState != ChunkMeshState::Meshing)
+			{
+				continue;
+			}
+
+			section.p_Mesh.UploadMesh(job->p_Data);
+			section.p_MeshState = ChunkMeshState::Built;
+			uploads++;
+		}
+
+		return uploads;
+	}
+
+	void ChunkMesher::WaitForJobs()
+	{
+		m_WorkerPool.WaitIdle();
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "ChunkMesh.h"
+#include "Utils/ThreadPool.h"
+
+namespace Omnia
+{
+	class Chunk;
+
+	/*
+	Builds chunk section meshes on a pool of worker threads.
+
+	QueueSection() is called from the main thread, it copies the section and its borders into a snapshot and hands the job to a worker.
+	Sections that are all air are never queued, their mesh is cleared right away.
+	The worker fills a ChunkMeshData and pushes it on to the finished list.
+	UploadFinishedMeshes() is called once per frame from the main thread, it uploads the finished meshes to the vbos.
+
+	Every queued job carries the mesh version of the section at the time it was queued. If the section was edited (and queued again)
+	before the result reached the main thread, the versions won't match and the stale mesh is thrown away.
+	Until then the job is counted in Chunk::p_MeshJobsInFlight so the chunk isn't unloaded under it.
+	*/
+
+	class ChunkMesher
+	{
+	public :
+
+		ChunkMesher(unsigned int thread_count = ThreadPool::GetDefaultThreadCount());
+		~ChunkMesher();
+
+		// Returns false if the section couldn't be queued (neighbours aren't generated yet or too many jobs are in flight)
+		bool QueueSection(Chunk* chunk, int section);
+
+		// Uploads at most max_uploads finished meshes. Returns the amount of meshes uploaded
+		uint32_t UploadFinishedMeshes(uint32_t max_uploads = MAX_UPLOADS_PER_FRAME);
+
+		// Blocks until every queued job has finished. Used before chunks get destroyed
+		void WaitForJobs();
+
+		inline uint32_t GetJobsInFlight() const noexcept { return m_JobsInFlight; }
+
+		// Only affects the sections that are queued after the mode is changed
+		inline void SetMeshingMode(ChunkMeshingMode mode) noexcept { m_MeshingMode = mode; }
+		inline ChunkMeshingMode GetMeshingMode() const noexcept { return m_MeshingMode; }
+
+		// Same as the meshing mode, the sections have to be requeued for the new format to show up
+		inline void SetVertexFormat(ChunkVertexFormat format) noexcept { m_VertexFormat = format; }
+		inline ChunkVertexFormat GetVertexFormat() const noexcept { return m_VertexFormat; }
+
+		static constexpr uint32_t MAX_JOBS_IN_FLIGHT = 512;
+		static constexpr uint32_t MAX_UPLOADS_PER_FRAME = 128;
+
+	private :
+
+		struct MeshJob
+		{
+			Chunk* p_Chunk = nullptr;
+			int p_Section = 0;
+			uint32_t p_MeshVersion = 0;
+			ChunkMeshingMode p_MeshingMode = ChunkMeshingMode::PerFace;
+			ChunkVertexFormat p_VertexFormat = ChunkVertexFormat::Standard;
+			ChunkMeshSnapshot p_Snapshot;
+			ChunkMeshData p_Data;
+		};
+
+		ThreadPool m_WorkerPool;
+		std::mutex m_FinishedMutex;
+		std::vector<std::unique_ptr<MeshJob>> m_FinishedJobs;
+		uint32_t m_JobsInFlight; // Queued jobs that haven't been uploaded or discarded yet. Only touched by the main thread
+		ChunkMeshingMode m_MeshingMode;
+		ChunkVertexFormat m_VertexFormat;
+	};
+}
@@ -1,72 +1,590 @@
 #include "ChunkFileHandler.h"
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+
+#include "../World/WorldGenerator.h"
+
 namespace Omnia
 {
 	namespace ChunkFileHandler
 	{
+		// The first byte of every chunk payload
+		enum class ChunkPayloadType : std::uint8_t
+		{
+			RunLength = 1, // Every block and light value
+			UnversionedDelta, // A delta payload written before the generator version was stored, only read if the terrain hash still matches
+			Delta // The blocks that differ from the terrain of one generator version (see EncodeDeltaPayload())
+		};
+
+		static constexpr size_t CHUNK_VOLUME = CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z;
+		static constexpr size_t MAX_OPEN_REGION_FILES = 64;
+
+		// Path -> region file. nullptr is stored for region files that don't exist so that they are only looked up once
+		static std::map<std::string, std::unique_ptr<RegionFile>> OpenRegionFiles;
+
+		// Chunks are written from the chunk saver thread while the main thread reads them, every use of the region files
+		// (and the pointers GetRegionFile() returns) has to hold this
+		static std::mutex RegionFilesMutex;
+
+		std::string GenerateRegionFileName(int region_x, int region_z, const std::string& dir)
+		{
+			std::stringstream s;
 
-		void ExtendString(std::string& str, int ex_amt, std::string& ex_c)
+			s << dir << "r." << region_x << "." << region_z << ".region";
+			return s.str();
+		}
+
+		static RegionFile* GetRegionFile(int region_x, int region_z, const std::string& dir, bool create)
 		{
-			ex_amt = abs(static_cast<int>(ex_amt - str.size()));
+			const std::string file_name = GenerateRegionFileName(region_x, region_z, dir);
+			auto region = OpenRegionFiles.find(file_name);
+
+			if (region != OpenRegionFiles.end() && (region->second || !create))
+			{
+				return region->second.get();
+			}
 
-			for (int i = 0; i < ex_amt; i++)
+			if (OpenRegionFiles.size() >= MAX_OPEN_REGION_FILES)
 			{
-				str.insert(0, ex_c);
+				OpenRegionFiles.clear();
 			}
+
+			std::unique_ptr<RegionFile> region_file;
+
+			if (create || std::filesystem::exists(file_name))
+			{
+				region_file = std::make_unique<RegionFile>(file_name, create);
+
+				if (!region_file->IsOpen())
+				{
+					region_file.reset();
+				}
+			}
+
+			RegionFile* region_ptr = region_file.get();
+			OpenRegionFiles[file_name] = std::move(region_file);
+
+			return region_ptr;
 		}
 
-		std::string GenerateFileName(const glm::vec2& position, const std::string& dir)
+		static RegionFile* GetChunkRegionFile(int cx, int cz, const std::string& dir, bool create)
 		{
-			std::stringstream s;
-			
-			s << dir << position.x << "," << position.y;
-			return s.str();
+			return GetRegionFile(RegionFile::GetRegionCoordinate(cx), RegionFile::GetRegionCoordinate(cz), dir, create);
 		}
 
-		bool WriteChunk(Chunk* chunk, const std::string& dir)
+		// 7 bits per byte, the high bit is set if another byte follows
+		static void WriteVarInt(size_t value, std::vector<std::uint8_t>& out)
 		{
-			FILE* outfile;
-			std::stringstream s;
-			std::string file_name = GenerateFileName(glm::vec2(chunk->p_Position.x, chunk->p_Position.z), dir);
+			while (value >= 0x80)
+			{
+				out.push_back(static_cast<std::uint8_t>((value & 0x7F) | 0x80));
+				value >>= 7;
+			}
+
+			out.push_back(static_cast<std::uint8_t>(value));
+		}
+
+		// Returns false if the data ends before the value does
+		static bool ReadVarInt(const std::vector<std::uint8_t>& data, size_t& position, size_t& value)
+		{
+			value = 0;
+
+			for (int shift = 0; ; shift += 7)
+			{
+				if (position >= data.size() || shift > 28)
+				{
+					return false;
+				}
+
+				const std::uint8_t byte = data[position++];
+				value |= static_cast<size_t>(byte & 0x7F) << shift;
+
+				if ((byte & 0x80) == 0)
+				{
+					return true;
+				}
+			}
+		}
+
+		// Every run is stored as the value followed by the length of the run
+		static void EncodeRuns(const std::uint8_t* data, size_t size, std::vector<std::uint8_t>& out)
+		{
+			size_t i = 0;
+
+			while (i < size)
+			{
+				const std::uint8_t value = data[i];
+				size_t run = 1;
+
+				while (i + run < size && data[i + run] == value)
+				{
+					run++;
+				}
+
+				out.push_back(value);
+				WriteVarInt(run, out);
+				i += run;
+			}
+		}
+
+		// Returns the position after the runs or 0 if the data is invalid
+		static size_t DecodeRuns(const std::vector<std::uint8_t>& data, size_t position, std::uint8_t* out, size_t size)
+		{
+			size_t i = 0;
+
+			while (i < size)
+			{
+				if (position >= data.size())
+				{
+					return 0;
+				}
+
+				const std::uint8_t value = data[position++];
+				size_t run = 0;
+
+				if (!ReadVarInt(data, position, run) || run == 0 || i + run > size)
+				{
+					return 0;
+				}
+
+				memset(out + i, value, run);
+				i += run;
+			}
+
+			return position;
+		}
+
+		// FNV-1a, stored in delta payloads to notice when the terrain generator changed without a version bump
+		static std::uint32_t HashBlocks(const Block* blocks)
+		{
+			const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(blocks);
+			std::uint32_t hash = 2166136261u;
+
+			for (size_t i = 0; i < CHUNK_VOLUME; i++)
+			{
+				hash = (hash ^ bytes[i]) * 16777619u;
+			}
+
+			return hash;
+		}
+
+		static inline size_t GetBlockIndex(int x, int y, int z) noexcept
+		{
+			return (static_cast<size_t>(x) * CHUNK_SIZE_Y + y) * CHUNK_SIZE_Z + z;
+		}
+
+		// Spreads the light of the lamps in the chunk the same way the world does (see World::PropogateLight()), but only inside of the chunk
+		static void ComputeLampLight(const Block* blocks, std::uint8_t* light)
+		{
+			std::vector<std::uint32_t> queue;
+
+			memset(light, 0, CHUNK_VOLUME);
+
+			for (size_t i = 0; i < CHUNK_VOLUME; i++)
+			{
+				if (blocks[i].p_BlockType == BlockType::Lamp_On)
+				{
+					light[i] = LAMP_LIGHT_LEVEL;
+					queue.push_back(static_cast<std::uint32_t>(i));
+				}
+			}
+
+			for (size_t front = 0; front < queue.size(); front++)
+			{
+				const std::uint32_t index = queue[front];
+				const int x = static_cast<int>(index / (CHUNK_SIZE_Y * CHUNK_SIZE_Z));
+				const int y = static_cast<int>(index / CHUNK_SIZE_Z % CHUNK_SIZE_Y);
+				const int z = static_cast<int>(index % CHUNK_SIZE_Z);
+				const std::uint8_t light_level = light[index];
+
+				const glm::ivec3 neighbours[6] = { { x - 1, y, z }, { x + 1, y, z }, { x, y - 1, z }, { x, y + 1, z }, { x, y, z - 1 }, { x, y, z + 1 } };
+
+				for (const glm::ivec3& neighbour : neighbours)
+				{
+					if (neighbour.x < 0 || neighbour.x >= CHUNK_SIZE_X || neighbour.y < 0 || neighbour.y >= CHUNK_SIZE_Y ||
+						neighbour.z < 0 || neighbour.z >= CHUNK_SIZE_Z)
+					{
+						continue;
+					}
+
+					const size_t neighbour_index = GetBlockIndex(neighbour.x, neighbour.y, neighbour.z);
+
+					if (blocks[neighbour_index].IsLightPropogatable() && light[neighbour_index] + 2 <= light_level)
+					{
+						light[neighbour_index] = light_level - 1;
+						queue.push_back(static_cast<std::uint32_t>(neighbour_index));
+					}
+				}
+			}
+		}
+
+		// The chunk as the generator makes it
+		static void GenerateBaseline(Chunk* chunk, const ChunkSaveOptions& options, Block* blocks)
+		{
+			GenerateChunk(chunk, options.p_Seed, options.p_GenerationType);
+			chunk->GetBlocks(blocks);
+		}
+
+		static void EncodeFullPayload(const Block* blocks, const std::uint8_t* light, std::vector<std::uint8_t>& payload)
+		{
+			payload.push_back(static_cast<std::uint8_t>(ChunkPayloadType::RunLength));
+			EncodeRuns(reinterpret_cast<const std::uint8_t*>(blocks), CHUNK_VOLUME, payload);
+			EncodeRuns(light, CHUNK_VOLUME, payload);
+		}
+
+		/*
+		Delta payload :
+		WORLD_GENERATOR_VERSION (4 bytes), the hash of the baseline blocks (4 bytes), the number of changed blocks and one (distance to the previous changed block, block type) 
+		pair per changed block. Then a byte that is 0 if the light can be computed again from the lamps in the chunk 
+		or 1 if it is followed by the light runs (light coming in from the neighbouring chunks, light left over from removed lamps)
+		*/
+		static void EncodeDeltaPayload(int cx, int cz, const Block* blocks, const std::uint8_t* light, const ChunkSaveOptions& options, 
+			std::vector<std::uint8_t>& payload)
+		{
+			std::unique_ptr<Chunk> baseline_chunk = std::make_unique<Chunk>(glm::vec3(cx, 0, cz));
+			std::vector<Block> baseline(CHUNK_VOLUME);
+			std::vector<std::uint8_t> computed_light(CHUNK_VOLUME);
+			std::vector<std::uint8_t> changes;
+			size_t change_count = 0;
+			size_t last_index = 0;
+
+			GenerateBaseline(baseline_chunk.get(), options, baseline.data());
+
+			for (size_t i = 0; i < CHUNK_VOLUME; i++)
+			{
+				if (blocks[i].p_BlockType != baseline[i].p_BlockType)
+				{
+					WriteVarInt(i - last_index, changes);
+					changes.push_back(static_cast<std::uint8_t>(blocks[i].p_BlockType));
+					last_index = i;
+					change_count++;
+				}
+			}
+
+			const std::uint32_t hash = HashBlocks(baseline.data());
+
+			payload.push_back(static_cast<std::uint8_t>(ChunkPayloadType::Delta));
+
+			for (int i = 0; i < 4; i++)
+			{
+				payload.push_back(static_cast<std::uint8_t>(WORLD_GENERATOR_VERSION >> (i * 8)));
+			}
+
+			for (int i = 0; i < 4; i++)
+			{
+				payload.push_back(static_cast<std::uint8_t>(hash >> (i * 8)));
+			}
+
+			WriteVarInt(change_count, payload);
+			payload.insert(payload.end(), changes.begin(), changes.end());
+
+			ComputeLampLight(blocks, computed_light.data());
+
+			if (memcmp(computed_light.data(), light, CHUNK_VOLUME) == 0)
+			{
+				payload.push_back(0);
+			}
+
+			else
+			{
+				payload.push_back(1);
+				EncodeRuns(light, CHUNK_VOLUME, payload);
+			}
+		}
 
-			outfile = fopen(file_name.c_str(), "wb+");
+		/*
+		Returns false if the payload is invalid or was saved against other terrain than the generator makes now. The changes only make sense
+		on the terrain they were taken from, so they are never applied to different blocks : terrain_mismatch is set and blocks holds the generated terrain.
+		The baseline is generated in to the chunk, that also sets its height and biome maps. Unversioned payloads have no version field
+		*/
+		static bool DecodeDeltaPayload(Chunk* chunk, const std::vector<std::uint8_t>& payload, const ChunkSaveOptions& options, 
+			bool versioned, Block* blocks, std::uint8_t* light, bool& terrain_mismatch)
+		{
+			const int cx = static_cast<int>(chunk->p_Position.x);
+			const int cz = static_cast<int>(chunk->p_Position.z);
+			size_t position = 1;
+			size_t change_count = 0;
+			size_t index = 0;
+			std::uint32_t version = 0;
+			std::uint32_t hash = 0;
 
-			if (outfile == NULL)
+			if (payload.size() < (versioned ? 9u : 5u))
 			{
-				s << "Couldn't write chunk (" << file_name << ")";
+				return false;
+			}
+
+			if (versioned)
+			{
+				for (int i = 0; i < 4; i++)
+				{
+					version |= static_cast<std::uint32_t>(payload[position++]) << (i * 8);
+				}
+
+				if (version != WORLD_GENERATOR_VERSION)
+				{
+					std::stringstream s;
+					s << "Chunk (" << cx << "," << cz << ") was saved by terrain generator version " << version << " (this is version " 
+						<< WORLD_GENERATOR_VERSION << "), its changes can't be applied";
+					Logger::LogToConsole(s.str());
+
+					GenerateBaseline(chunk, options, blocks);
+					terrain_mismatch = true;
+					return false;
+				}
+			}
+
+			for (int i = 0; i < 4; i++)
+			{
+				hash |= static_cast<std::uint32_t>(payload[position++]) << (i * 8);
+			}
+
+			GenerateBaseline(chunk, options, blocks);
+
+			if (HashBlocks(blocks) != hash)
+			{
+				std::stringstream s;
+				s << "The terrain of chunk (" << cx << "," << cz << ") is generated differently than when it was saved, its changes can't be applied";
 				Logger::LogToConsole(s.str());
 
+				terrain_mismatch = true;
+				return false;
+			}
+
+			if (!ReadVarInt(payload, position, change_count) || change_count > CHUNK_VOLUME)
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < change_count; i++)
+			{
+				size_t distance = 0;
+
+				if (!ReadVarInt(payload, position, distance) || position >= payload.size() || index + distance >= CHUNK_VOLUME)
+				{
+					return false;
+				}
+
+				index += distance;
+				blocks[index].p_BlockType = static_cast<BlockType>(payload[position++]);
+			}
+
+			if (position >= payload.size())
+			{
 				return false;
 			}
 
-			fwrite(chunk->p_ChunkContents.data(), sizeof(Block), CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z, outfile);
-			fwrite(chunk->p_ChunkLightInformation.data(), sizeof(std::uint8_t), CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z, outfile);
+			if (payload[position++] == 0)
+			{
+				ComputeLampLight(blocks, light);
+				return true;
+			}
+
+			return DecodeRuns(payload, position, light, CHUNK_VOLUME) != 0;
+		}
+
+		bool WriteChunk(Chunk* chunk, const std::string& dir, const ChunkSaveOptions& options)
+		{
+			std::vector<Block> blocks(CHUNK_VOLUME);
+			std::vector<std::uint8_t> light(CHUNK_VOLUME);
+
+			chunk->GetBlocks(blocks.data());
+			chunk->GetLightMap(light.data());
+
+			return WriteChunk(static_cast<int>(chunk->p_Position.x), static_cast<int>(chunk->p_Position.z), blocks.data(), light.data(), dir, options);
+		}
+
+		bool WriteChunk(int cx, int cz, const Block* blocks, const std::uint8_t* light, const std::string& dir, const ChunkSaveOptions& options)
+		{
+			std::vector<std::uint8_t> payload;
+
+			// Encode before taking the lock, only the file io is serialized
+			EncodeFullPayload(blocks, light, payload);
+
+			// A chunk the player rebuilt completely is smaller as runs, keep whichever is smaller
+			if (options.p_Mode == ChunkSaveMode::Delta)
+			{
+				std::vector<std::uint8_t> delta_payload;
+				EncodeDeltaPayload(cx, cz, blocks, light, options, delta_payload);
+
+				if (delta_payload.size() < payload.size())
+				{
+					payload.swap(delta_payload);
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(RegionFilesMutex);
+			RegionFile* region = GetChunkRegionFile(cx, cz, dir, true);
+
+			if (!region || !region->WriteChunk(RegionFile::GetLocalCoordinate(cx), RegionFile::GetLocalCoordinate(cz), payload.data(),
+				static_cast<std::uint32_t>(payload.size())))
+			{
+				std::stringstream s;
+				s << "Couldn't write chunk (" << cx << "," << cz << ") to " << GenerateRegionFileName(RegionFile::GetRegionCoordinate(cx),
+					RegionFile::GetRegionCoordinate(cz), dir);
+				Logger::LogToConsole(s.str());
+
+				return false;
+			}
 
-			fclose(outfile);
 			return true;
 		}
 
-		bool ReadChunk(Chunk* chunk, const std::string& dir)
+		bool ReadChunk(Chunk* chunk, const std::string& dir, const ChunkSaveOptions& options)
 		{
-			FILE* infile;
-			std::stringstream s;
-			std::string file_name = dir;
+			const int cx = static_cast<int>(chunk->p_Position.x);
+			const int cz = static_cast<int>(chunk->p_Position.z);
+			std::vector<std::uint8_t> payload;
 
-			infile = fopen(file_name.c_str(), "rb");
+			{
+				std::lock_guard<std::mutex> lock(RegionFilesMutex);
+				RegionFile* region = GetChunkRegionFile(cx, cz, dir, false);
 
-			if (infile == NULL)
+				if (!region || !region->ReadChunk(RegionFile::GetLocalCoordinate(cx), RegionFile::GetLocalCoordinate(cz), payload))
+				{
+					return false;
+				}
+			}
+
+			std::vector<Block> blocks(CHUNK_VOLUME);
+			std::vector<std::uint8_t> light(CHUNK_VOLUME);
+			bool valid = false;
+			bool terrain_mismatch = false;
+
+			if (payload.size() > 0 && payload[0] == static_cast<std::uint8_t>(ChunkPayloadType::RunLength))
 			{
-				s << "Couldn't read chunk (" << file_name << ")";
+				size_t position = DecodeRuns(payload, 1, reinterpret_cast<std::uint8_t*>(blocks.data()), CHUNK_VOLUME);
+				valid = position && DecodeRuns(payload, position, light.data(), CHUNK_VOLUME);
+			}
+
+			else if (payload.size() > 0 && payload[0] == static_cast<std::uint8_t>(ChunkPayloadType::Delta))
+			{
+				valid = DecodeDeltaPayload(chunk, payload, options, true, blocks.data(), light.data(), terrain_mismatch);
+			}
+
+			else if (payload.size() > 0 && payload[0] == static_cast<std::uint8_t>(ChunkPayloadType::UnversionedDelta))
+			{
+				valid = DecodeDeltaPayload(chunk, payload, options, false, blocks.data(), light.data(), terrain_mismatch);
+			}
+
+			// Generating the chunk again would lose the changes the next time it is saved. It shows the generated terrain and is locked instead,
+			// the save stays as it is for a build that still makes the terrain it was taken from
+			if (terrain_mismatch)
+			{
+				std::stringstream s;
+				s << "CHUNK (" << cx << "," << cz << ") IS READ ONLY! Its saved changes are kept but not shown, it can't be edited or saved";
+				Logger::LogToConsole(s.str());
+
+				ComputeLampLight(blocks.data(), light.data());
+				chunk->SetBlocks(blocks.data());
+				chunk->SetLightMap(light.data());
+				chunk->p_ReadOnly = true;
+
+				return true;
+			}
+
+			if (!valid)
+			{
+				std::stringstream s;
+				s << "Chunk (" << cx << "," << cz << ") couldn't be read, it will be generated again";
 				Logger::LogToConsole(s.str());
 
 				return false;
 			}
 
-			fread(&chunk->p_ChunkContents, sizeof(Block), CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z, infile);
-			fread(&chunk->p_ChunkLightInformation, sizeof(std::uint8_t), CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z, infile);
+			chunk->SetBlocks(blocks.data());
+			chunk->SetLightMap(light.data());
 
-			fclose(infile);
 			return true;
 		}
+
+		bool ChunkExists(int cx, int cz, const std::string& dir)
+		{
+			std::lock_guard<std::mutex> lock(RegionFilesMutex);
+			RegionFile* region = GetChunkRegionFile(cx, cz, dir, false);
+
+			return region && region->HasChunk(RegionFile::GetLocalCoordinate(cx), RegionFile::GetLocalCoordinate(cz));
+		}
+
+		void CloseRegionFiles()
+		{
+			std::lock_guard<std::mutex> lock(RegionFilesMutex);
+			OpenRegionFiles.clear();
+		}
+
+		static bool ReadLegacyChunkFile(Chunk* chunk, const std::string& file_name)
+		{
+			FILE* infile = fopen(file_name.c_str(), "rb");
+
+			if (infile == NULL)
+			{
+				return false;
+			}
+
+			std::vector<Block> blocks(CHUNK_VOLUME, { BlockType::Air });
+			std::vector<std::uint8_t> light(CHUNK_VOLUME, 0);
+
+			bool read = fread(blocks.data(), sizeof(Block), blocks.size(), infile) == blocks.size() &&
+				fread(light.data(), sizeof(std::uint8_t), light.size(), infile) == light.size();
+
+			fclose(infile);
+
+			if (read)
+			{
+				chunk->SetBlocks(blocks.data());
+				chunk->SetLightMap(light.data());
+			}
+
+			return read;
+		}
+
+		int ConvertLegacyChunkFiles(const std::string& dir, const ChunkSaveOptions& options)
+		{
+			std::vector<std::filesystem::path> legacy_files;
+			int converted = 0;
+
+			if (!std::filesystem::is_directory(dir))
+			{
+				return 0;
+			}
+
+			for (const auto& entry : std::filesystem::directory_iterator(dir))
+			{
+				if (entry.is_regular_file() && entry.path().filename().string().find(',') != std::string::npos)
+				{
+					legacy_files.push_back(entry.path());
+				}
+			}
+
+			for (const std::filesystem::path& path : legacy_files)
+			{
+				int cx = 0;
+				int cz = 0;
+
+				if (sscanf(path.filename().string().c_str(), "%d,%d", &cx, &cz) != 2)
+				{
+					continue;
+				}
+
+				Chunk chunk(glm::vec3(cx, 0, cz));
+
+				if (ReadLegacyChunkFile(&chunk, path.string()) && WriteChunk(&chunk, dir, options))
+				{
+					std::filesystem::remove(path);
+					converted++;
+				}
+			}
+
+			if (converted > 0)
+			{
+				std::stringstream s;
+				s << "Converted " << converted << " chunk files to region files";
+				Logger::LogToConsole(s.str());
+			}
+
+			return converted;
+		}
 	}
-}
\ No newline at end of file
+}
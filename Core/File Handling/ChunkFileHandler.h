@@ -10,20 +10,66 @@
 #include <cstdlib>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <utility>
 
 #include "../Chunk.h"
 #include "../Utils/Logger.h"
 #include "../Utils/Defs.h"
 #include "../Block.h"
+#include "RegionFile.h"
+#include "../World/WorldGeneratorType.h"
 
 namespace Omnia
 {
 	namespace ChunkFileHandler
 	{
-		// Reads or writes a chunk to a file with a unique filename
-		// Uses C style file handling because it's slightly faster than the C++ counterpart
+		/*
+		Full : every block and light value is run length encoded, a typical chunk is a few kilobytes instead of 130. The default, what the game saves
+		Delta : the terrain is generated again from the seed and only the blocks that differ from it are stored (a few bytes per changed block).
+		The light is computed again from the lamps in the chunk when it is read, it is only stored if that doesn't give the same light.
+		A delta chunk that would be larger than the full payload (a chunk that was dug out completely) is written in full.
+		It relies on the generator making the same blocks for a seed every time, so it is opt in. Delta chunks store WORLD_GENERATOR_VERSION and a hash
+		of the terrain. A chunk saved against other terrain is read as the generated terrain and marked read only (Chunk::p_ReadOnly) :
+		its changes aren't applied to the wrong blocks, and it is never written so they aren't lost either
+		*/
+		enum class ChunkSaveMode : std::uint8_t
+		{
+			Full = 0,
+			Delta
+		};
 
-		bool WriteChunk(Chunk* chunk, const std::string& dir);
-		bool ReadChunk(Chunk* chunk, const std::string& dir);
+		// The seed and generation type are needed to read delta chunks whatever the mode is
+		struct ChunkSaveOptions
+		{
+			ChunkSaveMode p_Mode = ChunkSaveMode::Full;
+			int p_Seed = 0;
+			WorldGenerationType p_GenerationType = WorldGenerationType::Generation_Normal;
+		};
+
+		// Reads or writes a chunk in the region file that contains it (see RegionFile.h), dir is the chunk directory of the world.
+		// ReadChunk() returns false without logging anything if the chunk was never saved.
+		// The region tables are the index of the saved chunks : a region file is opened and its table read the first time
+		// one of its chunks is needed, a region without a file is remembered so a missing chunk costs one map lookup
+
+		bool WriteChunk(Chunk* chunk, const std::string& dir, const ChunkSaveOptions& options = ChunkSaveOptions());
+		bool ReadChunk(Chunk* chunk, const std::string& dir, const ChunkSaveOptions& options = ChunkSaveOptions());
+
+		// Writes a copy of a chunk (CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z blocks and light values in the GetBlocks() layout).
+		// Every function here can be called from any thread, this is what the chunk saver uses (see ChunkSaver.h)
+		bool WriteChunk(int cx, int cz, const Block* blocks, const std::uint8_t* light, const std::string& dir, 
+			const ChunkSaveOptions& options = ChunkSaveOptions());
+
+		bool ChunkExists(int cx, int cz, const std::string& dir);
+
+		// The region files stay open between reads and writes, this closes them
+		void CloseRegionFiles();
+
+		// Moves the chunks saved in the old layout (one uncompressed file per chunk named "x,z") in to region files and deletes the old files.
+		// Returns the number of chunks that were converted
+		int ConvertLegacyChunkFiles(const std::string& dir, const ChunkSaveOptions& options = ChunkSaveOptions());
+
+		// The path of a region file in a chunk directory (dir + "r.x.z.region")
+		std::string GenerateRegionFileName(int region_x, int region_z, const std::string& dir);
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,139 @@
+#include "ChunkSaver.h"
+
+#include "../Chunk.h"
+
+namespace Omnia
+{
+	static constexpr size_t CHUNK_VOLUME = CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z;
+
+	ChunkSaver::ChunkSaver() : m_IOThread(1)
+	{
+
+	}
+
+	ChunkSaver::~ChunkSaver()
+	{
+		WaitForWrites();
+	}
+
+	void ChunkSaver::QueueChunk(const Chunk* chunk, const std::string& dir, const ChunkFileHandler::ChunkSaveOptions& options)
+	{
+		std::shared_ptr<ChunkSnapshot> snapshot;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			snapshot = AllocateSnapshot();
+
+			// A new save, start counting again
+			if (m_PendingChunks.empty() && m_Progress.p_Queued == m_Progress.p_Written)
+			{
+				m_Progress = ChunkSaveProgress();
+			}
+		}
+
+		snapshot->p_X = static_cast<int>(chunk->p_Position.x);
+		snapshot->p_Z = static_cast<int>(chunk->p_Position.z);
+		snapshot->p_Directory = dir;
+		snapshot->p_Options = options;
+		chunk->GetBlocks(snapshot->p_Blocks.data());
+		chunk->GetLightMap(snapshot->p_Light.data());
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			// Replaces an older snapshot that isn't written yet, its job sees that and skips it
+			m_PendingChunks[{ snapshot->p_X, snapshot->p_Z }] = snapshot;
+			m_Progress.p_Queued++;
+		}
+
+		m_IOThread.Enqueue([this, snapshot]() { WriteSnapshot(snapshot); });
+	}
+
+	bool ChunkSaver::ReadPendingChunk(Chunk* chunk)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto pending = m_PendingChunks.find({ static_cast<int>(chunk->p_Position.x), static_cast<int>(chunk->p_Position.z) });
+
+		if (pending == m_PendingChunks.end())
+		{
+			return false;
+		}
+
+		chunk->SetBlocks(pending->second->p_Blocks.data());
+		chunk->SetLightMap(pending->second->p_Light.data());
+
+		return true;
+	}
+
+	void ChunkSaver::WaitForWrites()
+	{
+		m_IOThread.WaitIdle();
+	}
+
+	size_t ChunkSaver::GetPendingCount()
+	{
+		return m_IOThread.GetPendingJobCount();
+	}
+
+	ChunkSaveProgress ChunkSaver::GetProgress()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Progress;
+	}
+
+	std::shared_ptr<ChunkSaver::ChunkSnapshot> ChunkSaver::AllocateSnapshot()
+	{
+		if (!m_SnapshotPool.empty())
+		{
+			std::shared_ptr<ChunkSnapshot> snapshot = std::move(m_SnapshotPool.back());
+			m_SnapshotPool.pop_back();
+
+			return snapshot;
+		}
+
+		std::shared_ptr<ChunkSnapshot> snapshot = std::make_shared<ChunkSnapshot>();
+		snapshot->p_Blocks.resize(CHUNK_VOLUME);
+		snapshot->p_Light.resize(CHUNK_VOLUME);
+
+		return snapshot;
+	}
+
+	void ChunkSaver::ReleaseSnapshot(std::shared_ptr<ChunkSnapshot> snapshot)
+	{
+		if (m_SnapshotPool.size() < MAX_POOLED_SNAPSHOTS)
+		{
+			m_SnapshotPool.push_back(std::move(snapshot));
+		}
+	}
+
+	void ChunkSaver::WriteSnapshot(const std::shared_ptr<ChunkSnapshot>& snapshot)
+	{
+		const std::pair<int, int> position = { snapshot->p_X, snapshot->p_Z };
+		bool latest = false;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto pending = m_PendingChunks.find(position);
+			latest = pending != m_PendingChunks.end() && pending->second == snapshot;
+		}
+
+		// The snapshot stays in the pending map while it is written so the chunk can still be read from it.
+		// Nothing else writes to it, it is only given back to the pool below
+		if (latest)
+		{
+			ChunkFileHandler::WriteChunk(snapshot->p_X, snapshot->p_Z, snapshot->p_Blocks.data(), snapshot->p_Light.data(), snapshot->p_Directory,
+				snapshot->p_Options);
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto pending = m_PendingChunks.find(position);
+
+		if (pending != m_PendingChunks.end() && pending->second == snapshot)
+		{
+			m_PendingChunks.erase(pending);
+		}
+
+		m_Progress.p_Written++;
+		ReleaseSnapshot(snapshot);
+	}
+}
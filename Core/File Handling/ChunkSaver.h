@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "../Block.h"
+#include "../Utils/Defs.h"
+#include "../Utils/ThreadPool.h"
+#include "ChunkFileHandler.h"
+
+namespace Omnia
+{
+	class Chunk;
+
+	// Chunks written (or replaced by a newer copy) out of the chunks queued since the saver was last idle
+	struct ChunkSaveProgress
+	{
+		size_t p_Queued = 0;
+		size_t p_Written = 0;
+	};
+
+	/*
+	Writes chunks to their region files on a background thread so that saving never stalls a frame.
+
+	QueueChunk() is called from the main thread, it copies the blocks and the light of the chunk in to a snapshot (the buffers are 
+	pooled so a save doesn't allocate) and hands the write to the io thread. The chunk can be changed or unloaded right after.
+	Only the latest snapshot of a chunk is kept : if a chunk is queued again before its last copy was written, the old copy is skipped.
+
+	Until a snapshot is written it is the newest saved version of its chunk, ReadPendingChunk() has to be checked before reading 
+	a chunk from its region file.
+	*/
+
+	class ChunkSaver
+	{
+	public :
+
+		ChunkSaver();
+		~ChunkSaver();
+
+		ChunkSaver(const ChunkSaver&) = delete;
+		ChunkSaver& operator=(const ChunkSaver&) = delete;
+
+		// Copies the chunk and queues the write to the region file in dir. Has to be called from the main thread
+		void QueueChunk(const Chunk* chunk, const std::string& dir, const ChunkFileHandler::ChunkSaveOptions& options);
+
+		// If a copy of the chunk is still waiting to be written, loads it in to the chunk and returns true
+		bool ReadPendingChunk(Chunk* chunk);
+
+		// Blocks until every queued chunk is written. Used before the region files are closed
+		void WaitForWrites();
+
+		// Writes that are queued or running
+		size_t GetPendingCount();
+
+		ChunkSaveProgress GetProgress();
+
+		static constexpr size_t MAX_POOLED_SNAPSHOTS = 64;
+
+	private :
+
+		struct ChunkSnapshot
+		{
+			int p_X = 0;
+			int p_Z = 0;
+			std::string p_Directory;
+			ChunkFileHandler::ChunkSaveOptions p_Options;
+			std::vector<Block> p_Blocks;
+			std::vector<std::uint8_t> p_Light;
+		};
+
+		// Takes a snapshot from the pool or allocates a new one. Both have to be called with m_Mutex locked
+		std::shared_ptr<ChunkSnapshot> AllocateSnapshot();
+		void ReleaseSnapshot(std::shared_ptr<ChunkSnapshot> snapshot);
+
+		// Runs on the io thread
+		void WriteSnapshot(const std::shared_ptr<ChunkSnapshot>& snapshot);
+
+		std::mutex m_Mutex;
+		std::map<std::pair<int, int>, std::shared_ptr<ChunkSnapshot>> m_PendingChunks; // The latest queued snapshot of every chunk that isn't written yet
+		std::vector<std::shared_ptr<ChunkSnapshot>> m_SnapshotPool;
+		ChunkSaveProgress m_Progress;
+
+		// Declared last so the thread is joined before anything it uses is destroyed
+		ThreadPool m_IOThread;
+	};
+}
@@ -0,0 +1,222 @@
+#include "RegionFile.h"
+
+#include <cstddef>
+#include <algorithm>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/stat.h>
+#endif
+
+#include "../Utils/Logger.h"
+
+namespace Omnia
+{
+#ifdef _WIN32
+	static const std::intptr_t INVALID_REGION_HANDLE = reinterpret_cast<std::intptr_t>(INVALID_HANDLE_VALUE);
+#else
+	static const std::intptr_t INVALID_REGION_HANDLE = -1;
+#endif
+
+	RegionFile::RegionFile(const std::string& path, bool create) : m_Header(), m_FileSize(0), m_Handle(INVALID_REGION_HANDLE), m_IsOpen(false)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, create ? OPEN_ALWAYS : OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, NULL);
+
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		LARGE_INTEGER file_size;
+		GetFileSizeEx(file, &file_size);
+
+		m_Handle = reinterpret_cast<std::intptr_t>(file);
+		m_FileSize = static_cast<std::uint64_t>(file_size.QuadPart);
+#else
+		int file = open(path.c_str(), create ? O_RDWR | O_CREAT : O_RDWR, 0644);
+
+		if (file < 0)
+		{
+			return;
+		}
+
+		struct stat file_stat;
+		fstat(file, &file_stat);
+
+		m_Handle = file;
+		m_FileSize = static_cast<std::uint64_t>(file_stat.st_size);
+#endif
+
+		// A new file, write an empty header
+		if (m_FileSize == 0)
+		{
+			m_Header.p_Magic = REGION_MAGIC;
+			m_Header.p_Version = REGION_VERSION;
+			m_IsOpen = WriteAt(0, &m_Header, sizeof(RegionHeader));
+			m_FileSize = sizeof(RegionHeader);
+
+			return;
+		}
+
+		if (m_FileSize < sizeof(RegionHeader) || !ReadAt(0, &m_Header, sizeof(RegionHeader)) ||
+			m_Header.p_Magic != REGION_MAGIC || m_Header.p_Version != REGION_VERSION)
+		{
+			Logger::LogToConsole("Invalid region file (" + path + ")");
+			return;
+		}
+
+		m_IsOpen = true;
+	}
+
+	RegionFile::~RegionFile()
+	{
+		if (m_Handle == INVALID_REGION_HANDLE)
+		{
+			return;
+		}
+
+#ifdef _WIN32
+		CloseHandle(reinterpret_cast<HANDLE>(m_Handle));
+#else
+		close(static_cast<int>(m_Handle));
+#endif
+	}
+
+	bool RegionFile::HasChunk(int local_x, int local_z) const noexcept
+	{
+		return m_Header.p_Entries[local_x * REGION_SIZE + local_z].p_Offset != 0;
+	}
+
+	bool RegionFile::ReadChunk(int local_x, int local_z, std::vector<std::uint8_t>& payload)
+	{
+		const ChunkEntry& entry = m_Header.p_Entries[local_x * REGION_SIZE + local_z];
+
+		if (!m_IsOpen || entry.p_Offset == 0)
+		{
+			return false;
+		}
+
+		payload.resize(entry.p_Size);
+		return ReadAt(entry.p_Offset, payload.data(), entry.p_Size);
+	}
+
+	bool RegionFile::WriteChunk(int local_x, int local_z, const std::uint8_t* payload, std::uint32_t size)
+	{
+		const int entry_index = local_x * REGION_SIZE + local_z;
+		ChunkEntry entry = m_Header.p_Entries[entry_index];
+
+		if (!m_IsOpen)
+		{
+			return false;
+		}
+
+		// Doesn't fit in the old place, move it to the end of the file. The old space is left unused
+		if (entry.p_Offset == 0 || size > entry.p_Capacity)
+		{
+			entry.p_Offset = static_cast<std::uint32_t>(m_FileSize);
+			entry.p_Capacity = ((size + size / 4) + PAYLOAD_ALIGNMENT - 1) / PAYLOAD_ALIGNMENT * PAYLOAD_ALIGNMENT;
+		}
+
+		entry.p_Size = size;
+
+		// The payload is written before the table entry that points to it
+		if (!WriteAt(entry.p_Offset, payload, size))
+		{
+			return false;
+		}
+
+		if (!WriteAt(offsetof(RegionHeader, p_Entries) + entry_index * sizeof(ChunkEntry), &entry, sizeof(ChunkEntry)))
+		{
+			return false;
+		}
+
+		m_Header.p_Entries[entry_index] = entry;
+		m_FileSize = std::max(m_FileSize, static_cast<std::uint64_t>(entry.p_Offset) + entry.p_Capacity);
+
+		return true;
+	}
+
+	void RegionFile::GetChunks(std::vector<std::pair<int, int>>& chunks) const
+	{
+		for (int x = 0; x < REGION_SIZE; x++)
+		{
+			for (int z = 0; z < REGION_SIZE; z++)
+			{
+				if (HasChunk(x, z))
+				{
+					chunks.push_back({ x, z });
+				}
+			}
+		}
+	}
+
+	bool RegionFile::ReadAt(std::uint64_t offset, void* data, std::uint32_t size)
+	{
+#ifdef _WIN32
+		// ReadFile with an offset in the OVERLAPPED structure is a positional read on a synchronous handle
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+		DWORD bytes_read = 0;
+		return ReadFile(reinterpret_cast<HANDLE>(m_Handle), data, size, &bytes_read, &overlapped) && bytes_read == size;
+#else
+		std::uint8_t* bytes = static_cast<std::uint8_t*>(data);
+
+		while (size > 0)
+		{
+			ssize_t bytes_read = pread(static_cast<int>(m_Handle), bytes, size, static_cast<off_t>(offset));
+
+			if (bytes_read <= 0)
+			{
+				return false;
+			}
+
+			bytes += bytes_read;
+			offset += bytes_read;
+			size -= static_cast<std::uint32_t>(bytes_read);
+		}
+
+		return true;
+#endif
+	}
+
+	bool RegionFile::WriteAt(std::uint64_t offset, const void* data, std::uint32_t size)
+	{
+#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+		DWORD bytes_written = 0;
+		return WriteFile(reinterpret_cast<HANDLE>(m_Handle), data, size, &bytes_written, &overlapped) && bytes_written == size;
+#else
+		const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+
+		while (size > 0)
+		{
+			ssize_t bytes_written = pwrite(static_cast<int>(m_Handle), bytes, size, static_cast<off_t>(offset));
+
+			if (bytes_written <= 0)
+			{
+				return false;
+			}
+
+			bytes += bytes_written;
+			offset += bytes_written;
+			size -= static_cast<std::uint32_t>(bytes_written);
+		}
+
+		return true;
+#endif
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace Omnia
+{
+	/*
+	A file that holds the saved chunks of a REGION_SIZE x REGION_SIZE area of the world.
+
+	The file starts with a header : a magic number, a version and a table with one entry (offset, size, capacity) per chunk of the region.
+	The payload of a chunk is stored at its offset, a chunk that is written again stays in place if the new payload fits in its capacity
+	and is moved to the end of the file otherwise. The capacity is rounded up so that small edits usually fit.
+
+	The header is kept in memory while the file is open, reads and writes use positional io (pread/pwrite, ReadFile/WriteFile with an offset)
+	so nothing has to seek and the payloads are read straight in to the buffer.
+	*/
+
+	class RegionFile
+	{
+	public :
+
+		static constexpr int REGION_SIZE = 32;
+		static constexpr int CHUNKS_PER_REGION = REGION_SIZE * REGION_SIZE;
+
+		// Opens the file, it is created if create is true and it doesn't exist. Check IsOpen()
+		RegionFile(const std::string& path, bool create);
+		~RegionFile();
+
+		RegionFile(const RegionFile&) = delete;
+		RegionFile& operator=(const RegionFile&) = delete;
+
+		inline bool IsOpen() const noexcept { return m_IsOpen; }
+
+		// The local coordinates are in [0, REGION_SIZE)
+		bool HasChunk(int local_x, int local_z) const noexcept;
+		bool ReadChunk(int local_x, int local_z, std::vector<std::uint8_t>& payload);
+		bool WriteChunk(int local_x, int local_z, const std::uint8_t* payload, std::uint32_t size);
+
+		// Appends the local coordinates of every chunk in the region
+		void GetChunks(std::vector<std::pair<int, int>>& chunks) const;
+
+		static inline int GetRegionCoordinate(int chunk_coordinate) noexcept
+		{
+			// Rounds towards negative infinity
+			return chunk_coordinate >= 0 ? chunk_coordinate / REGION_SIZE : (chunk_coordinate + 1) / REGION_SIZE - 1;
+		}
+
+		static inline int GetLocalCoordinate(int chunk_coordinate) noexcept
+		{
+			return chunk_coordinate - GetRegionCoordinate(chunk_coordinate) * REGION_SIZE;
+		}
+
+	private :
+
+		struct ChunkEntry
+		{
+			std::uint32_t p_Offset = 0; // 0 = the chunk isn't saved
+			std::uint32_t p_Size = 0;
+			std::uint32_t p_Capacity = 0;
+		};
+
+		struct RegionHeader
+		{
+			std::uint32_t p_Magic;
+			std::uint32_t p_Version;
+			ChunkEntry p_Entries[CHUNKS_PER_REGION];
+		};
+
+		static constexpr std::uint32_t REGION_MAGIC = 0x47524D4F; // "OMRG"
+		static constexpr std::uint32_t REGION_VERSION = 1;
+		static constexpr std::uint32_t PAYLOAD_ALIGNMENT = 512;
+
+		bool ReadAt(std::uint64_t offset, void* data, std::uint32_t size);
+		bool WriteAt(std::uint64_t offset, const void* data, std::uint32_t size);
+
+		RegionHeader m_Header;
+		std::uint64_t m_FileSize;
+		std::intptr_t m_Handle;
+		bool m_IsOpen;
+	};
+}
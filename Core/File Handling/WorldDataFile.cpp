@@ -0,0 +1,64 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "WorldDataFile.h"
+
+#include <cstdio>
+
+namespace Omnia
+{
+	namespace WorldFileHandler
+	{
+		std::string GetWorldDirectory(const std::string& world_name)
+		{
+			return "Saves/" + world_name + "/";
+		}
+
+		std::string GetChunkDirectory(const std::string& world_name)
+		{
+			return GetWorldDirectory(world_name) + "chunks/";
+		}
+
+		bool ReadWorldData(const std::string& world_name, WorldData& data)
+		{
+			FILE* world_file = fopen((GetWorldDirectory(world_name) + "world.bin").c_str(), "rb");
+
+			if (world_file == NULL)
+			{
+				return false;
+			}
+
+			const bool read = fread(&data, sizeof(WorldData), 1, world_file) == 1;
+			fclose(world_file);
+
+			return read;
+		}
+
+		bool WriteWorldData(const std::string& world_name, const WorldData& data)
+		{
+			FILE* world_file = fopen((GetWorldDirectory(world_name) + "world.bin").c_str(), "wb+");
+
+			if (world_file == NULL)
+			{
+				return false;
+			}
+
+			const bool written = fwrite(&data, sizeof(WorldData), 1, world_file) == 1;
+			fclose(world_file);
+
+			return written;
+		}
+
+		bool IsSaveCompatible(const std::string& world_name, int seed)
+		{
+			WorldData previous_save_data;
+
+			// Nothing was saved yet (the chunk directory can exist without it when chunks were unloaded before the first save)
+			if (!ReadWorldData(world_name, previous_save_data))
+			{
+				return true;
+			}
+
+			return previous_save_data.seed == seed;
+		}
+	}
+}
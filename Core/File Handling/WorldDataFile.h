@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Omnia
+{
+	namespace WorldFileHandler
+	{
+		/*
+		The contents of world.bin, the seed and the settings of a saved world.
+		Kept apart from the rest of the world file handler so that what writes a world without a World object
+		(the pregeneration tool, see Tools/WorldPregen.cpp) doesn't need the renderer
+		*/
+		struct WorldData
+		{
+			int seed;
+			int world_gen_type;
+			float sun_position;
+			std::uint8_t sun_cycle_type; // A CurrentSunCycle (see World.h)
+		};
+
+		// The directory of a world ("Saves/world_name/")
+		std::string GetWorldDirectory(const std::string& world_name);
+
+		// The directory the chunk files of a world are stored in
+		std::string GetChunkDirectory(const std::string& world_name);
+
+		// Return false if world.bin can't be opened
+		bool ReadWorldData(const std::string& world_name, WorldData& data);
+		bool WriteWorldData(const std::string& world_name, const WorldData& data);
+
+		// Returns false if another world with a different seed is already saved with the same name
+		bool IsSaveCompatible(const std::string& world_name, int seed);
+	}
+}
@@ -15,27 +15,6 @@ namespace Omnia
             glm::vec3 position;
         };
 
-        struct WorldData
-        {
-            int seed;
-            int world_gen_type;
-            float sun_position;
-            CurrentSunCycle sun_cycle_type;
-        };
-
-        // takes in a string such as "-1, 2" and outputs an std::pair<int,int>
-        std::pair<int, int> ParseChunkFilename(const std::string& str)
-        {
-            std::string x = str.substr(0, str.find(','));
-            std::string y = str.substr(str.find(',') + 1);
-
-            std::pair<int, int> ret_val;
-            ret_val.first = std::stoi(x);
-            ret_val.second = std::stoi(y);
-
-            return ret_val;
-        }
-
         bool SaveWorld(const std::string& world_name, World* world)
         {
             Timer timer("WORLD SAVE TIMER!");
@@ -43,7 +22,6 @@ namespace Omnia
             const string save_dir = "Saves/";
             stringstream cdata_dir_s; // chunk data directory
             stringstream dir_s;
-            const std::map<std::pair<int,int>, Chunk>& world_data = world->GetWorldData();
 
             dir_s << save_dir << world_name << "/";
             cdata_dir_s << save_dir << world_name << "/chunks/";
@@ -55,34 +33,21 @@ namespace Omnia
                 std::filesystem::create_directories(cdata_dir_s.str());
             }
 
-            else
+            else if (!IsSaveCompatible(world_name, world->GetSeed()))
             {
-                std::stringstream existing_world_file_s;
-                existing_world_file_s << dir_s.str() << "world.bin";
-
-                FILE* existing_world_file = fopen(existing_world_file_s.str().c_str(), "rb");
-                WorldData previous_save_data;
-
-                fread(&previous_save_data, sizeof(WorldData), 1, existing_world_file);
-                fclose(existing_world_file);
-
-                if (previous_save_data.seed != world->GetSeed())
-                {
-                    Logger::LogToConsole("There is another incompatible world with the same name! World cannot be saved!");
-                    return false;
-                }
+                Logger::LogToConsole("There is another incompatible world with the same name! World cannot be saved!");
+                return false;
             }
 
-            // Write the chunks
-            for (auto e = world_data.begin() ; e != world_data.end() ; e++)
+            else if (!std::filesystem::exists(cdata_dir_s.str()))
             {
-                if (e->second.p_ChunkState == ChunkState::Changed ||
-                    e->second.p_LightMapState == ChunkLightMapState::ModifiedLightMap)
-                {
-                    ChunkFileHandler::WriteChunk((Chunk*)&e->second, cdata_dir_s.str());
-                }
+                std::filesystem::create_directories(cdata_dir_s.str());
             }
 
+            // The changed chunks are copied and written in the background by the chunk saver of the world (see ChunkSaver.h),
+            // the world waits for the writes before it is destroyed
+            world->QueueChangedChunks(cdata_dir_s.str());
+
             // Writing the player data
             PlayerData player_data = { world->p_Player->p_Camera, world->p_Player->p_Position };
 
@@ -102,22 +67,14 @@ namespace Omnia
             fclose(player_data_file);
 
             // A file that has the seed of the world etc..
-            FILE* world_data_file;
             WorldData world_data_w = { world->GetSeed(), world->GetWorldGenerationType(), world->GetSunPositionY(), world->GetSunCycleType() }; // the world data to write in the world.bin file
-            stringstream world_data_file_pth;
-
-            world_data_file_pth << dir_s.str() << "world.bin";
-            world_data_file = fopen(world_data_file_pth.str().c_str(), "wb+");
 
-            if (!world_data_file)
+            if (!WriteWorldData(world_name, world_data_w))
             {
                 Logger::LogToConsole("WORLD SAVING ERROR!   |   UNABLE TO OPEN WORLD DATA FILE TO WRITE!");
                 return false;
             }
 
-            fwrite(&world_data_w, sizeof(WorldData), 1, world_data_file);
-            fclose(world_data_file);
-
             return true;
         }
 
@@ -125,7 +82,6 @@ namespace Omnia
         {
             stringstream cdata_dir_s; // chunk data directory
             stringstream player_file_pth;
-            stringstream world_file_pth;
             stringstream dir_s; // world directory
 
             const string save_dir = "Saves/";
@@ -133,30 +89,20 @@ namespace Omnia
             dir_s << save_dir << world_name << "/";
             cdata_dir_s << save_dir << world_name << "/chunks/";
             player_file_pth << dir_s.str() << "player.bin";
-            world_file_pth << dir_s.str() << "world.bin";
 
-            FILE* world_file = fopen(world_file_pth.str().c_str(), "rb");
+            WorldData world_data;
             
-            if (std::filesystem::is_directory(dir_s.str()) && std::filesystem::is_directory(cdata_dir_s.str()) && world_file_pth)
+            if (std::filesystem::is_directory(dir_s.str()) && std::filesystem::is_directory(cdata_dir_s.str()) && ReadWorldData(world_name, world_data))
             {
-                WorldData world_data;
-                fread(&world_data, sizeof(WorldData), 1, world_file);
-                fclose(world_file);
-
                 World* world = new World(world_data.seed, {DEFAULT_WINDOW_X, DEFAULT_WINDOW_Y}, world_name, (WorldGenerationType)world_data.world_gen_type);
                 
                 if (world)
                 {
                     world->SetSunPositionY(world_data.sun_position);
-                    world->SetSunCycleType(world_data.sun_cycle_type);
+                    world->SetSunCycleType(static_cast<CurrentSunCycle>(world_data.sun_cycle_type));
 
-                    // iterate through all the files in the chunk directory and read the binary data  
-                    for (auto entry : std::filesystem::directory_iterator(cdata_dir_s.str()))
-                    {
-                        std::pair<int, int> chunk_loc = ParseChunkFilename(entry.path().filename().string());
-                        Chunk* chunk = world->EmplaceChunkInMap(chunk_loc.first, chunk_loc.second);
-                        ChunkFileHandler::ReadChunk(chunk, entry.path().string());
-                    }
+                    // No chunks are read here. The world reads the saved chunks around the player from the region files
+                    // when it streams them in (World::_ReadUnloadedChunk()), so loading doesn't depend on the size of the save
 
                     // set the player data
 
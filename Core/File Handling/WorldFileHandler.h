@@ -1,8 +1,9 @@
 #pragma once
 
+#include "../World/World.h"
 #include "ChunkFileHandler.h"
+#include "WorldDataFile.h"
 #include "../Application/Events.h"
-#include "../World/World.h"
 
 #include <iostream>
 #include <string>
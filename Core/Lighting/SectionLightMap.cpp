@@ -0,0 +1,73 @@
+#include "SectionLightMap.h"
+
+#include <cstring>
+
+namespace Omnia
+{
+	void SectionLightMap::Set(int x, int y, int z, std::uint8_t value)
+	{
+		if (!m_Values)
+		{
+			if (value == m_UniformValue)
+			{
+				return;
+			}
+
+			m_Values = std::make_unique<std::array<std::uint8_t, VOLUME>>();
+			m_Values->fill(m_UniformValue);
+		}
+
+		(*m_Values)[GetIndex(x, y, z)] = value;
+	}
+
+	void SectionLightMap::Fill(std::uint8_t value)
+	{
+		m_Values.reset();
+		m_UniformValue = value;
+	}
+
+	void SectionLightMap::GetRow(int x, int y, std::uint8_t* out) const
+	{
+		if (m_Values)
+		{
+			memcpy(out, &(*m_Values)[GetIndex(x, y, 0)], SIZE_Z);
+		}
+
+		else
+		{
+			memset(out, m_UniformValue, SIZE_Z);
+		}
+	}
+
+	void SectionLightMap::Encode(const std::uint8_t* values)
+	{
+		for (int i = 1; i < VOLUME; i++)
+		{
+			if (values[i] != values[0])
+			{
+				if (!m_Values)
+				{
+					m_Values = std::make_unique<std::array<std::uint8_t, VOLUME>>();
+				}
+
+				memcpy(m_Values->data(), values, VOLUME);
+				return;
+			}
+		}
+
+		Fill(values[0]);
+	}
+
+	void SectionLightMap::Decode(std::uint8_t* values) const
+	{
+		if (m_Values)
+		{
+			memcpy(values, m_Values->data(), VOLUME);
+		}
+
+		else
+		{
+			memset(values, m_UniformValue, VOLUME);
+		}
+	}
+}
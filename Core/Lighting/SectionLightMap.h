@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <array>
+
+#include "../Utils/Defs.h"
+
+namespace Omnia
+{
+	/*
+	The torch light values of one 16x16x16 chunk section. Most sections never see a lamp, so the light starts out uniform
+	(one value for the whole section, nothing allocated) and the full array is only allocated on the first write of a different value.
+	The sky light of a section is stored the same way, only the sections around the surface aren't uniform.
+	Same x, y, z order as PaletteBlockStorage
+	*/
+
+	class SectionLightMap
+	{
+	public :
+
+		static constexpr int SIZE_X = CHUNK_SIZE_X;
+		static constexpr int SIZE_Y = CHUNK_SECTION_SIZE_Y;
+		static constexpr int SIZE_Z = CHUNK_SIZE_Z;
+		static constexpr int VOLUME = SIZE_X * SIZE_Y * SIZE_Z;
+
+		inline std::uint8_t Get(int x, int y, int z) const noexcept
+		{
+			return m_Values ? (*m_Values)[GetIndex(x, y, z)] : m_UniformValue;
+		}
+
+		void Set(int x, int y, int z, std::uint8_t value);
+
+		// Sets every value and frees the array
+		void Fill(std::uint8_t value);
+
+		// Writes the SIZE_Z values of the row at (x, y) to out
+		void GetRow(int x, int y, std::uint8_t* out) const;
+
+		// Converts from and to plain arrays of VOLUME values. Encode() keeps the section uniform if every value is the same
+		void Encode(const std::uint8_t* values);
+		void Decode(std::uint8_t* values) const;
+
+		inline bool IsUniform() const noexcept { return !m_Values; }
+
+		// Only valid if the section is uniform
+		inline std::uint8_t GetUniformValue() const noexcept { return m_UniformValue; }
+
+		inline size_t GetMemoryUsage() const noexcept { return m_Values ? sizeof(*m_Values) : 0; }
+
+	private :
+
+		static inline int GetIndex(int x, int y, int z) noexcept
+		{
+			return (x * SIZE_Y + y) * SIZE_Z + z;
+		}
+
+		std::unique_ptr<std::array<std::uint8_t, VOLUME>> m_Values; // nullptr = uniform
+		std::uint8_t m_UniformValue = 0;
+	};
+}
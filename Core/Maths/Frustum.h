@@ -10,6 +10,11 @@ namespace Omnia
 {
     struct FrustumAABB 
     {
+        FrustumAABB() : p_Dimensions(0.0f), p_Position(0.0f)
+        {
+
+        }
+
         FrustumAABB(const glm::vec3& dimensions, const glm::vec3& position)
             : p_Dimensions(dimensions), p_Position(position)
         {
@@ -59,8 +64,8 @@ namespace Omnia
             return res;
         }
 
-        const glm::vec3 p_Dimensions;
-        const glm::vec3 p_Position;
+        glm::vec3 p_Dimensions;
+        glm::vec3 p_Position;
     };
 
     struct Plane 
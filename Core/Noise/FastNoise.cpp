@@ -30,9 +30,26 @@
 
 #include <math.h>
 #include <assert.h>
+#include <string.h>
 
 #include <algorithm>
 #include <random>
+#include <vector>
+
+// The grid functions evaluate simplex noise several points at a time with the widest instruction set the compiler targets.
+// Define FN_NO_SIMD to always use the scalar functions
+#if !defined(FN_USE_DOUBLES) && !defined(FN_NO_SIMD)
+#if defined(__AVX2__)
+#define FN_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FN_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define FN_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#endif
 
 const FN_DECIMAL GRAD_X[] =
 {
@@ -184,6 +201,9 @@ const FN_DECIMAL CELL_3D_Z[] =
 static int FastFloor(FN_DECIMAL f) { return (f >= 0 ? (int)f : (int)f - 1); }
 static int FastRound(FN_DECIMAL f) { return (f >= 0) ? (int)(f + FN_DECIMAL(0.5)) : (int)(f - FN_DECIMAL(0.5)); }
 static int FastAbs(int i) { return abs(i); }
+
+// The first int of the float's bits, copied out rather than read through a pointer cast so it doesn't break strict aliasing
+static int FloatBits(FN_DECIMAL f) { int i; memcpy(&i, &f, sizeof(i)); return i; }
 static FN_DECIMAL FastAbs(FN_DECIMAL f) { return fabs(f); }
 static FN_DECIMAL Lerp(FN_DECIMAL a, FN_DECIMAL b, FN_DECIMAL t) { return a + t * (b - a); }
 static FN_DECIMAL InterpHermiteFunc(FN_DECIMAL t) { return t*t*(3 - 2 * t); }
@@ -482,25 +502,25 @@ FN_DECIMAL FastNoise::GetNoise(FN_DECIMAL x, FN_DECIMAL y) const
 FN_DECIMAL FastNoise::GetWhiteNoise(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, FN_DECIMAL w) const
 {
 	return ValCoord4D(m_seed,
-		*reinterpret_cast<int*>(&x) ^ (*reinterpret_cast<int*>(&x) >> 16),
-		*reinterpret_cast<int*>(&y) ^ (*reinterpret_cast<int*>(&y) >> 16),
-		*reinterpret_cast<int*>(&z) ^ (*reinterpret_cast<int*>(&z) >> 16),
-		*reinterpret_cast<int*>(&w) ^ (*reinterpret_cast<int*>(&w) >> 16));
+		FloatBits(x) ^ (FloatBits(x) >> 16),
+		FloatBits(y) ^ (FloatBits(y) >> 16),
+		FloatBits(z) ^ (FloatBits(z) >> 16),
+		FloatBits(w) ^ (FloatBits(w) >> 16));
 }
 
 FN_DECIMAL FastNoise::GetWhiteNoise(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const
 {
 	return ValCoord3D(m_seed,
-		*reinterpret_cast<int*>(&x) ^ (*reinterpret_cast<int*>(&x) >> 16),
-		*reinterpret_cast<int*>(&y) ^ (*reinterpret_cast<int*>(&y) >> 16),
-		*reinterpret_cast<int*>(&z) ^ (*reinterpret_cast<int*>(&z) >> 16));
+		FloatBits(x) ^ (FloatBits(x) >> 16),
+		FloatBits(y) ^ (FloatBits(y) >> 16),
+		FloatBits(z) ^ (FloatBits(z) >> 16));
 }
 
 FN_DECIMAL FastNoise::GetWhiteNoise(FN_DECIMAL x, FN_DECIMAL y) const
 {
 	return ValCoord2D(m_seed,
-		*reinterpret_cast<int*>(&x) ^ (*reinterpret_cast<int*>(&x) >> 16),
-		*reinterpret_cast<int*>(&y) ^ (*reinterpret_cast<int*>(&y) >> 16));
+		FloatBits(x) ^ (FloatBits(x) >> 16),
+		FloatBits(y) ^ (FloatBits(y) >> 16));
 }
 
 FN_DECIMAL FastNoise::GetWhiteNoiseInt(int x, int y, int z, int w) const
@@ -2248,3 +2268,437 @@ void FastNoise::SingleGradientPerturb(unsigned char offset, FN_DECIMAL warpAmp,
 	x += Lerp(lx0x, lx1x, ys) * warpAmp;
 	y += Lerp(ly0x, ly1x, ys) * warpAmp;
 }
+
+// Grids
+#if defined(FN_SIMD_AVX2) || defined(FN_SIMD_SSE2) || defined(FN_SIMD_NEON)
+#define FN_SIMD
+
+// The vector operations used by the grid functions. Comparisons return a mask with every bit set in the lanes where they are true
+#if defined(FN_SIMD_AVX2)
+struct FNLanes
+{
+	static const int SIZE = 8;
+	typedef __m256 Float;
+	typedef __m256i Int;
+
+	static Float Set(FN_DECIMAL a) { return _mm256_set1_ps(a); }
+	static Float Load(const FN_DECIMAL* a) { return _mm256_loadu_ps(a); }
+	static void Store(FN_DECIMAL* a, Float v) { _mm256_storeu_ps(a, v); }
+
+	static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+	static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+	static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+	static Float Abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+	static Float Greater(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static Float GreaterEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static Float Less(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+
+	static Float And(Float a, Float b) { return _mm256_and_ps(a, b); }
+	static Float Or(Float a, Float b) { return _mm256_or_ps(a, b); }
+	static Float Not(Float a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+	static Float AndNot(Float mask, Float a) { return _mm256_andnot_ps(mask, a); } // a where the mask isn't set
+
+	static Int SetInt(int a) { return _mm256_set1_epi32(a); }
+	static void StoreInt(int* a, Int v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(a), v); }
+	static Int AddInt(Int a, Int b) { return _mm256_add_epi32(a, b); }
+	static Int AddMask(Int a, Float mask) { return _mm256_sub_epi32(a, _mm256_castps_si256(mask)); } // a + 1 where the mask is set
+	static Float ToFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+
+	// Same as FastFloor() : truncates and subtracts 1 from negative values
+	static Int FastFloor(Float a) { return _mm256_add_epi32(_mm256_cvttps_epi32(a), _mm256_castps_si256(Less(a, _mm256_setzero_ps()))); }
+};
+#elif defined(FN_SIMD_SSE2)
+struct FNLanes
+{
+	static const int SIZE = 4;
+	typedef __m128 Float;
+	typedef __m128i Int;
+
+	static Float Set(FN_DECIMAL a) { return _mm_set1_ps(a); }
+	static Float Load(const FN_DECIMAL* a) { return _mm_loadu_ps(a); }
+	static void Store(FN_DECIMAL* a, Float v) { _mm_storeu_ps(a, v); }
+
+	static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+	static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+	static Float Abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+	static Float Greater(Float a, Float b) { return _mm_cmpgt_ps(a, b); }
+	static Float GreaterEqual(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+	static Float Less(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+
+	static Float And(Float a, Float b) { return _mm_and_ps(a, b); }
+	static Float Or(Float a, Float b) { return _mm_or_ps(a, b); }
+	static Float Not(Float a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+	static Float AndNot(Float mask, Float a) { return _mm_andnot_ps(mask, a); } // a where the mask isn't set
+
+	static Int SetInt(int a) { return _mm_set1_epi32(a); }
+	static void StoreInt(int* a, Int v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(a), v); }
+	static Int AddInt(Int a, Int b) { return _mm_add_epi32(a, b); }
+	static Int AddMask(Int a, Float mask) { return _mm_sub_epi32(a, _mm_castps_si128(mask)); } // a + 1 where the mask is set
+	static Float ToFloat(Int a) { return _mm_cvtepi32_ps(a); }
+
+	// Same as FastFloor() : truncates and subtracts 1 from negative values
+	static Int FastFloor(Float a) { return _mm_add_epi32(_mm_cvttps_epi32(a), _mm_castps_si128(Less(a, _mm_setzero_ps()))); }
+};
+#elif defined(FN_SIMD_NEON)
+struct FNLanes
+{
+	static const int SIZE = 4;
+	typedef float32x4_t Float;
+	typedef int32x4_t Int;
+
+	static Float Set(FN_DECIMAL a) { return vdupq_n_f32(a); }
+	static Float Load(const FN_DECIMAL* a) { return vld1q_f32(a); }
+	static void Store(FN_DECIMAL* a, Float v) { vst1q_f32(a, v); }
+
+	static Float Add(Float a, Float b) { return vaddq_f32(a, b); }
+	static Float Sub(Float a, Float b) { return vsubq_f32(a, b); }
+	static Float Mul(Float a, Float b) { return vmulq_f32(a, b); }
+	static Float Abs(Float a) { return vabsq_f32(a); }
+
+	static Float Greater(Float a, Float b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+	static Float GreaterEqual(Float a, Float b) { return vreinterpretq_f32_u32(vcgeq_f32(a, b)); }
+	static Float Less(Float a, Float b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+
+	static Float And(Float a, Float b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+	static Float Or(Float a, Float b) { return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+	static Float Not(Float a) { return vreinterpretq_f32_u32(vmvnq_u32(vreinterpretq_u32_f32(a))); }
+	static Float AndNot(Float mask, Float a) { return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(mask))); } // a where the mask isn't set
+
+	static Int SetInt(int a) { return vdupq_n_s32(a); }
+	static void StoreInt(int* a, Int v) { vst1q_s32(a, v); }
+	static Int AddInt(Int a, Int b) { return vaddq_s32(a, b); }
+	static Int AddMask(Int a, Float mask) { return vsubq_s32(a, vreinterpretq_s32_f32(mask)); } // a + 1 where the mask is set
+	static Float ToFloat(Int a) { return vcvtq_f32_s32(a); }
+
+	// Same as FastFloor() : truncates and subtracts 1 from negative values
+	static Int FastFloor(Float a) { return vaddq_s32(vcvtq_s32_f32(a), vreinterpretq_s32_u32(vcltq_f32(a, vdupq_n_f32(0)))); }
+};
+#endif
+
+// The settings of the noise that the grid functions need
+struct FNLanesSimplex
+{
+	const unsigned char* perm;
+	const unsigned char* perm12;
+	bool fractal;
+	FastNoise::FractalType fractalType;
+	int octaves;
+	FN_DECIMAL lacunarity;
+	FN_DECIMAL gain;
+	FN_DECIMAL fractalBounding;
+};
+
+// The permutation tables can't be read with vector instructions, the gradient of each lane is looked up on its own
+static FNLanes::Float GradCoordLanes2D(const FNLanesSimplex& simplex, unsigned char offset, FNLanes::Int x, FNLanes::Int y,
+	FNLanes::Float xd, FNLanes::Float yd)
+{
+	int xi[FNLanes::SIZE], yi[FNLanes::SIZE];
+	FN_DECIMAL gradX[FNLanes::SIZE], gradY[FNLanes::SIZE];
+
+	FNLanes::StoreInt(xi, x);
+	FNLanes::StoreInt(yi, y);
+
+	for (int l = 0; l < FNLanes::SIZE; l++)
+	{
+		unsigned char lutPos = simplex.perm12[(xi[l] & 0xff) + simplex.perm[(yi[l] & 0xff) + offset]];
+
+		gradX[l] = GRAD_X[lutPos];
+		gradY[l] = GRAD_Y[lutPos];
+	}
+
+	return FNLanes::Add(FNLanes::Mul(xd, FNLanes::Load(gradX)), FNLanes::Mul(yd, FNLanes::Load(gradY)));
+}
+
+static FNLanes::Float GradCoordLanes3D(const FNLanesSimplex& simplex, unsigned char offset, FNLanes::Int x, FNLanes::Int y, FNLanes::Int z,
+	FNLanes::Float xd, FNLanes::Float yd, FNLanes::Float zd)
+{
+	int xi[FNLanes::SIZE], yi[FNLanes::SIZE], zi[FNLanes::SIZE];
+	FN_DECIMAL gradX[FNLanes::SIZE], gradY[FNLanes::SIZE], gradZ[FNLanes::SIZE];
+
+	FNLanes::StoreInt(xi, x);
+	FNLanes::StoreInt(yi, y);
+	FNLanes::StoreInt(zi, z);
+
+	for (int l = 0; l < FNLanes::SIZE; l++)
+	{
+		unsigned char lutPos = simplex.perm12[(xi[l] & 0xff) + simplex.perm[(yi[l] & 0xff) + simplex.perm[(zi[l] & 0xff) + offset]]];
+
+		gradX[l] = GRAD_X[lutPos];
+		gradY[l] = GRAD_Y[lutPos];
+		gradZ[l] = GRAD_Z[lutPos];
+	}
+
+	return FNLanes::Add(FNLanes::Add(FNLanes::Mul(xd, FNLanes::Load(gradX)), FNLanes::Mul(yd, FNLanes::Load(gradY))),
+		FNLanes::Mul(zd, FNLanes::Load(gradZ)));
+}
+
+// The contribution of one simplex corner, t * t * t * t * grad or 0 when t is negative
+static FNLanes::Float SimplexCornerLanes(FNLanes::Float t, FNLanes::Float grad)
+{
+	FNLanes::Float outside = FNLanes::Less(t, FNLanes::Set(0));
+
+	t = FNLanes::Mul(t, t);
+	return FNLanes::AndNot(outside, FNLanes::Mul(FNLanes::Mul(t, t), grad));
+}
+
+// SingleSimplex() for a vector of points, every operation is done in the same order so the results are the same
+static FNLanes::Float SimplexLanes2D(const FNLanesSimplex& simplex, unsigned char offset, FNLanes::Float x, FNLanes::Float y)
+{
+	typedef FNLanes L;
+
+	L::Float t = L::Mul(L::Add(x, y), L::Set(F2));
+	L::Int i = L::FastFloor(L::Add(x, t));
+	L::Int j = L::FastFloor(L::Add(y, t));
+
+	t = L::Mul(L::ToFloat(L::AddInt(i, j)), L::Set(G2));
+	L::Float x0 = L::Sub(x, L::Sub(L::ToFloat(i), t));
+	L::Float y0 = L::Sub(y, L::Sub(L::ToFloat(j), t));
+
+	// i1 = 1, j1 = 0 where x0 > y0 and i1 = 0, j1 = 1 everywhere else
+	L::Float upper = L::Greater(x0, y0);
+	L::Float one = L::Set(1);
+
+	L::Float x1 = L::Add(L::Sub(x0, L::And(upper, one)), L::Set(G2));
+	L::Float y1 = L::Add(L::Sub(y0, L::AndNot(upper, one)), L::Set(G2));
+	L::Float x2 = L::Add(L::Sub(x0, one), L::Set(2 * G2));
+	L::Float y2 = L::Add(L::Sub(y0, one), L::Set(2 * G2));
+
+	L::Float half = L::Set(FN_DECIMAL(0.5));
+	L::Int intOne = L::SetInt(1);
+
+	L::Float n0 = SimplexCornerLanes(L::Sub(L::Sub(half, L::Mul(x0, x0)), L::Mul(y0, y0)),
+		GradCoordLanes2D(simplex, offset, i, j, x0, y0));
+
+	L::Float n1 = SimplexCornerLanes(L::Sub(L::Sub(half, L::Mul(x1, x1)), L::Mul(y1, y1)),
+		GradCoordLanes2D(simplex, offset, L::AddMask(i, upper), L::AddMask(j, L::Not(upper)), x1, y1));
+
+	L::Float n2 = SimplexCornerLanes(L::Sub(L::Sub(half, L::Mul(x2, x2)), L::Mul(y2, y2)),
+		GradCoordLanes2D(simplex, offset, L::AddInt(i, intOne), L::AddInt(j, intOne), x2, y2));
+
+	return L::Mul(L::Set(70), L::Add(L::Add(n0, n1), n2));
+}
+
+static FNLanes::Float SimplexLanes3D(const FNLanesSimplex& simplex, unsigned char offset, FNLanes::Float x, FNLanes::Float y, FNLanes::Float z)
+{
+	typedef FNLanes L;
+
+	L::Float t = L::Mul(L::Add(L::Add(x, y), z), L::Set(F3));
+	L::Int i = L::FastFloor(L::Add(x, t));
+	L::Int j = L::FastFloor(L::Add(y, t));
+	L::Int k = L::FastFloor(L::Add(z, t));
+
+	t = L::Mul(L::ToFloat(L::AddInt(L::AddInt(i, j), k)), L::Set(G3));
+	L::Float x0 = L::Sub(x, L::Sub(L::ToFloat(i), t));
+	L::Float y0 = L::Sub(y, L::Sub(L::ToFloat(j), t));
+	L::Float z0 = L::Sub(z, L::Sub(L::ToFloat(k), t));
+
+	// The branches of SingleSimplex() written as masks
+	L::Float xy = L::GreaterEqual(x0, y0);
+	L::Float yz = L::GreaterEqual(y0, z0);
+	L::Float xz = L::GreaterEqual(x0, z0);
+
+	L::Float i1 = L::And(xy, xz);
+	L::Float j1 = L::AndNot(xy, yz);
+	L::Float k1 = L::Not(L::Or(yz, xz));
+	L::Float i2 = L::Or(xy, xz);
+	L::Float j2 = L::Or(L::Not(xy), yz);
+	L::Float k2 = L::Not(L::And(yz, xz));
+
+	L::Float one = L::Set(1);
+
+	L::Float x1 = L::Add(L::Sub(x0, L::And(i1, one)), L::Set(G3));
+	L::Float y1 = L::Add(L::Sub(y0, L::And(j1, one)), L::Set(G3));
+	L::Float z1 = L::Add(L::Sub(z0, L::And(k1, one)), L::Set(G3));
+	L::Float x2 = L::Add(L::Sub(x0, L::And(i2, one)), L::Set(2 * G3));
+	L::Float y2 = L::Add(L::Sub(y0, L::And(j2, one)), L::Set(2 * G3));
+	L::Float z2 = L::Add(L::Sub(z0, L::And(k2, one)), L::Set(2 * G3));
+	L::Float x3 = L::Add(L::Sub(x0, one), L::Set(3 * G3));
+	L::Float y3 = L::Add(L::Sub(y0, one), L::Set(3 * G3));
+	L::Float z3 = L::Add(L::Sub(z0, one), L::Set(3 * G3));
+
+	L::Float radius = L::Set(FN_DECIMAL(0.6));
+	L::Int intOne = L::SetInt(1);
+
+	L::Float n0 = SimplexCornerLanes(L::Sub(L::Sub(L::Sub(radius, L::Mul(x0, x0)), L::Mul(y0, y0)), L::Mul(z0, z0)),
+		GradCoordLanes3D(simplex, offset, i, j, k, x0, y0, z0));
+
+	L::Float n1 = SimplexCornerLanes(L::Sub(L::Sub(L::Sub(radius, L::Mul(x1, x1)), L::Mul(y1, y1)), L::Mul(z1, z1)),
+		GradCoordLanes3D(simplex, offset, L::AddMask(i, i1), L::AddMask(j, j1), L::AddMask(k, k1), x1, y1, z1));
+
+	L::Float n2 = SimplexCornerLanes(L::Sub(L::Sub(L::Sub(radius, L::Mul(x2, x2)), L::Mul(y2, y2)), L::Mul(z2, z2)),
+		GradCoordLanes3D(simplex, offset, L::AddMask(i, i2), L::AddMask(j, j2), L::AddMask(k, k2), x2, y2, z2));
+
+	L::Float n3 = SimplexCornerLanes(L::Sub(L::Sub(L::Sub(radius, L::Mul(x3, x3)), L::Mul(y3, y3)), L::Mul(z3, z3)),
+		GradCoordLanes3D(simplex, offset, L::AddInt(i, intOne), L::AddInt(j, intOne), L::AddInt(k, intOne), x3, y3, z3));
+
+	return L::Mul(L::Set(32), L::Add(L::Add(L::Add(n0, n1), n2), n3));
+}
+
+static FNLanes::Float SimplexLanes(const FNLanesSimplex& simplex, unsigned char offset, const FNLanes::Float* p, int dimensions)
+{
+	return dimensions == 2 ? SimplexLanes2D(simplex, offset, p[0], p[1]) : SimplexLanes3D(simplex, offset, p[0], p[1], p[2]);
+}
+
+// SingleSimplex() or SingleSimplexFractal*() depending on the settings, p holds the coordinates with the frequency applied
+static FNLanes::Float SimplexFractalLanes(const FNLanesSimplex& simplex, FNLanes::Float* p, int dimensions)
+{
+	typedef FNLanes L;
+
+	if (!simplex.fractal)
+	{
+		return SimplexLanes(simplex, 0, p, dimensions);
+	}
+
+	L::Float one = L::Set(1);
+	L::Float two = L::Set(2);
+	L::Float sum = SimplexLanes(simplex, simplex.perm[0], p, dimensions);
+
+	if (simplex.fractalType == FastNoise::Billow)
+		sum = L::Sub(L::Mul(L::Abs(sum), two), one);
+	else if (simplex.fractalType == FastNoise::RigidMulti)
+		sum = L::Sub(one, L::Abs(sum));
+
+	FN_DECIMAL amp = 1;
+
+	for (int i = 1; i < simplex.octaves; i++)
+	{
+		for (int d = 0; d < dimensions; d++)
+			p[d] = L::Mul(p[d], L::Set(simplex.lacunarity));
+
+		amp *= simplex.gain;
+		L::Float octave = SimplexLanes(simplex, simplex.perm[i], p, dimensions);
+
+		switch (simplex.fractalType)
+		{
+		case FastNoise::FBM:
+			sum = L::Add(sum, L::Mul(octave, L::Set(amp)));
+			break;
+		case FastNoise::Billow:
+			sum = L::Add(sum, L::Mul(L::Sub(L::Mul(L::Abs(octave), two), one), L::Set(amp)));
+			break;
+		case FastNoise::RigidMulti:
+			sum = L::Sub(sum, L::Mul(L::Sub(one, L::Abs(octave)), L::Set(amp)));
+			break;
+		}
+	}
+
+	if (simplex.fractalType == FastNoise::RigidMulti)
+		return sum;
+
+	return L::Mul(sum, L::Set(simplex.fractalBounding));
+}
+
+static void FillSimplexLanes(const FNLanesSimplex& simplex, FN_DECIMAL frequency, FN_DECIMAL* out, const FN_DECIMAL* const* coords, int dimensions, int count)
+{
+	for (int i = 0; i < count; i += FNLanes::SIZE)
+	{
+		const int lanes = std::min(FNLanes::SIZE, count - i);
+		FNLanes::Float p[3];
+
+		for (int d = 0; d < dimensions; d++)
+		{
+			if (lanes == FNLanes::SIZE)
+			{
+				p[d] = FNLanes::Load(coords[d] + i);
+			}
+			else
+			{
+				// The last points don't fill a vector, the unused lanes repeat the last point
+				FN_DECIMAL padded[FNLanes::SIZE];
+
+				for (int l = 0; l < FNLanes::SIZE; l++)
+					padded[l] = coords[d][i + std::min(l, lanes - 1)];
+
+				p[d] = FNLanes::Load(padded);
+			}
+
+			p[d] = FNLanes::Mul(p[d], FNLanes::Set(frequency));
+		}
+
+		FN_DECIMAL result[FNLanes::SIZE];
+		FNLanes::Store(result, SimplexFractalLanes(simplex, p, dimensions));
+
+		std::copy(result, result + lanes, out + i);
+	}
+}
+#endif
+
+void FastNoise::FillNoise(FN_DECIMAL* out, const FN_DECIMAL* xs, const FN_DECIMAL* ys, int count) const
+{
+#ifdef FN_SIMD
+	if (m_noiseType == Simplex || m_noiseType == SimplexFractal)
+	{
+		const FNLanesSimplex simplex = { m_perm, m_perm12, m_noiseType == SimplexFractal, m_fractalType, m_octaves, m_lacunarity, m_gain, m_fractalBounding };
+		const FN_DECIMAL* coords[2] = { xs, ys };
+
+		FillSimplexLanes(simplex, m_frequency, out, coords, 2, count);
+		return;
+	}
+#endif
+
+	for (int i = 0; i < count; i++)
+		out[i] = GetNoise(xs[i], ys[i]);
+}
+
+void FastNoise::FillNoise(FN_DECIMAL* out, const FN_DECIMAL* xs, const FN_DECIMAL* ys, const FN_DECIMAL* zs, int count) const
+{
+#ifdef FN_SIMD
+	if (m_noiseType == Simplex || m_noiseType == SimplexFractal)
+	{
+		const FNLanesSimplex simplex = { m_perm, m_perm12, m_noiseType == SimplexFractal, m_fractalType, m_octaves, m_lacunarity, m_gain, m_fractalBounding };
+		const FN_DECIMAL* coords[3] = { xs, ys, zs };
+
+		FillSimplexLanes(simplex, m_frequency, out, coords, 3, count);
+		return;
+	}
+#endif
+
+	for (int i = 0; i < count; i++)
+		out[i] = GetNoise(xs[i], ys[i], zs[i]);
+}
+
+void FastNoise::GetNoiseGrid(FN_DECIMAL* out, int startX, int startY, int sizeX, int sizeY, int step, FN_DECIMAL scale) const
+{
+	std::vector<FN_DECIMAL> xs(sizeX * sizeY);
+	std::vector<FN_DECIMAL> ys(sizeX * sizeY);
+
+	for (int x = 0; x < sizeX; x++)
+	{
+		for (int y = 0; y < sizeY; y++)
+		{
+			xs[x * sizeY + y] = FN_DECIMAL(startX + x * step) * scale;
+			ys[x * sizeY + y] = FN_DECIMAL(startY + y * step) * scale;
+		}
+	}
+
+	FillNoise(out, xs.data(), ys.data(), sizeX * sizeY);
+}
+
+void FastNoise::GetNoiseGrid(FN_DECIMAL* out, int startX, int startY, int startZ, int sizeX, int sizeY, int sizeZ, int stepX, int stepY, int stepZ) const
+{
+	const int count = sizeX * sizeY * sizeZ;
+
+	std::vector<FN_DECIMAL> xs(count);
+	std::vector<FN_DECIMAL> ys(count);
+	std::vector<FN_DECIMAL> zs(count);
+
+	for (int x = 0; x < sizeX; x++)
+	{
+		for (int y = 0; y < sizeY; y++)
+		{
+			for (int z = 0; z < sizeZ; z++)
+			{
+				const int index = (x * sizeY + y) * sizeZ + z;
+
+				xs[index] = FN_DECIMAL(startX + x * stepX);
+				ys[index] = FN_DECIMAL(startY + y * stepY);
+				zs[index] = FN_DECIMAL(startZ + z * stepZ);
+			}
+		}
+	}
+
+	FillNoise(out, xs.data(), ys.data(), zs.data(), count);
+}
@@ -213,6 +213,17 @@ public:
 	FN_DECIMAL GetWhiteNoise(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, FN_DECIMAL w) const;
 	FN_DECIMAL GetWhiteNoiseInt(int x, int y, int z, int w) const;
 
+	//Grids
+	// Fills out with GetNoise((startX + x * step) * scale, (startY + y * step) * scale) for x in [0, sizeX), y in [0, sizeY)
+	// The values are stored as out[x * sizeY + y]
+	// Simplex and SimplexFractal are evaluated several points at a time with SSE2, AVX2 or NEON when the compiler targets them,
+	// the results are the same as GetNoise(). Every other noise type (and builds without SIMD) call GetNoise() for each point
+	void GetNoiseGrid(FN_DECIMAL* out, int startX, int startY, int sizeX, int sizeY, int step = 1, FN_DECIMAL scale = 1) const;
+
+	// Fills out with GetNoise(startX + x * stepX, startY + y * stepY, startZ + z * stepZ), stored as out[(x * sizeY + y) * sizeZ + z]
+	void GetNoiseGrid(FN_DECIMAL* out, int startX, int startY, int startZ, int sizeX, int sizeY, int sizeZ,
+		int stepX = 1, int stepY = 1, int stepZ = 1) const;
+
 private:
 	unsigned char m_perm[512];
 	unsigned char m_perm12[512];
@@ -295,6 +306,11 @@ private:
 	//4D
 	FN_DECIMAL SingleSimplex(unsigned char offset, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, FN_DECIMAL w) const;
 
+	//Grids
+	// Evaluates GetNoise() for count points, xs/ys/zs are the coordinates before the frequency is applied
+	void FillNoise(FN_DECIMAL* out, const FN_DECIMAL* xs, const FN_DECIMAL* ys, int count) const;
+	void FillNoise(FN_DECIMAL* out, const FN_DECIMAL* xs, const FN_DECIMAL* ys, const FN_DECIMAL* zs, int count) const;
+
 	inline unsigned char Index2D_12(unsigned char offset, int x, int y) const;
 	inline unsigned char Index3D_12(unsigned char offset, int x, int y, int z) const;
 	inline unsigned char Index4D_32(unsigned char offset, int x, int y, int z, int w) const;
@@ -8,6 +8,38 @@ namespace GLClasses
 		return pth.string();
 	}
 
+	// Inserts the defines right after the #version directive, which has to stay the first line of the shader
+	static string InsertDefines(const string& source, const vector<string>& defines)
+	{
+		if (defines.empty())
+		{
+			return source;
+		}
+
+		string define_lines;
+
+		for (const string& define : defines)
+		{
+			define_lines += "#define " + define + "\n";
+		}
+
+		size_t version_pos = source.find("#version");
+
+		if (version_pos == string::npos)
+		{
+			return define_lines + source;
+		}
+
+		size_t line_end = source.find('\n', version_pos);
+
+		if (line_end == string::npos)
+		{
+			return source + "\n" + define_lines;
+		}
+
+		return source.substr(0, line_end + 1) + define_lines + source.substr(line_end + 1);
+	}
+
 	Shader::~Shader()
 	{
 		glUseProgram(0);
@@ -26,8 +58,10 @@ namespace GLClasses
 		vs = glCreateShader(GL_VERTEX_SHADER);
 		fs = glCreateShader(GL_FRAGMENT_SHADER);
 
-		const char* vs_char = m_VertexData.c_str();
-		const char* fs_char = m_FragmentData.c_str();
+		const string vertex_data = InsertDefines(m_VertexData, m_Defines);
+		const string fragment_data = InsertDefines(m_FragmentData, m_Defines);
+		const char* vs_char = vertex_data.c_str();
+		const char* fs_char = fragment_data.c_str();
 
 		glShaderSource(vs, 1, &vs_char, 0);
 		glShaderSource(fs, 1, &fs_char, 0);
@@ -109,6 +143,11 @@ namespace GLClasses
 		m_FragmentPath = "PASSED_VIA_DATA";
 	}
 
+	void Shader::AddDefine(const string& define)
+	{
+		m_Defines.push_back(define);
+	}
+
 	GLuint Shader::GetProgramID()
 	{
 		return m_Program;
@@ -43,6 +43,9 @@ namespace GLClasses
 		void CompileShaders();
 		void CreateShaderProgramFromFile(const string vertex_pth, const string fragment_pth);
 		void CreateShaderProgramFromString(const string& vertex_data, const string& fragment_data);
+
+		// Adds a "#define" to both shaders (after the #version line). Has to be called before the shaders are compiled
+		void AddDefine(const string& define);
 		GLuint GetProgramID();
 		
 		inline void Use()
@@ -77,5 +80,6 @@ namespace GLClasses
 		string m_VertexPath;
 		string m_FragmentData;
 		string m_FragmentPath;
+		vector<string> m_Defines;
 	};
 }
@@ -27,6 +27,7 @@ namespace GLClasses
 			GLsizei stride, const GLvoid* pointer);
 
 		void VertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride, const GLvoid* pointer);
+		GLuint GetID() const { return buffer_id; }
 
 	private:
 
@@ -0,0 +1,213 @@
+#include "PaletteBlockStorage.h"
+
+#include <algorithm>
+
+namespace Omnia
+{
+	PaletteBlockStorage::PaletteBlockStorage()
+	{
+		Fill(BlockType::Air);
+	}
+
+	void PaletteBlockStorage::Set(int x, int y, int z, BlockType type)
+	{
+		if (IsUniform())
+		{
+			if (type == m_UniformType)
+			{
+				return;
+			}
+
+			// The first different block, promote the section to 1 bit indices. Every index is 0, the old type
+			m_Palette.assign(1, m_UniformType);
+			Resize(0);
+		}
+
+		int palette_index = FindInPalette(type);
+
+		if (palette_index < 0)
+		{
+			// The palette is full, repack the section. That drops the types that aren't used anymore and widens the indices if it has to
+			if (m_Palette.size() > m_IndexMask)
+			{
+				Block blocks[VOLUME];
+
+				Decode(blocks);
+				blocks[GetIndex(x, y, z)].p_BlockType = type;
+				Encode(blocks);
+
+				return;
+			}
+
+			palette_index = static_cast<int>(m_Palette.size());
+			m_Palette.push_back(type);
+		}
+
+		const std::uint32_t index = GetIndex(x, y, z);
+		const std::uint32_t shift = (index & m_IndicesPerWordMask) << m_BitsShift;
+		std::uint64_t& word = m_Data[index >> m_IndicesPerWordShift];
+
+		word = (word & ~(m_IndexMask << shift)) | (static_cast<std::uint64_t>(palette_index) << shift);
+	}
+
+	void PaletteBlockStorage::Fill(BlockType type)
+	{
+		m_UniformType = type;
+		m_Palette.clear();
+		m_Palette.shrink_to_fit();
+		m_Data.clear();
+		m_Data.shrink_to_fit();
+	}
+
+	void PaletteBlockStorage::GetRow(int x, int y, Block* out) const
+	{
+		if (IsUniform())
+		{
+			std::fill_n(out, SIZE_Z, Block{ m_UniformType });
+			return;
+		}
+
+		const std::uint32_t first = GetIndex(x, y, 0);
+		const std::uint32_t bits = 1 << m_BitsShift;
+
+		// Shift the indices out of each word instead of looking up the word again for every block
+		for (std::uint32_t z = 0; z < SIZE_Z; )
+		{
+			const std::uint32_t index = first + z;
+			const std::uint32_t in_word = index & m_IndicesPerWordMask;
+			const std::uint32_t count = std::min(SIZE_Z - z, m_IndicesPerWordMask + 1 - in_word);
+			std::uint64_t word = m_Data[index >> m_IndicesPerWordShift] >> (in_word << m_BitsShift);
+
+			for (std::uint32_t i = 0; i < count; i++, z++)
+			{
+				out[z].p_BlockType = m_Palette[word & m_IndexMask];
+				word >>= bits;
+			}
+		}
+	}
+
+	void PaletteBlockStorage::Encode(const Block* blocks)
+	{
+		std::int16_t lookup[256];
+		std::fill(std::begin(lookup), std::end(lookup), -1);
+
+		m_Palette.clear();
+
+		for (int i = 0; i < VOLUME; i++)
+		{
+			const std::uint8_t type = blocks[i].p_BlockType;
+
+			if (lookup[type] < 0)
+			{
+				lookup[type] = static_cast<std::int16_t>(m_Palette.size());
+				m_Palette.push_back(blocks[i].p_BlockType);
+			}
+		}
+
+		if (m_Palette.size() == 1)
+		{
+			Fill(m_Palette[0]);
+			return;
+		}
+
+		m_Palette.shrink_to_fit();
+
+		std::uint32_t bits_shift = 0;
+
+		while ((static_cast<size_t>(1) << (1 << bits_shift)) < m_Palette.size())
+		{
+			bits_shift++;
+		}
+
+		Resize(bits_shift);
+
+		for (std::uint32_t i = 0; i < VOLUME; i++)
+		{
+			const std::uint64_t palette_index = static_cast<std::uint64_t>(lookup[blocks[i].p_BlockType]);
+			m_Data[i >> m_IndicesPerWordShift] |= palette_index << ((i & m_IndicesPerWordMask) << m_BitsShift);
+		}
+	}
+
+	void PaletteBlockStorage::Decode(Block* blocks) const
+	{
+		if (IsUniform())
+		{
+			std::fill_n(blocks, VOLUME, Block{ m_UniformType });
+			return;
+		}
+
+		const std::uint32_t bits = 1 << m_BitsShift;
+		Block* out = blocks;
+
+		for (std::uint64_t word : m_Data)
+		{
+			for (std::uint32_t i = 0; i <= m_IndicesPerWordMask; i++)
+			{
+				(out++)->p_BlockType = m_Palette[word & m_IndexMask];
+				word >>= bits;
+			}
+		}
+	}
+
+	bool PaletteBlockStorage::IsFilledWith(BlockType type) const
+	{
+		if (IsUniform())
+		{
+			return type == m_UniformType;
+		}
+
+		const int palette_index = FindInPalette(type);
+
+		if (palette_index < 0)
+		{
+			return false;
+		}
+
+		// The palette can still hold types that were replaced, so compare the indices. Every word has to be the index repeated
+		std::uint64_t pattern = 0;
+
+		for (std::uint32_t i = 0; i <= m_IndicesPerWordMask; i++)
+		{
+			pattern |= static_cast<std::uint64_t>(palette_index) << (i << m_BitsShift);
+		}
+
+		for (std::uint64_t word : m_Data)
+		{
+			if (word != pattern)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	size_t PaletteBlockStorage::GetMemoryUsage() const
+	{
+		return m_Palette.capacity() * sizeof(BlockType) + m_Data.capacity() * sizeof(std::uint64_t);
+	}
+
+	int PaletteBlockStorage::FindInPalette(BlockType type) const noexcept
+	{
+		for (size_t i = 0; i < m_Palette.size(); i++)
+		{
+			if (m_Palette[i] == type)
+			{
+				return static_cast<int>(i);
+			}
+		}
+
+		return -1;
+	}
+
+	void PaletteBlockStorage::Resize(std::uint32_t bits_shift)
+	{
+		m_BitsShift = bits_shift;
+		m_IndicesPerWordShift = 6 - bits_shift;
+		m_IndicesPerWordMask = (1u << m_IndicesPerWordShift) - 1;
+		m_IndexMask = (static_cast<std::uint64_t>(1) << (1 << bits_shift)) - 1;
+
+		m_Data.assign(VOLUME >> m_IndicesPerWordShift, 0);
+		m_Data.shrink_to_fit();
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Block.h"
+#include "Utils/Defs.h"
+
+namespace Omnia
+{
+	/*
+	The blocks of one 16x16x16 chunk section, stored as indices in to a palette of the block types the section contains.
+	The indices are bit packed in 64 bit words with 1, 2, 4 or 8 bits per index (no index ever spans two words).
+	When a new type doesn't fit in the palette anymore the section is repacked, unused palette entries are dropped then
+	and the index width only grows if the section really holds more types than fit.
+
+	A section with a single block type (all air above the terrain, all stone deep below it) is uniform : the type is stored once
+	and nothing is allocated. It is promoted to indices on the first write of a different type.
+
+	The blocks are ordered x, y, z with z being the innermost axis, the same as the mesher snapshots, so a row along z
+	is 16 consecutive indices and can be decoded at once with GetRow()
+	*/
+
+	class PaletteBlockStorage
+	{
+	public :
+
+		static constexpr int SIZE_X = CHUNK_SIZE_X;
+		static constexpr int SIZE_Y = CHUNK_SECTION_SIZE_Y;
+		static constexpr int SIZE_Z = CHUNK_SIZE_Z;
+		static constexpr int VOLUME = SIZE_X * SIZE_Y * SIZE_Z;
+
+		// Every block is air
+		PaletteBlockStorage();
+
+		inline BlockType Get(int x, int y, int z) const noexcept
+		{
+			if (m_Data.empty())
+			{
+				return m_UniformType;
+			}
+
+			const std::uint32_t index = GetIndex(x, y, z);
+			const std::uint64_t word = m_Data[index >> m_IndicesPerWordShift];
+			const std::uint32_t shift = (index & m_IndicesPerWordMask) << m_BitsShift;
+
+			return m_Palette[(word >> shift) & m_IndexMask];
+		}
+
+		void Set(int x, int y, int z, BlockType type);
+
+		// Replaces every block with one type and makes the section uniform
+		void Fill(BlockType type);
+
+		// Writes the SIZE_Z blocks of the row at (x, y) to out
+		void GetRow(int x, int y, Block* out) const;
+
+		// Converts from and to plain arrays of VOLUME blocks. Encode() picks the smallest index width for the blocks
+		void Encode(const Block* blocks);
+		void Decode(Block* blocks) const;
+
+		// Returns true if every block of the section is of that type
+		bool IsFilledWith(BlockType type) const;
+
+		// The heap memory used by the palette and the indices, in bytes
+		size_t GetMemoryUsage() const;
+
+		inline bool IsUniform() const noexcept { return m_Data.empty(); }
+
+		// Only valid if the section is uniform
+		inline BlockType GetUniformType() const noexcept { return m_UniformType; }
+
+		// 0 for uniform sections
+		inline int GetBitsPerIndex() const noexcept { return IsUniform() ? 0 : 1 << m_BitsShift; }
+		inline size_t GetPaletteSize() const noexcept { return IsUniform() ? 1 : m_Palette.size(); }
+
+	private :
+
+		static inline std::uint32_t GetIndex(int x, int y, int z) noexcept
+		{
+			return (static_cast<std::uint32_t>(x) * SIZE_Y + static_cast<std::uint32_t>(y)) * SIZE_Z + static_cast<std::uint32_t>(z);
+		}
+
+		// Returns the palette index of a type or -1 if it isn't in the palette
+		int FindInPalette(BlockType type) const noexcept;
+
+		// Sets the index width to 1 << bits_shift bits and clears the indices
+		void Resize(std::uint32_t bits_shift);
+
+		std::vector<BlockType> m_Palette; // Empty when the section is uniform
+		std::vector<std::uint64_t> m_Data; // Empty when the section is uniform
+		BlockType m_UniformType = BlockType::Air;
+
+		std::uint32_t m_BitsShift = 0; // log2 of the bits per index
+		std::uint32_t m_IndicesPerWordShift = 6;
+		std::uint32_t m_IndicesPerWordMask = 63;
+		std::uint64_t m_IndexMask = 1;
+	};
+}
@@ -10,7 +10,7 @@
 
 namespace Omnia
 {
-	Block* GetWorldBlock(const glm::vec3& block_pos);
+	Block GetWorldBlock(const glm::vec3& block_pos);
 
 	namespace ParticleSystem
 	{
@@ -55,7 +55,7 @@ namespace Omnia
 
 				float multiplier = 1.0f;
 
-				if (GetWorldBlock(glm::floor(p_Position))->Collidable())
+				if (GetWorldBlock(glm::floor(p_Position)).Collidable())
 				{
 					p_Position = pos_before;
 					float t = 1.0f - (1.0f / (p_Lifetime - p_ElapsedTime));
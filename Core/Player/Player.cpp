@@ -221,9 +221,9 @@ namespace Omnia
 				{
 					if (j < CHUNK_SIZE_Y && j >= 0)
 					{
-						Block* block = GetWorldBlock(glm::vec3(i, j, k));
+						Block block = GetWorldBlock(glm::vec3(i, j, k));
 
-						if (block && block->Collidable())
+						if (block.Collidable())
 						{
 							if (Test3DAABBCollision(pos, player_dim, glm::vec3(i, j, k), glm::vec3(1, 1, 1)))
 							{
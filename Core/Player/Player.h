@@ -11,7 +11,7 @@ namespace Omnia
 {
 	class World;
 	
-	Block* GetWorldBlock(const glm::vec3& block_pos);  
+	Block GetWorldBlock(const glm::vec3& block_pos);  
 
 	class Player
 	{
@@ -8,96 +8,132 @@ namespace Omnia
 
 		m_DefaultChunkShader.CreateShaderProgramFromFile("Shaders/BlockRendererVertex.glsl", "Shaders/BlockRendererFrag.glsl");
 		m_DefaultChunkModelShader.CreateShaderProgramFromFile("Shaders/ModelRendererVertex.glsl", "Shaders/ModelRendererFrag.glsl");
+		m_PackedChunkShader.CreateShaderProgramFromFile("Shaders/BlockRendererVertex.glsl", "Shaders/BlockRendererFrag.glsl");
+		m_PackedChunkModelShader.CreateShaderProgramFromFile("Shaders/ModelRendererVertex.glsl", "Shaders/ModelRendererFrag.glsl");
+		m_PackedChunkShader.AddDefine("OMNIA_PACKED_VERTICES");
+		m_PackedChunkModelShader.AddDefine("OMNIA_PACKED_VERTICES");
 		m_DefaultChunkShader.CompileShaders();
 		m_DefaultChunkModelShader.CompileShaders();
+		m_PackedChunkShader.CompileShaders();
+		m_PackedChunkModelShader.CompileShaders();
 
 		m_BlockAtlas.CreateTexture("Resources/64x64_sheet.png");
 	}
 
-	void Renderer::RenderChunk(Chunk* chunk)
+	// The chunk meshes are destroyed before the renderer (the world declares the chunks after it), the arenas go with it while the context is alive
+	Renderer::~Renderer()
 	{
-		if (chunk->GetChunkMesh()->p_VerticesCount > 0)
+		ChunkMeshArena::DestroyArenas();
+	}
+
+	void Renderer::RenderChunk(Chunk* chunk, int section)
+	{
+		ChunkMesh* mesh = &chunk->p_Sections[section].p_Mesh;
+
+		if (mesh->p_VerticesCount > 0)
 		{
-			m_DefaultChunkShader.SetInteger("u_ChunkX", chunk->p_Position.x);
-			m_DefaultChunkShader.SetInteger("u_ChunkZ", chunk->p_Position.z);
-			m_DefaultChunkShader.SetInteger("u_Transparent", 0);
-			m_DefaultChunkShader.SetInteger("u_VTransparent", 0);
-
-			chunk->GetChunkMesh()->p_VAO.Bind();
-			(glDrawElements(GL_TRIANGLES, floor(chunk->GetChunkMesh()->p_VerticesCount / 4) * 6, GL_UNSIGNED_INT, 0));
-			chunk->GetChunkMesh()->p_VAO.Unbind();
+			m_TransparentPass = false;
+			ChunkMeshArena::Get(mesh->p_VertexFormat).QueueDraw(mesh->p_FirstVertex, mesh->p_VerticesCount, chunk->p_Position.x, chunk->p_Position.z,
+				mesh->p_MeshingMode == ChunkMeshingMode::Greedy);
 		}
 	}
 
-	void Renderer::RenderTransparentChunk(Chunk* chunk)
+	void Renderer::RenderTransparentChunk(Chunk* chunk, int section)
 	{
-		if (chunk->GetChunkMesh()->p_TransparentVerticesCount > 0)
+		ChunkMesh* mesh = &chunk->p_Sections[section].p_Mesh;
+
+		if (mesh->p_TransparentVerticesCount > 0)
 		{
-			m_DefaultChunkShader.SetInteger("u_ChunkX", chunk->p_Position.x);
-			m_DefaultChunkShader.SetInteger("u_ChunkZ", chunk->p_Position.z);
-			m_DefaultChunkShader.SetInteger("u_Transparent", 1);
-			m_DefaultChunkShader.SetInteger("u_VTransparent", 1);
-
-			chunk->GetChunkMesh()->p_TransparentVAO.Bind();
-			(glDrawElements(GL_TRIANGLES, floor(chunk->GetChunkMesh()->p_TransparentVerticesCount / 4) * 6, GL_UNSIGNED_INT, 0));
-			chunk->GetChunkMesh()->p_TransparentVAO.Unbind();
+			m_TransparentPass = true;
+			ChunkMeshArena::Get(mesh->p_VertexFormat).QueueDraw(mesh->p_FirstTransparentVertex, mesh->p_TransparentVerticesCount, 
+				chunk->p_Position.x, chunk->p_Position.z, mesh->p_MeshingMode == ChunkMeshingMode::Greedy);
+		}
+	}
+
+	void Renderer::FlushChunkDraws()
+	{
+		const ChunkVertexFormat formats[2] = { ChunkVertexFormat::Standard, ChunkVertexFormat::Packed };
+
+		for (ChunkVertexFormat format : formats)
+		{
+			ChunkMeshArena* arena = ChunkMeshArena::Find(format);
+
+			if (arena == nullptr || !arena->HasQueuedDraws())
+			{
+				continue;
+			}
+
+			GLClasses::Shader& shader = m_ModelPass ? (format == ChunkVertexFormat::Packed ? m_PackedChunkModelShader : m_DefaultChunkModelShader) :
+				(format == ChunkVertexFormat::Packed ? m_PackedChunkShader : m_DefaultChunkShader);
+
+			shader.Use();
+
+			if (!m_ModelPass)
+			{
+				shader.SetInteger("u_Transparent", m_TransparentPass);
+				shader.SetInteger("u_VTransparent", m_TransparentPass);
+			}
+
+			// The transparent sections are queued back to front for blending
+			arena->DrawQueued(shader, m_TransparentPass);
 		}
 	}
 
 	const glm::vec4 FogColor = glm::vec4((glm::vec3(151.0f, 183.0f, 245.0f) / 255.0f)*1.1f, 1.0f);
 
+	void Renderer::SetChunkShaderUniforms(GLClasses::Shader& shader, FPSCamera* camera, const glm::vec4& ambient_light, int render_distance, const glm::vec4& sun_position)
+	{
+		shader.Use();
+		shader.SetInteger("u_Texture", 0, 0);
+		shader.SetVector4f("u_AmbientLight", ambient_light, 0);
+		shader.SetMatrix4("u_ViewProjection", camera->GetViewProjection());
+		shader.SetMatrix4("u_ViewMatrix", camera->GetViewMatrix());
+		shader.SetInteger("u_RenderDistance", render_distance);
+		shader.SetInteger("u_CHUNK_SIZE_X", CHUNK_SIZE_X);
+		shader.SetInteger("u_CHUNK_SIZE_Z", CHUNK_SIZE_Z);
+		shader.SetFloat("u_SunPositionY", sun_position.y);
+		shader.SetFloat("u_Time", glfwGetTime());
+		shader.SetVector4f("u_FogColor", FogColor); // WHITE FOG
+	}
 
+	// The uniforms are set on both shader variants so that meshes of both vertex formats can be drawn in the same pass
 	void Renderer::StartChunkRendering(FPSCamera* camera, const glm::vec4& ambient_light, int render_distance, const glm::vec4& sun_position)
 	{
-		m_DefaultChunkShader.Use();
 		m_BlockAtlas.Bind(0);
-		m_DefaultChunkShader.SetInteger("u_Texture", 0, 0);
-		m_DefaultChunkShader.SetVector4f("u_AmbientLight", ambient_light, 0);
-		m_DefaultChunkShader.SetMatrix4("u_ViewProjection", camera->GetViewProjection());
-		m_DefaultChunkShader.SetMatrix4("u_ViewMatrix", camera->GetViewMatrix());
-		m_DefaultChunkShader.SetInteger("u_RenderDistance", render_distance);
-		m_DefaultChunkShader.SetInteger("u_CHUNK_SIZE_X", CHUNK_SIZE_X);
-		m_DefaultChunkShader.SetInteger("u_CHUNK_SIZE_Z", CHUNK_SIZE_Z);
-		m_DefaultChunkShader.SetFloat("u_SunPositionY", sun_position.y);
-		m_DefaultChunkShader.SetFloat("u_Time", glfwGetTime());
-		m_DefaultChunkShader.SetVector4f("u_FogColor", FogColor); // WHITE FOG
+		SetChunkShaderUniforms(m_PackedChunkShader, camera, ambient_light, render_distance, sun_position);
+		SetChunkShaderUniforms(m_DefaultChunkShader, camera, ambient_light, render_distance, sun_position);
+		m_ModelPass = false;
+		m_TransparentPass = false;
 	}
 
 	void Renderer::EndChunkRendering()
 	{
+		FlushChunkDraws();
 		glUseProgram(0);
 	}
 
 	void Renderer::StartChunkModelRendering(FPSCamera* camera, const glm::vec4& ambient_light, int render_distance, const glm::vec4& sun_position)
 	{
-		m_DefaultChunkModelShader.Use();
 		m_BlockAtlas.Bind(0);
-		m_DefaultChunkModelShader.SetInteger("u_Texture", 0, 0);
-		m_DefaultChunkModelShader.SetVector4f("u_AmbientLight", ambient_light, 0);
-		m_DefaultChunkModelShader.SetMatrix4("u_ViewProjection", camera->GetViewProjection());
-		m_DefaultChunkModelShader.SetMatrix4("u_ViewMatrix", camera->GetViewMatrix());
-		m_DefaultChunkModelShader.SetInteger("u_RenderDistance", render_distance);
-		m_DefaultChunkModelShader.SetFloat("u_SunPositionY", sun_position.y);
-		m_DefaultChunkModelShader.SetInteger("u_CHUNK_SIZE_X", CHUNK_SIZE_X);
-		m_DefaultChunkModelShader.SetInteger("u_CHUNK_SIZE_Z", CHUNK_SIZE_Z);
-		m_DefaultChunkModelShader.SetVector4f("u_FogColor", FogColor); // WHITE FOG
-		m_DefaultChunkModelShader.SetFloat("u_Time", glfwGetTime(), 0);
+		SetChunkShaderUniforms(m_PackedChunkModelShader, camera, ambient_light, render_distance, sun_position);
+		SetChunkShaderUniforms(m_DefaultChunkModelShader, camera, ambient_light, render_distance, sun_position);
+		m_ModelPass = true;
+		m_TransparentPass = false;
 	}
 
-	void Renderer::RenderChunkModels(Chunk* chunk)
+	void Renderer::RenderChunkModels(Chunk* chunk, int section)
 	{
-		if (chunk->GetChunkMesh()->p_ModelVerticesCount > 0)
+		ChunkMesh* mesh = &chunk->p_Sections[section].p_Mesh;
+
+		if (mesh->p_ModelVerticesCount > 0)
 		{
-			m_DefaultChunkModelShader.SetInteger("u_ChunkX", chunk->p_Position.x);
-			m_DefaultChunkModelShader.SetInteger("u_ChunkZ", chunk->p_Position.z);
-			chunk->GetChunkMesh()->p_ModelVAO.Bind();
-			(glDrawElements(GL_TRIANGLES, floor(chunk->GetChunkMesh()->p_ModelVerticesCount / 4) * 6, GL_UNSIGNED_INT, 0));
-			chunk->GetChunkMesh()->p_ModelVAO.Unbind();
+			ChunkMeshArena::Get(mesh->p_VertexFormat).QueueDraw(mesh->p_FirstModelVertex, mesh->p_ModelVerticesCount, chunk->p_Position.x, chunk->p_Position.z, false);
 		}
 	}
 
 	void Renderer::EndChunkModelRendering()
 	{
+		FlushChunkDraws();
 		glUseProgram(0);
 	}
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include "../OpenGL Classes/GLDebug.h"
 
 #include "../Chunk.h"
+#include "../ChunkMeshArena.h"
 #include "../FpsCamera.h"
 
 namespace Omnia
@@ -21,23 +22,38 @@ namespace Omnia
 	public : 
 
 		Renderer();
+		~Renderer();
 
 		void StartChunkRendering(FPSCamera* camera, const glm::vec4& ambient_light, int render_distance, const glm::vec4& sun_position);
-		void RenderTransparentChunk(Chunk* chunk);
-		void RenderChunk(Chunk* chunk);
+		void RenderTransparentChunk(Chunk* chunk, int section);
+		void RenderChunk(Chunk* chunk, int section);
 		void EndChunkRendering();
 
+		// The Render*() functions only queue the section, the queued sections are drawn here with one call per chunk (see ChunkMeshArena.h).
+		// Called by the End*() functions and between passes that need different opengl state
+		void FlushChunkDraws();
+
 		void StartChunkModelRendering(FPSCamera* camera, const glm::vec4& ambient_light, int render_distance, const glm::vec4& sun_position);
-		void RenderChunkModels(Chunk* chunk);
+		void RenderChunkModels(Chunk* chunk, int section);
 		void EndChunkModelRendering();
 
 		GLClasses::Texture* GetAtlasTexture() { return &m_BlockAtlas; }
 
 	private: 
+
+		void SetChunkShaderUniforms(GLClasses::Shader& shader, FPSCamera* camera, const glm::vec4& ambient_light, int render_distance, const glm::vec4& sun_position);
+
+
 		GLClasses::VertexBuffer m_VBO;
 		GLClasses::VertexArray m_VAO;
 		GLClasses::Shader m_DefaultChunkShader;
 		GLClasses::Shader m_DefaultChunkModelShader;
+
+		// Compiled with OMNIA_PACKED_VERTICES, used for the meshes that are built with ChunkVertexFormat::Packed
+		GLClasses::Shader m_PackedChunkShader;
+		GLClasses::Shader m_PackedChunkModelShader;
+		bool m_ModelPass = false;
+		bool m_TransparentPass = false;
 		GLClasses::Texture m_BlockAtlas;
 	};
 }
\ No newline at end of file
@@ -3,9 +3,13 @@
 #define CHUNK_SIZE_X 16
 #define CHUNK_SIZE_Y 255
 #define CHUNK_SIZE_Z 16
+#define CHUNK_SECTION_SIZE_Y 16
+#define CHUNK_SECTION_COUNT ((CHUNK_SIZE_Y + CHUNK_SECTION_SIZE_Y - 1) / CHUNK_SECTION_SIZE_Y) // The top section is one block shorter
 #define MAX_STRUCTURE_X 10
 #define MAX_STRUCTURE_Y 10
 #define MAX_STRUCTURE_Z 10
+#define LAMP_LIGHT_LEVEL 24
+#define MAX_SKY_LIGHT_LEVEL 15 // The sky light of a block that can see the sky, it drops by one per block under cover
 
 
 // For windowing and context creation
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <queue>
+#include <vector>
+
+namespace Omnia
+{
+	/*
+	A simple fixed size thread pool.
+	Jobs are executed in the order they are queued, by whichever worker is free first.
+	The destructor finishes the jobs that are already running and joins the workers. Jobs that haven't started are dropped
+	*/
+
+	class ThreadPool
+	{
+	public :
+
+		ThreadPool(unsigned int thread_count) : m_Running(true), m_ActiveJobs(0)
+		{
+			if (thread_count == 0)
+			{
+				thread_count = 1;
+			}
+
+			for (unsigned int i = 0; i < thread_count; i++)
+			{
+				m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+			}
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_QueueMutex);
+				m_Running = false;
+			}
+
+			m_QueueCondition.notify_all();
+
+			for (std::thread& worker : m_Workers)
+			{
+				worker.join();
+			}
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void Enqueue(std::function<void()> job)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_QueueMutex);
+				m_Jobs.push(std::move(job));
+			}
+
+			m_QueueCondition.notify_one();
+		}
+
+		// Blocks the calling thread until every queued job has finished
+		void WaitIdle()
+		{
+			std::unique_lock<std::mutex> lock(m_QueueMutex);
+			m_IdleCondition.wait(lock, [this]() { return m_Jobs.empty() && m_ActiveJobs == 0; });
+		}
+
+		// Jobs that are either waiting in the queue or currently running
+		size_t GetPendingJobCount()
+		{
+			std::lock_guard<std::mutex> lock(m_QueueMutex);
+			return m_Jobs.size() + m_ActiveJobs;
+		}
+
+		unsigned int GetThreadCount() const noexcept
+		{
+			return static_cast<unsigned int>(m_Workers.size());
+		}
+
+		// Leaves one core for the main (render) thread
+		static unsigned int GetDefaultThreadCount()
+		{
+			unsigned int cores = std::thread::hardware_concurrency();
+			return cores > 1 ? cores - 1 : 1;
+		}
+
+	private :
+
+		void WorkerLoop()
+		{
+			while (true)
+			{
+				std::function<void()> job;
+
+				{
+					std::unique_lock<std::mutex> lock(m_QueueMutex);
+					m_QueueCondition.wait(lock, [this]() { return !m_Running || !m_Jobs.empty(); });
+
+					if (!m_Running)
+					{
+						return;
+					}
+
+					job = std::move(m_Jobs.front());
+					m_Jobs.pop();
+					m_ActiveJobs++;
+				}
+
+				job();
+
+				{
+					std::lock_guard<std::mutex> lock(m_QueueMutex);
+					m_ActiveJobs--;
+				}
+
+				m_IdleCondition.notify_all();
+			}
+		}
+
+		std::vector<std::thread> m_Workers;
+		std::queue<std::function<void()>> m_Jobs;
+		std::mutex m_QueueMutex;
+		std::condition_variable m_QueueCondition;
+		std::condition_variable m_IdleCondition;
+		bool m_Running;
+		size_t m_ActiveJobs;
+	};
+}
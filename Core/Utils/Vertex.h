@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 
 #include "Defs.h"
@@ -56,4 +58,35 @@ namespace Omnia
 		i16Vec2 texture_coords;
 		uint8_t block_face_lighting;
 	};
+	/* -- Packed Vertex Structure --
+	The same data as Vertex packed into two 32 bit words, decoded in the chunk vertex shaders when OMNIA_PACKED_VERTICES is defined.
+	The face index (see the block face order above, 6 = model) and the corner index of the quad are stored as well so the shader can derive them without extra attributes.
+	data0 : x (5 bits) | y (9 bits) | z (5 bits) | face (3 bits) | corner (2 bits) | lighting_level (8 bits)
+	data1 : texture x (12 bits) | texture y (12 bits) | block_face_lighting (8 bits)
+	The texture coordinates are atlas pixel coordinates like in Vertex, 12 bits are enough for a 4096x4096 atlas
+	*/
+
+	struct PackedVertex
+	{
+		uint32_t data0;
+		uint32_t data1;
+	};
+
+	inline PackedVertex PackVertex(const Vertex& vertex, uint8_t face, uint8_t corner)
+	{
+		assert(vertex.position.x < 32 && vertex.position.z < 32);
+		assert(vertex.texture_coords.x < 4096 && vertex.texture_coords.y < 4096);
+		assert(face < 8 && corner < 4);
+
+		PackedVertex packed;
+
+		packed.data0 = static_cast<uint32_t>(vertex.position.x) | (static_cast<uint32_t>(vertex.position.y) << 5) |
+			(static_cast<uint32_t>(vertex.position.z) << 14) | (static_cast<uint32_t>(face) << 19) | 
+			(static_cast<uint32_t>(corner) << 22) | (static_cast<uint32_t>(vertex.lighting_level) << 24);
+
+		packed.data1 = static_cast<uint32_t>(vertex.texture_coords.x) | (static_cast<uint32_t>(vertex.texture_coords.y) << 12) |
+			(static_cast<uint32_t>(vertex.block_face_lighting) << 24);
+
+		return packed;
+	}
 }
\ No newline at end of file
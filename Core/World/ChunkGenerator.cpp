@@ -0,0 +1,70 @@
+#include "ChunkGenerator.h"
+#include "ChunkHashMap.h"
+#include "../Utils/Logger.h"
+
+#include <sstream>
+
+namespace Omnia
+{
+	ChunkGenerator::ChunkGenerator(unsigned int thread_count) : m_WorkerPool(thread_count)
+	{
+		std::stringstream s;
+		s << "Chunk generator started with " << m_WorkerPool.GetThreadCount() << " worker threads";
+		Logger::LogToConsole(s.str());
+	}
+
+	ChunkGenerator::~ChunkGenerator()
+	{
+		WaitForJobs();
+	}
+
+	bool ChunkGenerator::QueueChunk(int cx, int cz, std::function<void(Chunk*)> fill)
+	{
+		if (m_QueuedChunks.size() >= MAX_JOBS_IN_FLIGHT || !m_QueuedChunks.insert(ChunkHashMap<Chunk>::PackKey(cx, cz)).second)
+		{
+			return false;
+		}
+
+		m_WorkerPool.Enqueue([this, cx, cz, fill]()
+		{
+			std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(glm::vec3(cx, 0, cz));
+			fill(chunk.get());
+
+			std::lock_guard<std::mutex> lock(m_FinishedMutex);
+			m_FinishedChunks.push_back(std::move(chunk));
+		});
+
+		return true;
+	}
+
+	void ChunkGenerator::TakeFinishedChunks(std::vector<std::unique_ptr<Chunk>>& chunks)
+	{
+		const size_t first = chunks.size();
+
+		{
+			std::lock_guard<std::mutex> lock(m_FinishedMutex);
+
+			for (std::unique_ptr<Chunk>& chunk : m_FinishedChunks)
+			{
+				chunks.push_back(std::move(chunk));
+			}
+
+			m_FinishedChunks.clear();
+		}
+
+		for (size_t i = first; i < chunks.size(); i++)
+		{
+			m_QueuedChunks.erase(ChunkHashMap<Chunk>::PackKey(static_cast<int>(chunks[i]->p_Position.x), static_cast<int>(chunks[i]->p_Position.z)));
+		}
+	}
+
+	void ChunkGenerator::WaitForJobs()
+	{
+		m_WorkerPool.WaitIdle();
+	}
+
+	bool ChunkGenerator::IsQueued(int cx, int cz) const
+	{
+		return m_QueuedChunks.count(ChunkHashMap<Chunk>::PackKey(cx, cz)) > 0;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <unordered_set>
+
+#include "../Chunk.h"
+#include "../Utils/ThreadPool.h"
+
+namespace Omnia
+{
+	/*
+	Creates chunks on a pool of worker threads.
+
+	QueueChunk() is called from the main thread. The worker allocates the chunk, fills it (reads it from the save or generates its terrain)
+	and pushes it on to the finished list. The chunk isn't in the world while it is being filled so nothing else can see it half done.
+	TakeFinishedChunks() is called once per frame from the main thread, the world adds the chunks to its chunk map.
+	A chunk that was added to the world some other way in the mean time (generated right away because the player needed it) is thrown away
+	*/
+
+	class ChunkGenerator
+	{
+	public :
+
+		ChunkGenerator(unsigned int thread_count = ThreadPool::GetDefaultThreadCount());
+		~ChunkGenerator();
+
+		ChunkGenerator(const ChunkGenerator&) = delete;
+		ChunkGenerator& operator=(const ChunkGenerator&) = delete;
+
+		// fill is called on a worker thread with the new chunk. Returns false if the chunk is already queued or too many jobs are in flight
+		bool QueueChunk(int cx, int cz, std::function<void(Chunk*)> fill);
+
+		// Appends the chunks that are done to chunks, the caller owns them from then on
+		void TakeFinishedChunks(std::vector<std::unique_ptr<Chunk>>& chunks);
+
+		// Blocks until every queued job has finished
+		void WaitForJobs();
+
+		bool IsQueued(int cx, int cz) const;
+		inline uint32_t GetJobsInFlight() const noexcept { return static_cast<uint32_t>(m_QueuedChunks.size()); }
+
+		static constexpr uint32_t MAX_JOBS_IN_FLIGHT = 256;
+
+	private :
+
+		std::mutex m_FinishedMutex;
+		std::vector<std::unique_ptr<Chunk>> m_FinishedChunks;
+		std::unordered_set<std::uint64_t> m_QueuedChunks; // Chunks that are queued or finished but not taken yet. Only touched by the main thread
+
+		// Declared last so the workers are joined before anything they use is destroyed
+		ThreadPool m_WorkerPool;
+	};
+}
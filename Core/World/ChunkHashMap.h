@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <utility>
+
+namespace Omnia
+{
+	/*
+	An open addressing hash map from chunk coordinates to chunks, used instead of std::map for the loaded chunks.
+	The key is both coordinates packed in to one 64 bit integer and the slots are probed linearly,
+	so a lookup is usually one hash and one or two comparisons in a contiguous array.
+	The values are heap allocated so the pointers returned stay valid when the table grows. Erasing uses backward shift deletion, no tombstones.
+	*/
+
+	template <typename T>
+	class ChunkHashMap
+	{
+	public :
+
+		ChunkHashMap(size_t initial_capacity = 1024)
+		{
+			size_t capacity = 16;
+
+			while (capacity < initial_capacity)
+			{
+				capacity *= 2;
+			}
+
+			m_Slots.resize(capacity);
+		}
+
+		ChunkHashMap(const ChunkHashMap&) = delete;
+		ChunkHashMap& operator=(const ChunkHashMap&) = delete;
+
+		static inline std::uint64_t PackKey(int cx, int cz) noexcept
+		{
+			return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cx)) << 32) | static_cast<std::uint32_t>(cz);
+		}
+
+		// Returns nullptr if there is no value at those coordinates
+		T* Find(int cx, int cz) const noexcept
+		{
+			const std::uint64_t key = PackKey(cx, cz);
+
+			for (size_t i = GetHomeSlot(key); ; i = (i + 1) & GetMask())
+			{
+				const Slot& slot = m_Slots[i];
+
+				if (!slot.p_Value)
+				{
+					return nullptr;
+				}
+
+				if (slot.p_Key == key)
+				{
+					return slot.p_Value.get();
+				}
+			}
+		}
+
+		// Constructs the value with args if it doesn't exist yet. Returns the value and whether it was created
+		template <typename... Args>
+		std::pair<T*, bool> Emplace(int cx, int cz, Args&&... args)
+		{
+			// Grow at 50% load, linear probing gets slow when the table is fuller than that
+			if ((m_Size + 1) * 2 > m_Slots.size())
+			{
+				Rehash(m_Slots.size() * 2);
+			}
+
+			const std::uint64_t key = PackKey(cx, cz);
+
+			for (size_t i = GetHomeSlot(key); ; i = (i + 1) & GetMask())
+			{
+				Slot& slot = m_Slots[i];
+
+				if (!slot.p_Value)
+				{
+					slot.p_Key = key;
+					slot.p_Value = std::make_unique<T>(std::forward<Args>(args)...);
+					m_Size++;
+
+					return { slot.p_Value.get(), true };
+				}
+
+				if (slot.p_Key == key)
+				{
+					return { slot.p_Value.get(), false };
+				}
+			}
+		}
+
+		// Takes ownership of a value built somewhere else (a chunk generated on another thread). 
+		// Returns false and destroys the value if there already is one at those coordinates
+		bool Insert(int cx, int cz, std::unique_ptr<T> value)
+		{
+			if ((m_Size + 1) * 2 > m_Slots.size())
+			{
+				Rehash(m_Slots.size() * 2);
+			}
+
+			const std::uint64_t key = PackKey(cx, cz);
+
+			for (size_t i = GetHomeSlot(key); ; i = (i + 1) & GetMask())
+			{
+				Slot& slot = m_Slots[i];
+
+				if (!slot.p_Value)
+				{
+					slot.p_Key = key;
+					slot.p_Value = std::move(value);
+					m_Size++;
+
+					return true;
+				}
+
+				if (slot.p_Key == key)
+				{
+					return false;
+				}
+			}
+		}
+
+		// Destroys the value. Returns false if there was nothing to erase
+		bool Erase(int cx, int cz)
+		{
+			const std::uint64_t key = PackKey(cx, cz);
+			size_t i = GetHomeSlot(key);
+
+			while (true)
+			{
+				if (!m_Slots[i].p_Value)
+				{
+					return false;
+				}
+
+				if (m_Slots[i].p_Key == key)
+				{
+					break;
+				}
+
+				i = (i + 1) & GetMask();
+			}
+
+			m_Slots[i].p_Value.reset();
+			m_Size--;
+
+			// Move the following entries of the cluster back so that no lookup stops at the new hole
+			size_t hole = i;
+
+			for (size_t j = (i + 1) & GetMask(); m_Slots[j].p_Value; j = (j + 1) & GetMask())
+			{
+				const size_t home = GetHomeSlot(m_Slots[j].p_Key);
+
+				// The entry can only move back if its home slot isn't between the hole and its current slot (cyclically)
+				if (((j - home) & GetMask()) >= ((j - hole) & GetMask()))
+				{
+					m_Slots[hole] = std::move(m_Slots[j]);
+					hole = j;
+				}
+			}
+
+			return true;
+		}
+
+		void Clear()
+		{
+			for (Slot& slot : m_Slots)
+			{
+				slot.p_Value.reset();
+			}
+
+			m_Size = 0;
+		}
+
+		// Calls func(T&) for every value, in no particular order. func must not add or erase values
+		template <typename F>
+		void ForEach(F&& func)
+		{
+			for (Slot& slot : m_Slots)
+			{
+				if (slot.p_Value)
+				{
+					func(*slot.p_Value);
+				}
+			}
+		}
+
+		template <typename F>
+		void ForEach(F&& func) const
+		{
+			for (const Slot& slot : m_Slots)
+			{
+				if (slot.p_Value)
+				{
+					func(static_cast<const T&>(*slot.p_Value));
+				}
+			}
+		}
+
+		inline size_t Size() const noexcept { return m_Size; }
+		inline size_t Capacity() const noexcept { return m_Slots.size(); }
+
+	private :
+
+		struct Slot
+		{
+			std::uint64_t p_Key = 0;
+			std::unique_ptr<T> p_Value; // nullptr = empty slot
+		};
+
+		inline size_t GetMask() const noexcept { return m_Slots.size() - 1; }
+
+		// Fibonacci hashing, the high bits of the product are well mixed even for neighbouring coordinates
+		inline size_t GetHomeSlot(std::uint64_t key) const noexcept
+		{
+			return static_cast<size_t>((key * 11400714819323198485ull) >> 32) & GetMask();
+		}
+
+		void Rehash(size_t new_capacity)
+		{
+			std::vector<Slot> old_slots = std::move(m_Slots);
+
+			m_Slots.clear();
+			m_Slots.resize(new_capacity);
+
+			for (Slot& old_slot : old_slots)
+			{
+				if (!old_slot.p_Value)
+				{
+					continue;
+				}
+
+				size_t i = GetHomeSlot(old_slot.p_Key);
+
+				while (m_Slots[i].p_Value)
+				{
+					i = (i + 1) & GetMask();
+				}
+
+				m_Slots[i] = std::move(old_slot);
+			}
+		}
+
+		std::vector<Slot> m_Slots;
+		size_t m_Size = 0;
+	};
+}
@@ -1,13 +1,19 @@
 #include "World.h"
+#include "../File Handling/WorldFileHandler.h"
 
 namespace Omnia
 {
 	// The amount of chunks that gets rendered around the player
 	int render_distance = 6;
 
+	// The meshing mode used for every world, see SetMeshingMode()
+	ChunkMeshingMode meshing_mode = ChunkMeshingMode::PerFace;
+
+	// The vertex format used for every world, see SetVertexFormat()
+	ChunkVertexFormat vertex_format = ChunkVertexFormat::Standard;
+
 	constexpr float max_sun = 1500.0f;
 	constexpr float min_sun = 10.0f;
-	constexpr uint8_t LAMP_LIGHT_LEVEL = 24;
 
 	/*
 		Prints a 3 component vector on the screen
@@ -62,6 +68,8 @@ namespace Omnia
 	{
 		m_SunCycle = CurrentSunCycle::Sun_Rising;
 		m_SunPosition = glm::vec4(0.0f, max_sun, 0.0f, 1.0f);
+		m_ChunkMesher.SetMeshingMode(meshing_mode);
+		m_ChunkMesher.SetVertexFormat(vertex_format);
 
 		// Generate all the chunks 
 
@@ -81,6 +89,34 @@ namespace Omnia
 		m_CrosshairPosition = std::pair<float, float>(cw, cy);
 		m_CurrentFrame = 0;
 
+		m_ResidencyDistance = DEFAULT_RESIDENCY_DISTANCE;
+		m_ChunkMemoryBudget = DEFAULT_CHUNK_MEMORY_BUDGET_MB * 1024 * 1024;
+		m_AutosaveInterval = DEFAULT_AUTOSAVE_INTERVAL;
+		m_TimeSinceAutosave = 0.0f;
+		m_AutosaveRunning = false;
+
+		// Every block is saved. Delta saves are opt in, they only work while the generator makes the same terrain (see ChunkSaveMode)
+		m_ChunkSaveOptions.p_Mode = ChunkFileHandler::ChunkSaveMode::Full;
+		m_ChunkSaveOptions.p_Seed = seed;
+		m_ChunkSaveOptions.p_GenerationType = world_gen_type;
+
+		// The menu world is never saved, its chunks are just dropped
+		if (world_name != "MenuWorld")
+		{
+			if (WorldFileHandler::IsSaveCompatible(world_name, seed))
+			{
+				m_ChunkDirectory = WorldFileHandler::GetChunkDirectory(world_name);
+
+				// Saves from before the region files
+				ChunkFileHandler::ConvertLegacyChunkFiles(m_ChunkDirectory, m_ChunkSaveOptions);
+			}
+
+			else
+			{
+				Logger::LogToConsole("Another world with a different seed is saved with the same name! Modified chunks will stay loaded");
+			}
+		}
+
 		std::cout << std::endl << "------      CREATING THE AUDIO ENGINE        ------" << std::endl;
 
 		// Create the sound engine
@@ -91,7 +127,15 @@ namespace Omnia
 
 	World::~World()
 	{
+		// Make sure no mesher thread is still reading chunk data before the chunks get destroyed
+		m_ChunkMesher.WaitForJobs();
 
+		// The generator jobs read from the chunk saver
+		m_ChunkGenerator.WaitForJobs();
+
+		// The saver writes through the region files
+		m_ChunkSaver.WaitForWrites();
+		ChunkFileHandler::CloseRegionFiles();
 	}
 
 
@@ -107,45 +151,64 @@ namespace Omnia
 
 		std::stringstream str;
 
-		int build_distance_x = render_distance_x + 4;
-		int build_distance_z = render_distance_z + 4;
+		int build_distance_x = render_distance_x + 1;
+		int build_distance_z = render_distance_z + 1;
 
 		/*
-		build_distance_x and build_distance_z is the build distance. It is needed to build `x` chunks
-		more than what is required in order for the meshing process to work properly
+		build_distance_x and build_distance_z is the build distance. The mesher needs the neighbours of every chunk that is rendered,
+		so one more ring of chunks is built. A chunk is generated completely on its own (see GenerationStage), the trees that reach
+		in to the chunks that aren't there yet are written when those chunks are added
 
-		For this it is required to first generate all the chunks that are needed to be generated.
-		Only after all the chunks are generated, the mesh building process with start
+		The chunks the player is in or next to are needed right away (collisions, finding the spawn height) so they are made here.
+		Every other chunk of the build distance is made on the chunk generator threads, closest first, and added to the world when it is done
 		*/
 
-		for (int i = player_chunk_x - build_distance_x; i < player_chunk_x + build_distance_x; i++)
+		for (int i = player_chunk_x - 1; i <= player_chunk_x + 1; i++)
 		{
-			for (int j = player_chunk_z - build_distance_z; j < player_chunk_z + build_distance_z; j++)
+			for (int j = player_chunk_z - 1; j <= player_chunk_z + 1; j++)
 			{
 				if (ChunkExistsInMap(i, j) == false)
 				{
 					Chunk* chunk = EmplaceChunkInMap(i, j);
-					GenerateChunk(chunk, m_WorldSeed, m_WorldGenType);
+
+					_FillChunk(chunk);
+					_PullNeighbourLight(chunk);
 				}
 			}
 		}
 
-		int flora_build_distance_x = build_distance_x - 1;
-		int flora_build_distance_z = build_distance_z - 1;
+		// Spreads the light that was pulled across the borders of the chunks made above, _AddGeneratedChunks() does the same for the generated ones
+		PropogateLight();
+		PropogateSkyLight();
+
+		_AddGeneratedChunks();
 
-		for (int i = player_chunk_x - flora_build_distance_x; i < player_chunk_x + flora_build_distance_x; i++)
+		std::vector<glm::ivec2> missing_chunks;
+
+		for (int i = player_chunk_x - build_distance_x; i < player_chunk_x + build_distance_x; i++)
 		{
-			for (int j = player_chunk_z - flora_build_distance_z; j < player_chunk_z + flora_build_distance_z; j++)
+			for (int j = player_chunk_z - build_distance_z; j < player_chunk_z + build_distance_z; j++)
 			{
-				Chunk* chunk = RetrieveChunkFromMap(i, j);
-
-				if (chunk->p_ChunkState == ChunkState::Ungenerated)
+				if (ChunkExistsInMap(i, j) == false && !m_ChunkGenerator.IsQueued(i, j))
 				{
-					GenerateChunkFlora(chunk, m_WorldSeed, m_WorldGenType);
-					chunk->p_MeshState = ChunkMeshState::Unbuilt;
-					chunk->p_ChunkState = ChunkState::Generated;
+					missing_chunks.push_back(glm::ivec2(i, j));
 				}
+			}
+		}
 
+		std::sort(missing_chunks.begin(), missing_chunks.end(), [&](const glm::ivec2& a, const glm::ivec2& b)
+		{
+			const glm::ivec2 distance_a = a - glm::ivec2(player_chunk_x, player_chunk_z);
+			const glm::ivec2 distance_b = b - glm::ivec2(player_chunk_x, player_chunk_z);
+			return distance_a.x * distance_a.x + distance_a.y * distance_a.y < distance_b.x * distance_b.x + distance_b.y * distance_b.y;
+		});
+
+		for (const glm::ivec2& position : missing_chunks)
+		{
+			// The job queue is full, the rest is queued on the next frames
+			if (!m_ChunkGenerator.QueueChunk(position.x, position.y, [this](Chunk* chunk) { _FillChunk(chunk); }))
+			{
+				break;
 			}
 		}
 
@@ -166,6 +229,32 @@ namespace Omnia
 			m_ParticleEmitter.CleanUpList();
 		}
 
+		if (m_CurrentFrame % UNLOAD_INTERVAL == 0)
+		{
+			UnloadFarChunks();
+		}
+
+		// Autosave. Only the copies of the changed chunks are made on this thread, they are written by the chunk saver
+		if (m_AutosaveInterval > 0.0f && !m_ChunkDirectory.empty())
+		{
+			m_TimeSinceAutosave += deltaTime;
+
+			if (m_TimeSinceAutosave >= m_AutosaveInterval && m_ChunkSaver.GetPendingCount() == 0)
+			{
+				m_TimeSinceAutosave = 0.0f;
+				m_AutosaveRunning = WorldFileHandler::SaveWorld(m_WorldName, this);
+			}
+
+			else if (m_AutosaveRunning && m_ChunkSaver.GetPendingCount() == 0)
+			{
+				std::stringstream s;
+				s << "Autosave finished, " << m_ChunkSaver.GetProgress().p_Written << " chunks written";
+				Logger::LogToConsole(s.str());
+
+				m_AutosaveRunning = false;
+			}
+		}
+
 		// Update the listeners position
 		_SetListenerPosition();
 	}
@@ -198,33 +287,47 @@ namespace Omnia
 		player_chunk_z = (int)floor(p_Player->p_Position.z / CHUNK_SIZE_Z);
 		uint32_t chunks_rendered = 0;
 
-		// Render chunks according to render distance
+		// Upload the meshes that the mesher threads finished since the last frame
+		m_ChunkMesher.UploadFinishedMeshes();
 
-		m_Renderer.StartChunkRendering(&p_Player->p_Camera, glm::vec4(ambient, ambient, ambient, 1.0f), render_distance, m_SunPosition);
+		// Build the list of visible sections once, every pass below reuses it
+		m_VisibleSections.clear();
+
+		const glm::vec3 camera_position = p_Player->p_Camera.GetPosition();
 
 		for (int i = player_chunk_x - render_distance_x; i < player_chunk_x + render_distance_x; i++)
 		{
 			for (int j = player_chunk_z - render_distance_z; j < player_chunk_z + render_distance_z; j++)
 			{
-				Chunk* chunk = RetrieveChunkFromMap(i, j);
+				Chunk* chunk = FindChunk(i, j);
 
 				if (chunk) 
 				{
 					if (m_ViewFrustum.BoxInFrustum(chunk->p_ChunkFrustumAABB))
 					{
-						// Construct the chunks if the mesh isn't built
-						if (chunk->p_MeshState == ChunkMeshState::Unbuilt)
+						for (int s = 0; s < CHUNK_SECTION_COUNT; s++)
 						{
-							chunk->Construct();
-						}
+							ChunkSection& section = chunk->p_Sections[s];
 
-						if (chunk->p_MeshState == ChunkMeshState::Built)
-						{
-							m_Renderer.RenderChunk(chunk);
+							// Queue the section on the mesher if the mesh isn't built
+							// If the queue is full it is tried again the next frame
+							if (section.p_MeshState == ChunkMeshState::Unbuilt)
+							{
+								m_ChunkMesher.QueueSection(chunk, s);
+							}
+
+							// A section that is being remeshed keeps drawing its old mesh until the new one is uploaded
+							if (m_ViewFrustum.BoxInFrustum(section.p_FrustumAABB))
+							{
+								const glm::vec3 section_center = glm::vec3(chunk->p_Position.x * CHUNK_SIZE_X + CHUNK_SIZE_X / 2, 
+									s * CHUNK_SECTION_SIZE_Y + CHUNK_SECTION_SIZE_Y / 2, chunk->p_Position.z * CHUNK_SIZE_Z + CHUNK_SIZE_Z / 2);
+								const glm::vec3 to_camera = section_center - camera_position;
 
-							// Render the chunks
-							chunks_rendered++;
+								m_VisibleSections.push_back({ chunk, s, glm::dot(to_camera, to_camera) });
+							}
 						}
+
+						chunks_rendered++;
 					}
 				}
 			}
@@ -232,22 +335,30 @@ namespace Omnia
 
 		p_ChunksRendered = chunks_rendered;
 
-		glDisable(GL_CULL_FACE);
+		// Front to back, so that the depth test rejects as many fragments as possible in the opaque pass
+		std::sort(m_VisibleSections.begin(), m_VisibleSections.end(), [](const VisibleSection& a, const VisibleSection& b)
+		{
+			return a.p_DistanceSquared < b.p_DistanceSquared;
+		});
 
-		for (int i = player_chunk_x - render_distance_x; i < player_chunk_x + render_distance_x; i++)
+		// Render chunks according to render distance
+
+		m_Renderer.StartChunkRendering(&p_Player->p_Camera, glm::vec4(ambient, ambient, ambient, 1.0f), render_distance, m_SunPosition);
+
+		for (const VisibleSection& visible_section : m_VisibleSections)
 		{
-			for (int j = player_chunk_z - render_distance_z; j < player_chunk_z + render_distance_z; j++)
-			{
-				Chunk* chunk = RetrieveChunkFromMap(i, j);
+			m_Renderer.RenderChunk(visible_section.p_Chunk, visible_section.p_Section);
+		}
 
-				if (chunk)
-				{
-					if (m_ViewFrustum.BoxInFrustum(chunk->p_ChunkFrustumAABB))
-					{
-						m_Renderer.RenderTransparentChunk(chunk);
-					}
-				}
-			}
+		// Draw the opaque sections before face culling is turned off for the transparent ones
+		m_Renderer.FlushChunkDraws();
+
+		glDisable(GL_CULL_FACE);
+
+		// Back to front so that water and glass blend over the sections behind them
+		for (auto visible_section = m_VisibleSections.rbegin(); visible_section != m_VisibleSections.rend(); visible_section++)
+		{
+			m_Renderer.RenderTransparentChunk(visible_section->p_Chunk, visible_section->p_Section);
 		}
 
 		m_Renderer.EndChunkRendering();
@@ -256,20 +367,9 @@ namespace Omnia
 
 		m_Renderer.StartChunkModelRendering(&p_Player->p_Camera, glm::vec4(ambient, ambient, ambient, 1.0f), render_distance, m_SunPosition);
 
-		for (int i = player_chunk_x - render_distance_x; i < player_chunk_x + render_distance_x; i++)
+		for (const VisibleSection& visible_section : m_VisibleSections)
 		{
-			for (int j = player_chunk_z - render_distance_z; j < player_chunk_z + render_distance_z; j++)
-			{
-				Chunk* chunk = RetrieveChunkFromMap(i, j);
-
-				if (chunk) 
-				{
-					if (m_ViewFrustum.BoxInFrustum(chunk->p_ChunkFrustumAABB))
-					{
-						m_Renderer.RenderChunkModels(chunk);
-					}
-				}
-			}
+			m_Renderer.RenderChunkModels(visible_section.p_Chunk, visible_section.p_Section);
 		}
 
 		m_Renderer.EndChunkModelRendering();
@@ -375,11 +475,42 @@ namespace Omnia
 		render_distance = x;
 	}
 
+	/*
+		Changes the meshing mode and remeshes every loaded chunk
+	*/
+	void World::SetMeshingMode(ChunkMeshingMode mode)
+	{
+		meshing_mode = mode;
+
+		if (m_ChunkMesher.GetMeshingMode() == mode)
+		{
+			return;
+		}
+
+		m_ChunkMesher.SetMeshingMode(mode);
+
+		m_WorldChunks.ForEach([](Chunk& chunk) { chunk.SetMeshDirty(); });
+	}
+
+	void World::SetVertexFormat(ChunkVertexFormat format)
+	{
+		vertex_format = format;
+
+		if (m_ChunkMesher.GetVertexFormat() == format)
+		{
+			return;
+		}
+
+		m_ChunkMesher.SetVertexFormat(format);
+
+		m_WorldChunks.ForEach([](Chunk& chunk) { chunk.SetMeshDirty(); });
+	}
+
 	/*
 		Gets a block from position.
-		Returns : The block and chunk (of that position)
+		Returns : A copy of the block and the chunk (of that position). Blocks are changed with Chunk::SetBlock()
 	*/
-	std::pair<Block*, Chunk*> World::GetBlockFromPosition(const glm::vec3& pos) noexcept
+	std::pair<Block, Chunk*> World::GetBlockFromPosition(const glm::vec3& pos) noexcept
 	{
 		int block_chunk_x = static_cast<int>(floor(pos.x / CHUNK_SIZE_X));
 		int block_chunk_z = static_cast<int>(floor(pos.z / CHUNK_SIZE_Z));
@@ -387,9 +518,15 @@ namespace Omnia
 		int by = static_cast<int>(floor(pos.y));
 		int bz = pos.z - (block_chunk_z * CHUNK_SIZE_Z);
 
-		Chunk* chunk = RetrieveChunkFromMap(block_chunk_x, block_chunk_z);
+		Chunk* chunk = FindChunk(block_chunk_x, block_chunk_z);
 
-		return { &chunk->p_ChunkContents.at(bx).at(by).at(bz), chunk };
+		// Everything above and below the world is air, and so are the chunks that aren't generated yet
+		if (by < 0 || by >= CHUNK_SIZE_Y || !chunk)
+		{
+			return { { BlockType::Air }, chunk };
+		}
+
+		return { chunk->GetBlock(bx, by, bz), chunk };
 	}
 
 	/*
@@ -403,7 +540,13 @@ namespace Omnia
 		int by = static_cast<int>(floor(pos.y));
 		int bz = pos.z - (block_chunk_z * CHUNK_SIZE_Z);
 
-		RetrieveChunkFromMap(block_chunk_x, block_chunk_z)->SetBlock(type, glm::vec3(bx, by, bz));
+		Chunk* chunk = FindChunk(block_chunk_x, block_chunk_z);
+
+		// A missing chunk is one that isn't loaded (the player can reach outside of the build distance while flying)
+		if (chunk && by >= 0 && by < CHUNK_SIZE_Y)
+		{
+			chunk->SetBlock(type, glm::vec3(bx, by, bz));
+		}
 	}
 
 	/*
@@ -417,19 +560,353 @@ namespace Omnia
 		int by = static_cast<int>(floor(pos.y));
 		int bz = pos.z - (block_chunk_z * CHUNK_SIZE_Z);
 
-		return static_cast<BlockType>(RetrieveChunkFromMap(block_chunk_x, block_chunk_z)->p_ChunkContents.at(bx).at(by).at(bz).p_BlockType);
+		Chunk* chunk = FindChunk(block_chunk_x, block_chunk_z);
+
+		if (!chunk || by < 0 || by >= CHUNK_SIZE_Y)
+		{
+			return BlockType::Air;
+		}
+
+		return chunk->GetBlock(bx, by, bz).p_BlockType;
+	}
+
+	void World::SetChunkResidency(int residency_distance, size_t memory_budget_mb)
+	{
+		m_ResidencyDistance = residency_distance;
+		m_ChunkMemoryBudget = memory_budget_mb * 1024 * 1024;
+	}
+
+	static size_t EstimateChunkMemoryUsage(const Chunk& chunk)
+	{
+		size_t usage = sizeof(Chunk) + chunk.GetSectionMemoryUsage();
+
+		for (const ChunkSection& section : chunk.p_Sections)
+		{
+			const ChunkMesh& mesh = section.p_Mesh;
+			const size_t vertex_size = mesh.p_VertexFormat == ChunkVertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+
+			usage += (static_cast<size_t>(mesh.p_VerticesCount) + mesh.p_TransparentVerticesCount + mesh.p_ModelVerticesCount) * vertex_size;
+		}
+
+		return usage;
+	}
+
+	size_t World::GetChunkMemoryUsage()
+	{
+		size_t usage = 0;
+		m_WorldChunks.ForEach([&usage](const Chunk& chunk) { usage += EstimateChunkMemoryUsage(chunk); });
+		return usage;
 	}
 
 	/*
-		Unloads the chunks when it is too faraway.
-		Called every 200~ frames
-		TODO
+		Unloads the least recently used chunks outside of the residency distance while the loaded chunks use more memory than the budget.
+		Modified chunks are queued on the chunk saver first and read back by _ReadUnloadedChunk() when the player comes back,
+		unmodified chunks are dropped and generated again. The meshes of an unloaded chunk give their vertices back to the mesh arena.
+		Called every UNLOAD_INTERVAL frames
 	*/
 	void World::UnloadFarChunks()
 	{
+		const int player_chunk_x = (int)floor(p_Player->p_Position.x / CHUNK_SIZE_X);
+		const int player_chunk_z = (int)floor(p_Player->p_Position.z / CHUNK_SIZE_Z);
 
+		// Chunks inside the build distance would be generated again on the next frame
+		const int residency_distance = std::max(m_ResidencyDistance, render_distance + 2);
 
-		return;
+		std::vector<Chunk*> unload_candidates;
+		size_t memory_usage = 0;
+
+		m_WorldChunks.ForEach([&](Chunk& chunk)
+		{
+			memory_usage += EstimateChunkMemoryUsage(chunk);
+
+			const int distance_x = abs(static_cast<int>(chunk.p_Position.x) - player_chunk_x);
+			const int distance_z = abs(static_cast<int>(chunk.p_Position.z) - player_chunk_z);
+
+			if (distance_x <= residency_distance && distance_z <= residency_distance)
+			{
+				chunk.p_LastUsedFrame = m_CurrentFrame;
+			}
+
+			// A mesher job still holds a pointer to the chunk
+			else if (!chunk.IsMeshing())
+			{
+				unload_candidates.push_back(&chunk);
+			}
+		});
+
+		if (memory_usage <= m_ChunkMemoryBudget || unload_candidates.empty())
+		{
+			return;
+		}
+
+		// Least recently used first, the furthest first when they were last used in the same frame
+		std::sort(unload_candidates.begin(), unload_candidates.end(), [&](const Chunk* a, const Chunk* b)
+		{
+			if (a->p_LastUsedFrame != b->p_LastUsedFrame)
+			{
+				return a->p_LastUsedFrame < b->p_LastUsedFrame;
+			}
+
+			const float distance_a = glm::length(glm::vec2(a->p_Position.x - player_chunk_x, a->p_Position.z - player_chunk_z));
+			const float distance_b = glm::length(glm::vec2(b->p_Position.x - player_chunk_x, b->p_Position.z - player_chunk_z));
+			return distance_a > distance_b;
+		});
+
+		int unloaded_chunks = 0;
+		int written_chunks = 0;
+
+		for (Chunk* chunk : unload_candidates)
+		{
+			if (memory_usage <= m_ChunkMemoryBudget)
+			{
+				break;
+			}
+
+			if ((chunk->p_ChunkState == ChunkState::Changed || chunk->p_LightMapState == ChunkLightMapState::ModifiedLightMap) && !chunk->p_ReadOnly)
+			{
+				if (m_ChunkDirectory.empty())
+				{
+					continue;
+				}
+
+				std::filesystem::create_directories(m_ChunkDirectory);
+				m_ChunkSaver.QueueChunk(chunk, m_ChunkDirectory, m_ChunkSaveOptions);
+				written_chunks++;
+			}
+
+			memory_usage -= EstimateChunkMemoryUsage(*chunk);
+			m_WorldChunks.Erase(static_cast<int>(chunk->p_Position.x), static_cast<int>(chunk->p_Position.z));
+			m_ChunkCount--;
+			unloaded_chunks++;
+		}
+
+		std::stringstream str;
+		str << "Unloaded " << unloaded_chunks << " chunks (" << written_chunks << " queued for saving) | Chunk memory : " << memory_usage / (1024 * 1024) << " MB";
+		Logger::LogToConsole(str.str());
+	}
+
+	/*
+		Reads a chunk from the save or generates it. Called on the chunk generator threads, 
+		it only uses the chunk saver and the region files which have their own locks
+	*/
+	void World::_FillChunk(Chunk* chunk)
+	{
+		if (!_ReadUnloadedChunk(chunk))
+		{
+			GenerateChunk(chunk, m_WorldSeed, m_WorldGenType);
+			chunk->p_ChunkState = ChunkState::Generated;
+		}
+	}
+
+	/*
+		Adds the chunks that the chunk generator finished to the chunk map
+	*/
+	void World::_AddGeneratedChunks()
+	{
+		std::vector<std::unique_ptr<Chunk>> generated_chunks;
+		m_ChunkGenerator.TakeFinishedChunks(generated_chunks);
+
+		for (std::unique_ptr<Chunk>& chunk : generated_chunks)
+		{
+			const int cx = static_cast<int>(chunk->p_Position.x);
+			const int cz = static_cast<int>(chunk->p_Position.z);
+
+			chunk->p_LastUsedFrame = m_CurrentFrame;
+
+			// Fails if the chunk was made on the main thread while it was being generated, the generated copy is dropped
+			if (m_WorldChunks.Insert(cx, cz, std::move(chunk)))
+			{
+				m_ChunkCount++;
+				_PullNeighbourLight(FindChunk(cx, cz));
+			}
+		}
+
+		PropogateLight();
+		PropogateSkyLight();
+	}
+
+	/*
+		The light of a lamp near the edge of a chunk skips the neighbours that weren't generated yet.
+		Queues the lit border blocks of the loaded neighbours so PropogateLight() spreads that light in to the new chunk.
+		The sky light of every chunk was computed on its own, the brighter side of the border blocks is queued both ways for PropogateSkyLight()
+	*/
+	void World::_PullNeighbourLight(Chunk* chunk)
+	{
+		const int cx = static_cast<int>(chunk->p_Position.x);
+		const int cz = static_cast<int>(chunk->p_Position.z);
+
+		Chunk* front_chunk = FindChunk(cx, cz + 1);
+		Chunk* back_chunk = FindChunk(cx, cz - 1);
+		Chunk* right_chunk = FindChunk(cx + 1, cz);
+		Chunk* left_chunk = FindChunk(cx - 1, cz);
+
+		// Light that is 1 wouldn't reach any further. Most sections were never lit, they are uniform and 0 and are skipped at once
+		auto can_spread = [](const Chunk* neighbour, int section)
+		{
+			const SectionLightMap& light = neighbour->p_Sections[section].p_Light;
+			return !light.IsUniform() || light.GetUniformValue() > 1;
+		};
+
+		for (int i = 0; i < CHUNK_SECTION_COUNT; i++)
+		{
+			const int base_y = i * CHUNK_SECTION_SIZE_Y;
+			const int height = std::min(CHUNK_SECTION_SIZE_Y, CHUNK_SIZE_Y - base_y);
+
+			const bool left = left_chunk && can_spread(left_chunk, i);
+			const bool right = right_chunk && can_spread(right_chunk, i);
+			const bool back = back_chunk && can_spread(back_chunk, i);
+			const bool front = front_chunk && can_spread(front_chunk, i);
+
+			for (int y = base_y; y < base_y + height; y++)
+			{
+				for (int j = 0; j < CHUNK_SIZE_X; j++)
+				{
+					if (left && left_chunk->GetTorchLightAt(CHUNK_SIZE_X - 1, y, j) > 1)
+					{
+						m_LightBFSQueue.push({ glm::vec3(CHUNK_SIZE_X - 1, y, j), left_chunk });
+					}
+
+					if (right && right_chunk->GetTorchLightAt(0, y, j) > 1)
+					{
+						m_LightBFSQueue.push({ glm::vec3(0, y, j), right_chunk });
+					}
+
+					if (back && back_chunk->GetTorchLightAt(j, y, CHUNK_SIZE_Z - 1) > 1)
+					{
+						m_LightBFSQueue.push({ glm::vec3(j, y, CHUNK_SIZE_Z - 1), back_chunk });
+					}
+
+					if (front && front_chunk->GetTorchLightAt(j, y, 0) > 1)
+					{
+						m_LightBFSQueue.push({ glm::vec3(j, y, 0), front_chunk });
+					}
+				}
+			}
+		}
+
+		// The border of the chunk starts at start and the border of the neighbour at neighbour_start, both run along step.
+		// The sections that are uniform on both sides and within 1 of each other (open sky, solid ground) are skipped at once
+		auto even_sky_light = [this, chunk](Chunk* neighbour, glm::ivec2 start, glm::ivec2 neighbour_start, glm::ivec2 step)
+		{
+			if (!neighbour)
+			{
+				return;
+			}
+
+			for (int i = 0; i < CHUNK_SECTION_COUNT; i++)
+			{
+				const SectionLightMap& sky = chunk->p_Sections[i].p_SkyLight;
+				const SectionLightMap& neighbour_sky = neighbour->p_Sections[i].p_SkyLight;
+				const int base_y = i * CHUNK_SECTION_SIZE_Y;
+				const int height = std::min(CHUNK_SECTION_SIZE_Y, CHUNK_SIZE_Y - base_y);
+
+				if (sky.IsUniform() && neighbour_sky.IsUniform() && std::abs(sky.GetUniformValue() - neighbour_sky.GetUniformValue()) < 2)
+				{
+					continue;
+				}
+
+				for (int y = base_y; y < base_y + height; y++)
+				{
+					for (int j = 0; j < CHUNK_SIZE_X; j++)
+					{
+						const glm::ivec2 block = start + step * j;
+						const glm::ivec2 neighbour_block = neighbour_start + step * j;
+						const int light = chunk->GetSkyLightAt(block.x, y, block.y);
+						const int neighbour_light = neighbour->GetSkyLightAt(neighbour_block.x, y, neighbour_block.y);
+
+						if (light > neighbour_light + 1)
+						{
+							m_SkyLightBFSQueue.push({ glm::vec3(block.x, y, block.y), chunk });
+						}
+
+						else if (neighbour_light > light + 1)
+						{
+							m_SkyLightBFSQueue.push({ glm::vec3(neighbour_block.x, y, neighbour_block.y), neighbour });
+						}
+					}
+				}
+			}
+		};
+
+		even_sky_light(left_chunk, glm::ivec2(0, 0), glm::ivec2(CHUNK_SIZE_X - 1, 0), glm::ivec2(0, 1));
+		even_sky_light(right_chunk, glm::ivec2(CHUNK_SIZE_X - 1, 0), glm::ivec2(0, 0), glm::ivec2(0, 1));
+		even_sky_light(back_chunk, glm::ivec2(0, 0), glm::ivec2(0, CHUNK_SIZE_Z - 1), glm::ivec2(1, 0));
+		even_sky_light(front_chunk, glm::ivec2(0, CHUNK_SIZE_Z - 1), glm::ivec2(0, 0), glm::ivec2(1, 0));
+	}
+
+	/*
+		Moves a position local to chunk that is past one of its edges in to the neighbour that holds it.
+		Returns the chunk of the position, nullptr if that chunk isn't loaded or the position is above or below the world
+	*/
+	Chunk* World::_GetBlockChunk(Chunk* chunk, glm::ivec3& position)
+	{
+		if (position.y < 0 || position.y >= CHUNK_SIZE_Y)
+		{
+			return nullptr;
+		}
+
+		int cx = static_cast<int>(chunk->p_Position.x);
+		int cz = static_cast<int>(chunk->p_Position.z);
+
+		if (position.x < 0 || position.x >= CHUNK_SIZE_X || position.z < 0 || position.z >= CHUNK_SIZE_Z)
+		{
+			if (position.x < 0) { cx--; position.x += CHUNK_SIZE_X; }
+			else if (position.x >= CHUNK_SIZE_X) { cx++; position.x -= CHUNK_SIZE_X; }
+
+			if (position.z < 0) { cz--; position.z += CHUNK_SIZE_Z; }
+			else if (position.z >= CHUNK_SIZE_Z) { cz++; position.z -= CHUNK_SIZE_Z; }
+
+			return FindChunk(cx, cz);
+		}
+
+		return chunk;
+	}
+
+	/*
+		Copies every changed chunk for the chunk saver, the copies are written on its thread.
+		The chunks count as saved from here on, a later change marks them again
+	*/
+	size_t World::QueueChangedChunks(const std::string& dir)
+	{
+		size_t queued_chunks = 0;
+
+		m_WorldChunks.ForEach([&](Chunk& chunk)
+		{
+			// The light of a read only chunk can change with its neighbours, it is still never written
+			if ((chunk.p_ChunkState == ChunkState::Changed || chunk.p_LightMapState == ChunkLightMapState::ModifiedLightMap) && !chunk.p_ReadOnly)
+			{
+				m_ChunkSaver.QueueChunk(&chunk, dir, m_ChunkSaveOptions);
+
+				chunk.p_ChunkState = ChunkState::Generated;
+				chunk.p_LightMapState = ChunkLightMapState::UnmodifiedLightMap;
+				queued_chunks++;
+			}
+		});
+
+		return queued_chunks;
+	}
+
+	/*
+		Reads a chunk that was written to the chunk directory when it was unloaded (or when the world was saved).
+		This is the only place saved chunks are read, they are faulted in as the player gets close to them.
+		A chunk the saver hasn't written yet is taken from its snapshot.
+		Returns false if the chunk isn't saved and it has to be generated
+	*/
+	bool World::_ReadUnloadedChunk(Chunk* chunk)
+	{
+		if (m_ChunkDirectory.empty())
+		{
+			return false;
+		}
+
+		if (!m_ChunkSaver.ReadPendingChunk(chunk) && !ChunkFileHandler::ReadChunk(chunk, m_ChunkDirectory, m_ChunkSaveOptions))
+		{
+			return false;
+		}
+
+		// The flora was already generated before the chunk was written
+		chunk->p_ChunkState = ChunkState::Generated;
+		return true;
 	}
 
 	/*
@@ -510,15 +987,15 @@ namespace Omnia
 
 			if (position.y >= 0 && position.y < CHUNK_SIZE_Y)
 			{
-				std::pair<Block*, Chunk*> ray_hitblock = GetBlockFromPosition(glm::vec3(
+				std::pair<Block, Chunk*> ray_hitblock = GetBlockFromPosition(glm::vec3(
 					floor(position.x),
 					floor(position.y),
 					floor(position.z)
 				));
 
-				Block* ray_block = ray_hitblock.first;
+				const Block& ray_block = ray_hitblock.first;
 
-				if (ray_block != nullptr && ray_block->p_BlockType != BlockType::Air && ray_block->IsLiquid() == false)
+				if (ray_block.p_BlockType != BlockType::Air && ray_block.IsLiquid() == false)
 				{
 					glm::vec3 normal;
 
@@ -537,21 +1014,32 @@ namespace Omnia
 						position = position + normal;
 					}
 
-					std::pair<Block*, Chunk*> edit_block;
+					std::pair<Block, Chunk*> edit_block;
 
 					if (position.y >= 0 && position.y < CHUNK_SIZE_Y)
 					{
 						edit_block = GetBlockFromPosition(glm::vec3(position.x, position.y, position.z));
+
+						// A read only chunk keeps changes that couldn't be applied, editing and saving it would overwrite them
+						if (!edit_block.second || edit_block.second->p_ReadOnly)
+						{
+							return;
+						}
+
 						glm::ivec3 local_block_pos = WorldBlockToLocalBlockCoordinates(position);
 						glm::vec2 chunk_pos = glm::vec2(edit_block.second->p_Position.x, edit_block.second->p_Position.z);
 
-						Chunk* front_chunk = RetrieveChunkFromMap(chunk_pos.x, chunk_pos.y + 1);
-						Chunk* back_chunk = RetrieveChunkFromMap(chunk_pos.x, chunk_pos.y - 1);
-						Chunk* right_chunk = RetrieveChunkFromMap(chunk_pos.x + 1, chunk_pos.y);
-						Chunk* left_chunk = RetrieveChunkFromMap(chunk_pos.x - 1, chunk_pos.y);
+						Chunk* front_chunk = FindChunk(chunk_pos.x, chunk_pos.y + 1);
+						Chunk* back_chunk = FindChunk(chunk_pos.x, chunk_pos.y - 1);
+						Chunk* right_chunk = FindChunk(chunk_pos.x + 1, chunk_pos.y);
+						Chunk* left_chunk = FindChunk(chunk_pos.x - 1, chunk_pos.y);
 
 						BlockType snd_type;
 
+						// The sky light is updated from what the edit changed in the column
+						const int old_caster_height = edit_block.second->GetShadowCasterHeight(local_block_pos.x, local_block_pos.z);
+						const bool old_casts_shadow = edit_block.first.CastsShadow();
+
 						if (place && !TestRayPlayerCollision(position))
 						{
 							/*
@@ -635,8 +1123,9 @@ namespace Omnia
 
 							/* Lighting calculations end here */
 
-							edit_block.first->p_BlockType = static_cast<BlockType>(p_Player->p_CurrentHeldBlock);
-							snd_type = edit_block.first->p_BlockType;
+							edit_block.first.p_BlockType = static_cast<BlockType>(p_Player->p_CurrentHeldBlock);
+							edit_block.second->SetBlock(local_block_pos.x, local_block_pos.y, local_block_pos.z, edit_block.first.p_BlockType);
+							snd_type = edit_block.first.p_BlockType;
 
 							if (static_cast<BlockType>(p_Player->p_CurrentHeldBlock) == BlockType::Lamp_On)
 							{
@@ -709,11 +1198,11 @@ namespace Omnia
 								m_LightBFSQueue.push({ glm::vec3(local_block_pos.x, local_block_pos.y + 1, local_block_pos.z), edit_block.second });
 							}
 
-							snd_type = edit_block.first->p_BlockType;
+							snd_type = edit_block.first.p_BlockType;
 
 							/* Lighting calculations end here */
 
-							if (edit_block.first->p_BlockType == BlockType::Lamp_On)
+							if (edit_block.first.p_BlockType == BlockType::Lamp_On)
 							{
 								m_LightRemovalBFSQueue.push({ glm::vec3(local_block_pos.x, local_block_pos.y, local_block_pos.z),
 									edit_block.second->GetTorchLightAt(local_block_pos.x, local_block_pos.y, local_block_pos.z),
@@ -722,7 +1211,7 @@ namespace Omnia
 								edit_block.second->SetTorchLightAt(local_block_pos.x, local_block_pos.y, local_block_pos.z, 0);
 							}
 
-							else if (edit_block.first->p_BlockType == BlockType::Bedrock)
+							else if (edit_block.first.p_BlockType == BlockType::Bedrock)
 							{
 								return;
 							}
@@ -732,7 +1221,9 @@ namespace Omnia
 							*/
 							if (local_block_pos.y >= 0 && local_block_pos.y < CHUNK_SIZE_Y - 1)
 							{
-								if (edit_block.second->p_ChunkContents.at(local_block_pos.x).at(local_block_pos.y + 1).at(local_block_pos.z).DependsOnBelowBlock())
+								Block above_block = edit_block.second->GetBlock(local_block_pos.x, local_block_pos.y + 1, local_block_pos.z);
+
+								if (above_block.DependsOnBelowBlock())
 								{
 									// Create the particles for that model
 
@@ -745,19 +1236,19 @@ namespace Omnia
 									particle_pos.z += 0.5f;
 
 									m_ParticleEmitter.EmitParticlesAt(10, 40,
-										particle_pos, glm::vec3(5, 5, 5), glm::vec3(0.06f, 1, 0.06f), edit_block.second->p_ChunkContents.at(local_block_pos.x).at(local_block_pos.y + 1).at(local_block_pos.z).p_BlockType);
+										particle_pos, glm::vec3(5, 5, 5), glm::vec3(0.06f, 1, 0.06f), above_block.p_BlockType);
 
 									// play the sound for that model
 									/* Play the block sound */
 									_PlayBlockSound(snd_type, glm::vec3(position.x, position.y + 1, position.z));
 
-									edit_block.second->p_ChunkContents.at(local_block_pos.x).at(local_block_pos.y + 1).at(local_block_pos.z).p_BlockType = BlockType::Air;
+									edit_block.second->SetBlock(local_block_pos.x, local_block_pos.y + 1, local_block_pos.z, BlockType::Air);
 								}
 							}
 
 							// Emit particles at the block position
 
-							if (edit_block.first->p_BlockType != BlockType::Air)
+							if (edit_block.first.p_BlockType != BlockType::Air)
 							{
 								glm::vec3 particle_pos;
 								particle_pos.x = floor(position.x);
@@ -768,40 +1259,59 @@ namespace Omnia
 								particle_pos.z += 0.5f;
 
 								m_ParticleEmitter.EmitParticlesAt(10, 40,
-									particle_pos, glm::vec3(5, 5, 5), glm::vec3(0.06f, 1, 0.06f), edit_block.first->p_BlockType);
+									particle_pos, glm::vec3(5, 5, 5), glm::vec3(0.06f, 1, 0.06f), edit_block.first.p_BlockType);
 							}
 
-							edit_block.first->p_BlockType = BlockType::Air;
+							edit_block.second->SetBlock(local_block_pos.x, local_block_pos.y, local_block_pos.z, BlockType::Air);
 							UpdateLights();
 						}
 
-						edit_block.second->p_MeshState = ChunkMeshState::Unbuilt;
+						// The edit can also change the sky light and so the shadows on the top faces below it
+						edit_block.second->SetMeshDirty(local_block_pos.y, local_block_pos.y);
+						_UpdateEditSkyLight(edit_block.second, local_block_pos, old_caster_height, old_casts_shadow);
 
 						/*
-						Check if the edited block was on one of the chunk edges, if it was change the respective neighbouring chunk's mesh state
+						Check if the edited block was on one of the chunk edges, if it was change the respective neighbouring chunk's mesh state.
+						The neighbour can still be waiting in the chunk generator, it is meshed with the edit when it arrives
 						*/
 						if (local_block_pos.x <= 0)
 						{
-							Chunk* update_chunk = RetrieveChunkFromMap(edit_block.second->p_Position.x - 1, edit_block.second->p_Position.z);
-							update_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+							Chunk* update_chunk = FindChunk(edit_block.second->p_Position.x - 1, edit_block.second->p_Position.z);
+
+							if (update_chunk)
+							{
+								update_chunk->SetMeshDirty(local_block_pos.y, local_block_pos.y);
+							}
 						}
 
 						if (local_block_pos.z <= 0)
 						{
-							Chunk* update_chunk = RetrieveChunkFromMap(edit_block.second->p_Position.x, edit_block.second->p_Position.z - 1);
-							update_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+							Chunk* update_chunk = FindChunk(edit_block.second->p_Position.x, edit_block.second->p_Position.z - 1);
+
+							if (update_chunk)
+							{
+								update_chunk->SetMeshDirty(local_block_pos.y, local_block_pos.y);
+							}
 						}
 
 						if (local_block_pos.x >= CHUNK_SIZE_X - 1)
 						{
-							Chunk* update_chunk = RetrieveChunkFromMap(edit_block.second->p_Position.x + 1, edit_block.second->p_Position.z);
-							update_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+							Chunk* update_chunk = FindChunk(edit_block.second->p_Position.x + 1, edit_block.second->p_Position.z);
+
+							if (update_chunk)
+							{
+								update_chunk->SetMeshDirty(local_block_pos.y, local_block_pos.y);
+							}
 						}
 
 						if (local_block_pos.z >= CHUNK_SIZE_Z - 1)
 						{
-							Chunk* update_chunk = RetrieveChunkFromMap(edit_block.second->p_Position.x, edit_block.second->p_Position.z + 1);
-							update_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+							Chunk* update_chunk = FindChunk(edit_block.second->p_Position.x, edit_block.second->p_Position.z + 1);
+
+							if (update_chunk)
+							{
+								update_chunk->SetMeshDirty(local_block_pos.y, local_block_pos.y);
+							}
 						}
 
 						edit_block.second->p_ChunkState = ChunkState::Changed;
@@ -818,6 +1328,8 @@ namespace Omnia
 
 	/*
 		Goes through the bfs queue and propogates the light through the air blocks in the required chunks.
+		The neighbours in another section (above, below or in the next chunk) can be in a uniform section that stops the light, 
+		those are skipped as a whole without reading their block (see Chunk::IsSectionLightProof())
 	*/
 	void World::PropogateLight()
 	{
@@ -830,6 +1342,12 @@ namespace Omnia
 			// Pop the element after storing it's data
 			m_LightBFSQueue.pop();
 
+			// A node in a neighbour that isn't generated yet, the light is pulled in when it arrives (see _AddGeneratedChunks())
+			if (!chunk)
+			{
+				continue;
+			}
+
 			int light_level = 0;
 
 			if (pos.x >= 0 && pos.x < CHUNK_SIZE_X &&
@@ -839,132 +1357,139 @@ namespace Omnia
 				light_level = chunk->GetTorchLightAt(pos.x, pos.y, pos.z);
 			}
 
+			// A neighbour is only lit when it ends up 2 levels darker than the node, nothing spreads from level 1 and below
+			if (light_level <= 1)
+			{
+				continue;
+			}
+
 			int x = floor(pos.x);
 			int y = floor(pos.y);
 			int z = floor(pos.z);
 
 			glm::vec3 chunk_pos = chunk->p_Position;
-			Chunk* front_chunk = RetrieveChunkFromMap(chunk_pos.x, chunk_pos.z + 1);
-			Chunk* back_chunk = RetrieveChunkFromMap(chunk_pos.x, chunk_pos.z - 1);
-			Chunk* right_chunk = RetrieveChunkFromMap(chunk_pos.x + 1, chunk_pos.z);
-			Chunk* left_chunk = RetrieveChunkFromMap(chunk_pos.x - 1, chunk_pos.z);
+			Chunk* front_chunk = FindChunk(chunk_pos.x, chunk_pos.z + 1);
+			Chunk* back_chunk = FindChunk(chunk_pos.x, chunk_pos.z - 1);
+			Chunk* right_chunk = FindChunk(chunk_pos.x + 1, chunk_pos.z);
+			Chunk* left_chunk = FindChunk(chunk_pos.x - 1, chunk_pos.z);
 
 			// For lighting on chunk corners
 
 			if (x > 0)
 			{
-				if (chunk->GetBlock(x - 1, y, z)->IsLightPropogatable() && chunk->GetTorchLightAt(x - 1, y, z) + 2 <= light_level)
+				if (chunk->GetBlock(x - 1, y, z).IsLightPropogatable() && chunk->GetTorchLightAt(x - 1, y, z) + 2 <= light_level)
 				{
 					chunk->SetTorchLightAt(x - 1, y, z, light_level - 1);
 					m_LightBFSQueue.push({ glm::vec3(x - 1, y, z), chunk });
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
-			else if (x <= 0)
+			else if (x <= 0 && left_chunk)
 			{
-				if (left_chunk->GetBlock(CHUNK_SIZE_X - 1, y, z)->IsLightPropogatable() && left_chunk->GetTorchLightAt(CHUNK_SIZE_X - 1, y, z) + 2 <= light_level)
+				if (!left_chunk->IsSectionLightProof(y) && left_chunk->GetBlock(CHUNK_SIZE_X - 1, y, z).IsLightPropogatable() && left_chunk->GetTorchLightAt(CHUNK_SIZE_X - 1, y, z) + 2 <= light_level)
 				{
 					left_chunk->SetTorchLightAt(CHUNK_SIZE_X - 1, y, z, light_level - 1);
 					m_LightBFSQueue.push({ glm::vec3(CHUNK_SIZE_X - 1, y, z), left_chunk });
 				}
 
-				left_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				left_chunk->SetMeshDirty(y, y);
 			}
 
 			if (x < CHUNK_SIZE_X - 1)
 			{
-				if (chunk->GetBlock(x + 1, y, z)->IsLightPropogatable() && chunk->GetTorchLightAt(x + 1, y, z) + 2 <= light_level)
+				if (chunk->GetBlock(x + 1, y, z).IsLightPropogatable() && chunk->GetTorchLightAt(x + 1, y, z) + 2 <= light_level)
 				{
 					chunk->SetTorchLightAt(x + 1, y, z, light_level - 1);
 					m_LightBFSQueue.push({ glm::vec3(x + 1, y, z), chunk });
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
-			else if (x >= CHUNK_SIZE_X - 1)
+			else if (x >= CHUNK_SIZE_X - 1 && right_chunk)
 			{
-				if (right_chunk->GetBlock(0, y, z)->IsLightPropogatable() && right_chunk->GetTorchLightAt(0, y, z) + 2 <= light_level)
+				if (!right_chunk->IsSectionLightProof(y) && right_chunk->GetBlock(0, y, z).IsLightPropogatable() && right_chunk->GetTorchLightAt(0, y, z) + 2 <= light_level)
 				{
 					right_chunk->SetTorchLightAt(0, y, z, light_level - 1);
 					m_LightBFSQueue.push({ glm::vec3(0, y, z), right_chunk });
 				}
 
-				right_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				right_chunk->SetMeshDirty(y, y);
 			}
 
 			if (y > 0)
 			{
-				if (chunk->GetBlock(x, y - 1, z)->IsLightPropogatable() && chunk->GetTorchLightAt(x, y - 1, z) + 2 <= light_level)
+				if (!chunk->IsSectionLightProof(y - 1) && chunk->GetBlock(x, y - 1, z).IsLightPropogatable() && chunk->GetTorchLightAt(x, y - 1, z) + 2 <= light_level)
 				{
 					chunk->SetTorchLightAt(x, y - 1, z, light_level - 1);
 					m_LightBFSQueue.push({ glm::vec3(x, y - 1, z), chunk });
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
 			if (y < CHUNK_SIZE_Y - 1)
 			{
-				if (chunk->GetBlock(x, y + 1, z)->IsLightPropogatable() && chunk->GetTorchLightAt(x, y + 1, z) + 2 <= light_level)
+				if (!chunk->IsSectionLightProof(y + 1) && chunk->GetBlock(x, y + 1, z).IsLightPropogatable() && chunk->GetTorchLightAt(x, y + 1, z) + 2 <= light_level)
 				{
 					chunk->SetTorchLightAt(x, y + 1, z, light_level - 1);
 					m_LightBFSQueue.push({ glm::vec3(x, y + 1, z), chunk });
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
 			if (z > 0)
 			{
-				if (chunk->GetBlock(x, y, z - 1)->IsLightPropogatable() && chunk->GetTorchLightAt(x, y, z - 1) + 2 <= light_level)
+				if (chunk->GetBlock(x, y, z - 1).IsLightPropogatable() && chunk->GetTorchLightAt(x, y, z - 1) + 2 <= light_level)
 				{
 					chunk->SetTorchLightAt(x, y, z - 1, light_level - 1);
 					m_LightBFSQueue.push({ glm::vec3(x, y, z - 1), chunk });
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
-			else if (z <= 0)
+			else if (z <= 0 && back_chunk)
 			{
-				if (back_chunk->GetBlock(x, y, CHUNK_SIZE_Z - 1)->IsLightPropogatable() && back_chunk->GetTorchLightAt(x, y, CHUNK_SIZE_Z - 1) + 2 <= light_level)
+				if (!back_chunk->IsSectionLightProof(y) && back_chunk->GetBlock(x, y, CHUNK_SIZE_Z - 1).IsLightPropogatable() && back_chunk->GetTorchLightAt(x, y, CHUNK_SIZE_Z - 1) + 2 <= light_level)
 				{
 					back_chunk->SetTorchLightAt(x, y, CHUNK_SIZE_Z - 1, light_level - 1);
 					m_LightBFSQueue.push({ glm::vec3(x, y, CHUNK_SIZE_Z - 1), back_chunk });
 				}
 
-				back_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				back_chunk->SetMeshDirty(y, y);
 			}
 
 			if (z < CHUNK_SIZE_Z - 1)
 			{
-				if (chunk->GetBlock(x, y, z + 1)->IsLightPropogatable() && chunk->GetTorchLightAt(x, y, z + 1) + 2 <= light_level)
+				if (chunk->GetBlock(x, y, z + 1).IsLightPropogatable() && chunk->GetTorchLightAt(x, y, z + 1) + 2 <= light_level)
 				{
 					chunk->SetTorchLightAt(x, y, z + 1, light_level - 1);
 					m_LightBFSQueue.push({ glm::vec3(x, y, z + 1), chunk });
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
-			else if (z >= CHUNK_SIZE_Z - 1)
+			else if (z >= CHUNK_SIZE_Z - 1 && front_chunk)
 			{
-				if (front_chunk->GetBlock(x, y, 0)->IsLightPropogatable() && front_chunk->GetTorchLightAt(x, y, 0) + 2 <= light_level)
+				if (!front_chunk->IsSectionLightProof(y) && front_chunk->GetBlock(x, y, 0).IsLightPropogatable() && front_chunk->GetTorchLightAt(x, y, 0) + 2 <= light_level)
 				{
 					front_chunk->SetTorchLightAt(x, y, 0, light_level - 1);
 					m_LightBFSQueue.push({ glm::vec3(x, y, 0), front_chunk });
 				}
 
-				front_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				front_chunk->SetMeshDirty(y, y);
 			}
 		}
 	}
 
 	/*
-	Goes through the bfs queue and removes the required lights at the required chunks
+	Goes through the bfs queue and removes the required lights at the required chunks.
+	The neighbours in another section that was never lit are skipped without reading their light (see Chunk::IsSectionUnlit())
 	*/
 	void World::RemoveLight()
 	{
@@ -977,17 +1502,23 @@ namespace Omnia
 			int y = node.p_Position.y;
 			int z = node.p_Position.z;
 			int light_level = (int)node.p_LightValue;
-			glm::vec3 chunk_pos = node.p_Chunk->p_Position;
 			Chunk* chunk = node.p_Chunk;
 
-			Chunk* front_chunk = RetrieveChunkFromMap(chunk_pos.x, chunk_pos.z + 1);
-			Chunk* back_chunk = RetrieveChunkFromMap(chunk_pos.x, chunk_pos.z - 1);
-			Chunk* right_chunk = RetrieveChunkFromMap(chunk_pos.x + 1, chunk_pos.z);
-			Chunk* left_chunk = RetrieveChunkFromMap(chunk_pos.x - 1, chunk_pos.z);
-
 			// Pop the front element
 			m_LightRemovalBFSQueue.pop();
 
+			// A node in a neighbour that isn't generated yet, it has no light to remove
+			if (!chunk)
+			{
+				continue;
+			}
+
+			glm::vec3 chunk_pos = chunk->p_Position;
+			Chunk* front_chunk = FindChunk(chunk_pos.x, chunk_pos.z + 1);
+			Chunk* back_chunk = FindChunk(chunk_pos.x, chunk_pos.z - 1);
+			Chunk* right_chunk = FindChunk(chunk_pos.x + 1, chunk_pos.z);
+			Chunk* left_chunk = FindChunk(chunk_pos.x - 1, chunk_pos.z);
+
 			if (x > 0)
 			{
 				int neighbor_level = chunk->GetTorchLightAt(x - 1, y, z);
@@ -1003,12 +1534,12 @@ namespace Omnia
 					m_LightBFSQueue.emplace(glm::vec3(x - 1, y, z), chunk);
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
-			else if (x == 0)
+			else if (x == 0 && left_chunk)
 			{
-				int neighbor_level = left_chunk->GetTorchLightAt(CHUNK_SIZE_X - 1, y, z);
+				int neighbor_level = left_chunk->IsSectionUnlit(y) ? 0 : left_chunk->GetTorchLightAt(CHUNK_SIZE_X - 1, y, z);
 
 				if (neighbor_level != 0 && neighbor_level < light_level)
 				{
@@ -1021,7 +1552,7 @@ namespace Omnia
 					m_LightBFSQueue.emplace(glm::vec3(CHUNK_SIZE_X - 1, y, z), left_chunk);
 				}
 
-				left_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				left_chunk->SetMeshDirty(y, y);
 			}
 
 			if (x < CHUNK_SIZE_X - 1)
@@ -1039,12 +1570,12 @@ namespace Omnia
 					m_LightBFSQueue.emplace(glm::vec3(x + 1, y, z), chunk);
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
-			else if (x == CHUNK_SIZE_X - 1)
+			else if (x == CHUNK_SIZE_X - 1 && right_chunk)
 			{
-				int neighbor_level = right_chunk->GetTorchLightAt(0, y, z);
+				int neighbor_level = right_chunk->IsSectionUnlit(y) ? 0 : right_chunk->GetTorchLightAt(0, y, z);
 
 				if (neighbor_level != 0 && neighbor_level < light_level)
 				{
@@ -1057,12 +1588,12 @@ namespace Omnia
 					m_LightBFSQueue.emplace(glm::vec3(0, y, z), right_chunk);
 				}
 
-				right_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				right_chunk->SetMeshDirty(y, y);
 			}
 
 			if (y > 0)
 			{
-				int neighbor_level = chunk->GetTorchLightAt(x, y - 1, z);
+				int neighbor_level = chunk->IsSectionUnlit(y - 1) ? 0 : chunk->GetTorchLightAt(x, y - 1, z);
 
 				if (neighbor_level != 0 && neighbor_level < light_level)
 				{
@@ -1075,12 +1606,12 @@ namespace Omnia
 					m_LightBFSQueue.emplace(glm::vec3(x, y - 1, z), chunk);
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
 			if (y < CHUNK_SIZE_Y - 1)
 			{
-				int neighbor_level = chunk->GetTorchLightAt(x, y + 1, z);
+				int neighbor_level = chunk->IsSectionUnlit(y + 1) ? 0 : chunk->GetTorchLightAt(x, y + 1, z);
 
 				if (neighbor_level != 0 && neighbor_level < light_level)
 				{
@@ -1093,7 +1624,7 @@ namespace Omnia
 					m_LightBFSQueue.emplace(glm::vec3(x, y + 1, z), chunk);
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
 			if (z > 0)
@@ -1111,12 +1642,12 @@ namespace Omnia
 					m_LightBFSQueue.emplace(glm::vec3(x, y, z - 1), chunk);
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
-			else if (z == 0)
+			else if (z == 0 && back_chunk)
 			{
-				int neighbor_level = back_chunk->GetTorchLightAt(x, y, CHUNK_SIZE_Z - 1);
+				int neighbor_level = back_chunk->IsSectionUnlit(y) ? 0 : back_chunk->GetTorchLightAt(x, y, CHUNK_SIZE_Z - 1);
 
 				if (neighbor_level != 0 && neighbor_level < light_level)
 				{
@@ -1129,7 +1660,7 @@ namespace Omnia
 					m_LightBFSQueue.emplace(glm::vec3(x, y, CHUNK_SIZE_Z - 1), back_chunk);
 				}
 
-				back_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				back_chunk->SetMeshDirty(y, y);
 			}
 
 			if (z < CHUNK_SIZE_Z - 1)
@@ -1147,12 +1678,12 @@ namespace Omnia
 					m_LightBFSQueue.emplace(glm::vec3(x, y, z + 1), chunk);
 				}
 
-				chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				chunk->SetMeshDirty(y, y);
 			}
 
-			else if (z == CHUNK_SIZE_Z - 1)
+			else if (z == CHUNK_SIZE_Z - 1 && front_chunk)
 			{
-				int neighbor_level = front_chunk->GetTorchLightAt(x, y, 0);
+				int neighbor_level = front_chunk->IsSectionUnlit(y) ? 0 : front_chunk->GetTorchLightAt(x, y, 0);
 
 				if (neighbor_level != 0 && neighbor_level < light_level)
 				{
@@ -1165,7 +1696,7 @@ namespace Omnia
 					m_LightBFSQueue.emplace(glm::vec3(x, y, 0), front_chunk);
 				}
 
-				front_chunk->p_MeshState = ChunkMeshState::Unbuilt;
+				front_chunk->SetMeshDirty(y, y);
 			}
 		}
 	}
@@ -1181,18 +1712,172 @@ namespace Omnia
 	}
 
 	/*
-		Checks if the chunk exists in the chunk map
+		Spreads the sky light from the nodes in the sky light bfs queue, across the chunk borders like PropogateLight().
+		It goes through the blocks that don't cast shadows and drops by one per block, the same as Chunk::UpdateSkyLight()
 	*/
-	bool World::ChunkExistsInMap(int cx, int cz)
+	void World::PropogateSkyLight()
 	{
-		std::map<std::pair<int, int>, Chunk>::iterator chunk_exists = m_WorldChunks.find(std::pair<int, int>(cx, cz));
+		static const glm::ivec3 Directions[6] = { glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0), glm::ivec3(0, 1, 0),
+			glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1) };
 
-		if (chunk_exists == m_WorldChunks.end())
+		while (!m_SkyLightBFSQueue.empty())
 		{
-			return false;
+			const LightNode node = m_SkyLightBFSQueue.front();
+			m_SkyLightBFSQueue.pop();
+
+			if (!node.p_Chunk)
+			{
+				continue;
+			}
+
+			const glm::ivec3 position = glm::ivec3(node.p_Position);
+			const int light_level = node.p_Chunk->GetSkyLightAt(position.x, position.y, position.z);
+
+			if (light_level <= 1)
+			{
+				continue;
+			}
+
+			for (const glm::ivec3& direction : Directions)
+			{
+				glm::ivec3 neighbour = position + direction;
+				Chunk* neighbour_chunk = _GetBlockChunk(node.p_Chunk, neighbour);
+
+				if (neighbour_chunk && neighbour_chunk->GetSkyLightAt(neighbour.x, neighbour.y, neighbour.z) + 2 <= light_level &&
+					!neighbour_chunk->GetBlock(neighbour.x, neighbour.y, neighbour.z).CastsShadow())
+				{
+					neighbour_chunk->SetSkyLightAt(neighbour.x, neighbour.y, neighbour.z, light_level - 1);
+					neighbour_chunk->SetMeshDirty(neighbour.y, neighbour.y);
+					m_SkyLightBFSQueue.push({ glm::vec3(neighbour), neighbour_chunk });
+				}
+			}
 		}
+	}
 
-		return true;
+	/*
+		Removes the sky light that came from the nodes in the sky light removal queue, like RemoveLight().
+		The neighbours that are lit from somewhere else are queued for PropogateSkyLight() to fill the gap again
+	*/
+	void World::RemoveSkyLight()
+	{
+		static const glm::ivec3 Directions[6] = { glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0), glm::ivec3(0, 1, 0),
+			glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1) };
+
+		while (!m_SkyLightRemovalBFSQueue.empty())
+		{
+			const LightRemovalNode node = m_SkyLightRemovalBFSQueue.front();
+			m_SkyLightRemovalBFSQueue.pop();
+
+			if (!node.p_Chunk)
+			{
+				continue;
+			}
+
+			const glm::ivec3 position = glm::ivec3(node.p_Position);
+			const int light_level = node.p_LightValue;
+
+			for (const glm::ivec3& direction : Directions)
+			{
+				glm::ivec3 neighbour = position + direction;
+				Chunk* neighbour_chunk = _GetBlockChunk(node.p_Chunk, neighbour);
+
+				if (!neighbour_chunk)
+				{
+					continue;
+				}
+
+				const int neighbour_level = neighbour_chunk->GetSkyLightAt(neighbour.x, neighbour.y, neighbour.z);
+
+				if (neighbour_level != 0 && neighbour_level < light_level)
+				{
+					neighbour_chunk->SetSkyLightAt(neighbour.x, neighbour.y, neighbour.z, 0);
+					neighbour_chunk->SetMeshDirty(neighbour.y, neighbour.y);
+					m_SkyLightRemovalBFSQueue.emplace(glm::vec3(neighbour), neighbour_level, neighbour_chunk);
+				}
+
+				else if (neighbour_level >= light_level)
+				{
+					m_SkyLightBFSQueue.emplace(glm::vec3(neighbour), neighbour_chunk);
+				}
+			}
+		}
+	}
+
+	/*
+		Updates the sky light after the block at position (local to chunk) was edited. Only a change between a block that casts a shadow
+		and one that doesn't can change it. old_caster_height is the shadow caster height of the column before the edit
+	*/
+	void World::_UpdateEditSkyLight(Chunk* chunk, const glm::ivec3& position, int old_caster_height, bool old_casts_shadow)
+	{
+		const bool casts_shadow = chunk->GetBlock(position.x, position.y, position.z).CastsShadow();
+		const int caster_height = chunk->GetShadowCasterHeight(position.x, position.z);
+
+		if (casts_shadow == old_casts_shadow)
+		{
+			return;
+		}
+
+		if (casts_shadow)
+		{
+			// The block is dark now, and so is the part of the column that it covered if it is the new top caster. 
+			// Whatever still reaches those blocks from the sides lights them again
+			for (int y = std::min(old_caster_height, position.y); y <= position.y; y++)
+			{
+				const int light_level = chunk->GetSkyLightAt(position.x, y, position.z);
+
+				if (light_level > 0)
+				{
+					chunk->SetSkyLightAt(position.x, y, position.z, 0);
+					m_SkyLightRemovalBFSQueue.emplace(glm::vec3(position.x, y, position.z), light_level, chunk);
+				}
+			}
+
+			chunk->SetMeshDirty(std::min(old_caster_height, position.y), position.y);
+		}
+
+		else
+		{
+			// The top caster was removed, the column sees the sky down to the next caster
+			for (int y = caster_height; y < old_caster_height; y++)
+			{
+				chunk->SetSkyLightAt(position.x, y, position.z, MAX_SKY_LIGHT_LEVEL);
+				m_SkyLightBFSQueue.emplace(glm::vec3(position.x, y, position.z), chunk);
+			}
+
+			if (caster_height < old_caster_height)
+			{
+				chunk->SetMeshDirty(caster_height, old_caster_height - 1);
+			}
+
+			// The block was under another caster, it is lit by its neighbours
+			else
+			{
+				static const glm::ivec3 Directions[6] = { glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0), glm::ivec3(0, 1, 0),
+					glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1) };
+
+				for (const glm::ivec3& direction : Directions)
+				{
+					glm::ivec3 neighbour = position + direction;
+					Chunk* neighbour_chunk = _GetBlockChunk(chunk, neighbour);
+
+					if (neighbour_chunk && neighbour_chunk->GetSkyLightAt(neighbour.x, neighbour.y, neighbour.z) > 1)
+					{
+						m_SkyLightBFSQueue.emplace(glm::vec3(neighbour), neighbour_chunk);
+					}
+				}
+			}
+		}
+
+		RemoveSkyLight();
+		PropogateSkyLight();
+	}
+
+	/*
+		Checks if the chunk exists in the chunk map
+	*/
+	bool World::ChunkExistsInMap(int cx, int cz)
+	{
+		return m_WorldChunks.Find(cx, cz) != nullptr;
 	}
 
 	/*
@@ -1200,9 +1885,9 @@ namespace Omnia
 	*/
 	Chunk* World::RetrieveChunkFromMap(int cx, int cz) noexcept
 	{
-		auto chk = m_WorldChunks.find(std::pair<int, int>(cx, cz));
+		Chunk* chunk = m_WorldChunks.Find(cx, cz);
 
-		if (chk == m_WorldChunks.end())
+		if (chunk == nullptr)
 		{
 			std::stringstream ss;
 			ss << "INVALID CHUNK REQUESTED !    CX : " << cx << "    CZ : " << cz;
@@ -1210,8 +1895,7 @@ namespace Omnia
 			return nullptr;
 		}
 
-		Chunk* ret_val = &m_WorldChunks.at(std::pair<int, int>(cx, cz));
-		return ret_val;
+		return chunk;
 	}
 
 	/*
@@ -1223,17 +1907,17 @@ namespace Omnia
 
 		str << "Chunk Building ! X : " << cx << " | Z : " << cz;
 
-		std::map<std::pair<int, int>, Chunk>::iterator chunk_exists = m_WorldChunks.find(std::pair<int, int>(cx, cz));
+		Chunk* chunk = m_WorldChunks.Find(cx, cz);
 
-		if (chunk_exists == m_WorldChunks.end())
+		if (chunk == nullptr)
 		{
 			Timer timer(str.str());
 
-			m_WorldChunks.emplace(std::pair<int, int>(cx, cz), glm::vec3(cx, 0, cz));
+			chunk = m_WorldChunks.Emplace(cx, cz, glm::vec3(cx, 0, cz)).first;
 			m_ChunkCount++;
 		}
 
-		return &m_WorldChunks.at(std::pair<int, int>(cx, cz));
+		return chunk;
 	}
 
 	/*
@@ -9,11 +9,13 @@
 #include <map>
 #include <vector>
 #include <thread>
+#include <algorithm>
 
 #include "../Utils/Raycast.h"
 
 #include "Skybox.h"
 #include "../Chunk.h"
+#include "../ChunkMesher.h"
 #include "../Block.h"
 #include "../Utils/Defs.h"
 #include "../Utils/Logger.h"
@@ -29,6 +31,9 @@
 #include "../Particle System/Particle.h"
 #include "WorldGeneratorType.h"
 #include "WorldGenerator.h"
+#include "ChunkHashMap.h"
+#include "../File Handling/ChunkSaver.h"
+#include "ChunkGenerator.h"
 #include "../Audio/Audio.h"
 
 namespace Omnia
@@ -50,12 +55,31 @@ namespace Omnia
 		void RenderWorld(bool show_crosshair = true);
 		void OnEvent(EventSystem::Event e);
 		void SetRenderDistance(int x);
+		void SetMeshingMode(ChunkMeshingMode mode);
+		void SetVertexFormat(ChunkVertexFormat format);
+
+		// When the loaded chunks use more than memory_budget_mb megabytes, the least recently used chunks that are further than 
+		// residency_distance chunks away from the player are unloaded. The distance is never less than the build distance + 1
+		void SetChunkResidency(int residency_distance, size_t memory_budget_mb);
+
+		// The memory used by the loaded chunks, the block and light arrays and the vertices on the gpu. In bytes
+		size_t GetChunkMemoryUsage();
 		inline const std::string& GetName() noexcept { return m_WorldName; }
 
+		// Queues the changed chunks on the chunk saver (to be written in dir) and marks them as unchanged. Returns the number of queued chunks
+		size_t QueueChangedChunks(const std::string& dir);
+		inline ChunkSaver& GetChunkSaver() noexcept { return m_ChunkSaver; }
+
+		// The world is saved in the background every interval seconds, 0 turns autosaving off. Worlds that can't be saved are never autosaved
+		inline void SetAutosaveInterval(float interval) noexcept { m_AutosaveInterval = interval; }
+
 		// Gets a world block from the respective chunk. Returns nullptr if invalid
-		std::pair<Block*, Chunk*> GetBlockFromPosition(const glm::vec3& pos) noexcept;
+		std::pair<Block, Chunk*> GetBlockFromPosition(const glm::vec3& pos) noexcept;
 		BlockType GetBlockTypeFromPosition(const glm::vec3& pos) noexcept;
 		Chunk* RetrieveChunkFromMap(int cx, int cz) noexcept;
+
+		// Same as RetrieveChunkFromMap() but doesn't log anything when the chunk isn't loaded
+		inline Chunk* FindChunk(int cx, int cz) noexcept { return m_WorldChunks.Find(cx, cz); }
 		WorldGenerationType GetWorldGenerationType() { return m_WorldGenType; }
 
 		bool ChunkExistsInMap(int cx, int cz);
@@ -64,7 +88,7 @@ namespace Omnia
 
 		Player* p_Player;
 
-		const std::map<std::pair<int, int>, Chunk>& GetWorldData()
+		const ChunkHashMap<Chunk>& GetWorldData()
 		{
 			return m_WorldChunks;
 		}
@@ -82,10 +106,18 @@ namespace Omnia
 	private:
 
 		void UnloadFarChunks();
+		bool _ReadUnloadedChunk(Chunk* chunk);
+		void _FillChunk(Chunk* chunk);
+		void _AddGeneratedChunks();
+		void _PullNeighbourLight(Chunk* chunk);
+		Chunk* _GetBlockChunk(Chunk* chunk, glm::ivec3& position);
 		void RayCast(bool place);
 		void PropogateLight();
 		void RemoveLight();
 		void UpdateLights();
+		void PropogateSkyLight();
+		void RemoveSkyLight();
+		void _UpdateEditSkyLight(Chunk* chunk, const glm::ivec3& position, int old_caster_height, bool old_casts_shadow);
 		void TickSun();
 		bool TestRayPlayerCollision(const glm::vec3& ray_block);
 		void _PlayBlockSound(BlockType type, const glm::vec3& position);
@@ -98,7 +130,21 @@ namespace Omnia
 		Renderer2D m_Renderer2D;
 		CubeRenderer m_CubeRenderer;
 
-		std::map<std::pair<int, int>, Chunk> m_WorldChunks;
+		ChunkHashMap<Chunk> m_WorldChunks;
+
+		// The sections that passed the frustum test this frame, sorted by their distance to the camera
+		struct VisibleSection
+		{
+			Chunk* p_Chunk;
+			int p_Section;
+			float p_DistanceSquared;
+		};
+
+		std::vector<VisibleSection> m_VisibleSections;
+
+		// Declared after the chunk map so that the mesher threads are stopped before the chunks are destroyed
+		ChunkMesher m_ChunkMesher;
+
 		Skybox m_Skybox;
 		glm::vec3 m_StartRay;
 		glm::vec3 m_EndRay;
@@ -112,6 +158,8 @@ namespace Omnia
 		// Lighting
 		std::queue<LightNode> m_LightBFSQueue;
 		std::queue<LightRemovalNode> m_LightRemovalBFSQueue;
+		std::queue<LightNode> m_SkyLightBFSQueue;
+		std::queue<LightRemovalNode> m_SkyLightRemovalBFSQueue;
 
 		// Day and night cycle
 		glm::vec4 m_SunPosition;
@@ -123,5 +171,25 @@ namespace Omnia
 		const std::string m_WorldName;
 		WorldGenerationType m_WorldGenType;
 		irrklang::ISoundEngine* m_SoundEngine;
+
+		// Chunk unloading
+		int m_ResidencyDistance;
+		size_t m_ChunkMemoryBudget; // In bytes
+		std::string m_ChunkDirectory; // Where modified chunks are written when they are unloaded. Empty if they can't be written
+
+		// Saving
+		ChunkFileHandler::ChunkSaveOptions m_ChunkSaveOptions;
+		ChunkSaver m_ChunkSaver;
+
+		// Declared after the chunk saver, its jobs use it
+		ChunkGenerator m_ChunkGenerator;
+		float m_AutosaveInterval; // In seconds
+		float m_TimeSinceAutosave;
+		bool m_AutosaveRunning;
+
+		static constexpr int DEFAULT_RESIDENCY_DISTANCE = 24;
+		static constexpr size_t DEFAULT_CHUNK_MEMORY_BUDGET_MB = 512;
+		static constexpr int UNLOAD_INTERVAL = 200; // In frames
+		static constexpr float DEFAULT_AUTOSAVE_INTERVAL = 300.0f;
 	};
 }
\ No newline at end of file
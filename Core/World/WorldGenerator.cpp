@@ -1,19 +1,75 @@
 #include "WorldGenerator.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace Omnia
 {
-    static FastNoise BiomeGenerator(8213); // Biome generation
     Biome GetBiome(float chunk_noise);
 
     // Water levels
-    int water_min_default = 2;
-    int water_max_default = 72;
+    constexpr int water_min = 2;
 
     BlockType vein_block = BlockType::Sand;
 
-    BlockType GetUnderwaterBlock(Random& random_gen)
+    // What a random decision of the generator is used for, so that two decisions about the same block don't get the same value
+    enum class GeneratorRoll : std::uint32_t
+    {
+        UnderwaterBlock = 1,
+        Structure,
+        Model,
+        Flower
+    };
+
+    static inline std::uint64_t MixHash(std::uint64_t hash)
+    {
+        // splitmix64 finalizer
+        hash ^= hash >> 30;
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 27;
+        hash *= 0x94D049BB133111EBull;
+        hash ^= hash >> 31;
+
+        return hash;
+    }
+
+    /*
+    Every random decision of the generator is a hash of the world seed and the world position of the block (or column, y = 0) it is about.
+    Nothing is carried over from one decision to the next, so a chunk is generated the same whatever order the chunks are generated in
+    and no generator state is shared between chunks
+    */
+    static std::uint32_t GetGeneratorRoll(int seed, int x, int y, int z, GeneratorRoll roll)
+    {
+        std::uint64_t hash = MixHash(static_cast<std::uint32_t>(seed) ^ (static_cast<std::uint64_t>(roll) << 32));
+
+        hash = MixHash(hash ^ static_cast<std::uint32_t>(x));
+        hash = MixHash(hash ^ (static_cast<std::uint64_t>(static_cast<std::uint32_t>(z)) << 32) ^ static_cast<std::uint32_t>(y));
+
+        return static_cast<std::uint32_t>(hash >> 32);
+    }
+
+    static int GetWaterLevel(WorldGenerationType gen_type)
     {
-        switch (random_gen.UnsignedInt(6))
+        if (gen_type == WorldGenerationType::Generation_Islands)
+        {
+            return 110;
+        }
+
+        if (gen_type == WorldGenerationType::Generation_Hilly)
+        {
+            return 80;
+        }
+
+        return 72;
+    }
+
+    // x, y, z are relative to the chunk
+    BlockType GetUnderwaterBlock(const Chunk* chunk, int seed, int x, int y, int z)
+    {
+        const int real_x = x + static_cast<int>(chunk->p_Position.x) * CHUNK_SIZE_X;
+        const int real_z = z + static_cast<int>(chunk->p_Position.z) * CHUNK_SIZE_Z;
+
+        switch (GetGeneratorRoll(seed, real_x, y, real_z, GeneratorRoll::UnderwaterBlock) % 6)
         {
         case 0:
             return BlockType::Sand;
@@ -30,149 +86,138 @@ namespace Omnia
         return BlockType::Sand;
     }
 
-    // Sets the vertical blocks based on the biome
-    void SetVerticalBlocks(Chunk* chunk, int x, int z, int y_level, float real_x, float real_z)
-    {
-        BiomeGenerator.SetNoiseType(FastNoise::Simplex);
+    // The blocks of a chunk in column order (y innermost), so every run of blocks in a column is a contiguous span
+    constexpr int column_buffer_size = CHUNK_SIZE_X * CHUNK_SIZE_Z * CHUNK_SIZE_Y;
 
-        Biome biome = chunk->p_BiomeMap[x][z];
+    static inline Block* GetColumn(Block* columns, int x, int z) noexcept
+    {
+        return &columns[(x * CHUNK_SIZE_Z + z) * CHUNK_SIZE_Y];
+    }
 
-        for (int i = 0; i < y_level; i++)
+    // Sets the blocks of a column from begin to end (not included) to one type
+    static inline void FillRun(Block* column, int begin, int end, BlockType type) noexcept
+    {
+        if (begin < end)
         {
-            if (i > 1)
-            {
-                if (biome == Biome::Grassland)
-                {
-                    if (i >= y_level - 1)
-                    {
-                        chunk->SetBlock(BlockType::Grass, glm::vec3(x, i, z));
-                    }
+            std::fill(column + begin, column + end, Block{ type });
+        }
+    }
 
-                    else if (i >= y_level - 5)
-                    {
-                        chunk->SetBlock(BlockType::Dirt, glm::vec3(x, i, z));
-                    }
+    // Sets the vertical blocks based on the biome : bedrock, then stone, then dirt and grass or sand up to y_level. Air above
+    static void SetVerticalBlocks(Block* column, Biome biome, int y_level)
+    {
+        constexpr int bedrock_top = 2;
+        const int ground_bottom = std::min(bedrock_top, y_level);
 
-                    else
-                    {
-                        chunk->SetBlock(BlockType::Stone, glm::vec3(x, i, z));
-                    }
-                }
+        FillRun(column, 0, ground_bottom, BlockType::Bedrock);
 
-                else if (biome == Biome::Desert)
-                {
-                    if (i >= y_level - 6)
-                    {
-                        chunk->SetBlock(BlockType::Sand, glm::vec3(x, i, z));
-                    }
+        if (biome == Biome::Grassland)
+        {
+            const int dirt_bottom = std::max(ground_bottom, y_level - 5);
+            const int grass_bottom = std::max(ground_bottom, y_level - 1);
 
-                    else
-                    {
-                        chunk->SetBlock(BlockType::Stone, glm::vec3(x, i, z));
-                    }
-                }
-            }
+            FillRun(column, ground_bottom, dirt_bottom, BlockType::Stone);
+            FillRun(column, dirt_bottom, grass_bottom, BlockType::Dirt);
+            FillRun(column, grass_bottom, y_level, BlockType::Grass);
+        }
 
-            else
-            {
-                chunk->SetBlock(BlockType::Bedrock, glm::vec3(x, i, z));
-            }
+        else if (biome == Biome::Desert)
+        {
+            const int sand_bottom = std::max(ground_bottom, y_level - 6);
+
+            FillRun(column, ground_bottom, sand_bottom, BlockType::Stone);
+            FillRun(column, sand_bottom, y_level, BlockType::Sand);
         }
 
-        return;
-    }
+        else
+        {
+            FillRun(column, ground_bottom, y_level, BlockType::Air);
+        }
 
-    void AddWaterBlocks(Chunk* chunk, const int water_min, const int water_max)
-    {
-        /*
-        Generates water in the areas needed inside of the chunk
-        */
+        FillRun(column, y_level, CHUNK_SIZE_Y, BlockType::Air);
+    }
 
-        Random water_gen(chunk->p_Position.x + chunk->p_Position.y);
-        ChunkDataTypePtr chunk_data = &chunk->p_ChunkContents;
+    /*
+    Generates water in the areas needed inside of the chunk. Before the caves and the flora every column is solid up to its height,
+    so the water, the shore and the underwater blocks of a column only depend on its height and the heights of its neighbours :
 
+    - The solid blocks from water_max - 1 to water_max + 3 are sand (the shore)
+    - The air from water_min + 1 up to water_max is water
+    - A solid block touching water below water_max - 1 is an underwater block (sand or clay). That is the top block of a column
+      under the water and the side of a column next to a lower column of the chunk
+    */
+    static void AddWaterBlocks(Block* columns, const Chunk* chunk, const int seed, const int water_max)
+    {
         for (int x = 0; x < CHUNK_SIZE_X; x++)
         {
-            for (int y = water_min; y < water_max + 6; y++)
+            for (int z = 0; z < CHUNK_SIZE_Z; z++)
             {
-                for (int z = 0; z < CHUNK_SIZE_Z; z++)
-                {
-                    Block* block = &chunk_data->at(x).at(y).at(z);
+                Block* column = GetColumn(columns, x, z);
+                const int height = chunk->p_HeightMap[x][z];
 
-                    if (block->p_BlockType == BlockType::Air)
-                    {
-                        if (y > water_min && y < water_max)
-                        {
-                            BiomeGenerator.SetNoiseType(FastNoise::Simplex);
-                            //float real_x = x + chunk->p_Position.x * CHUNK_SIZE_X;
-                            //float real_z = z + chunk->p_Position.z * CHUNK_SIZE_Z;
-                            
-                            chunk_data->at(x).at(y).at(z).p_BlockType = BlockType::Water;
+                FillRun(column, std::max(water_max - 1, water_min), std::min(height, water_max + 4), BlockType::Sand);
+                FillRun(column, std::max(height, water_min + 1), water_max, BlockType::Water);
 
-                            if (x > 0 && y < water_max - 1)
-                            {
-                                if (chunk_data->at(x - 1).at(y).at(z).IsOpaque())
-                                {
-                                    chunk_data->at(x - 1).at(y).at(z).p_BlockType = GetUnderwaterBlock(water_gen);
-                                }
-                            }
+                // The lowest water next to the column, the water of the neighbouring chunks isn't known here
+                int lowest_neighbour = height;
 
-                            if (x < CHUNK_SIZE_X - 1 && y < water_max - 1)
-                            {
-                                if (chunk_data->at(x + 1).at(y).at(z).IsOpaque())
-                                {
-                                    chunk_data->at(x + 1).at(y).at(z).p_BlockType = GetUnderwaterBlock(water_gen);
-                                }
-                            }
+                if (x > 0) lowest_neighbour = std::min<int>(lowest_neighbour, chunk->p_HeightMap[x - 1][z]);
+                if (x < CHUNK_SIZE_X - 1) lowest_neighbour = std::min<int>(lowest_neighbour, chunk->p_HeightMap[x + 1][z]);
+                if (z > 0) lowest_neighbour = std::min<int>(lowest_neighbour, chunk->p_HeightMap[x][z - 1]);
+                if (z < CHUNK_SIZE_Z - 1) lowest_neighbour = std::min<int>(lowest_neighbour, chunk->p_HeightMap[x][z + 1]);
 
-                            if (z > 0 && y < water_max - 1)
-                            {
-                                if (chunk_data->at(x).at(y).at(z - 1).IsOpaque())
-                                {
-                                    chunk_data->at(x).at(y).at(z - 1).p_BlockType = GetUnderwaterBlock(water_gen);
-                                }
-                            }
+                int underwater_bottom = std::max(lowest_neighbour, water_min + 1);
+                const int underwater_top = std::min(height, water_max - 1);
 
-                            if (z < CHUNK_SIZE_Z - 1 && y < water_max - 1)
-                            {
-                                if (chunk_data->at(x).at(y).at(z + 1).IsOpaque())
-                                {
-                                    chunk_data->at(x).at(y).at(z + 1).p_BlockType = GetUnderwaterBlock(water_gen);
-                                }
-                            }
+                // The top block is under the water
+                if (height > water_min && height < water_max)
+                {
+                    underwater_bottom = std::min(underwater_bottom, height - 1);
+                }
 
-                            if (y > 0)
-                            {
-                                if (chunk_data->at(x).at(y - 1).at(z).IsOpaque())
-                                {
-                                    chunk_data->at(x).at(y - 1).at(z).p_BlockType = GetUnderwaterBlock(water_gen);
-                                }
-                            }
+                for (int y = underwater_bottom; y < underwater_top; y++)
+                {
+                    column[y].p_BlockType = GetUnderwaterBlock(chunk, seed, x, y, z);
+                }
+            }
+        }
+    }
 
-                            if (y < water_max)
-                            {
-                                if (chunk_data->at(x).at(y + 1).at(z).IsOpaque())
-                                {
-                                    chunk_data->at(x).at(y + 1).at(z).p_BlockType = GetUnderwaterBlock(water_gen);
-                                }
-                            }
-                        }
-                    }
+    // Writes the columns to the sections of the chunk. The sections above the highest column are left as they are (air)
+    static void WriteColumns(Chunk* chunk, const Block* columns, int top)
+    {
+        Block section_blocks[PaletteBlockStorage::VOLUME];
+
+        for (int i = 0; i < CHUNK_SECTION_COUNT && i * CHUNK_SECTION_SIZE_Y < top; i++)
+        {
+            const int base_y = i * CHUNK_SECTION_SIZE_Y;
+            const int height = std::min(CHUNK_SECTION_SIZE_Y, CHUNK_SIZE_Y - base_y);
 
-                    else if (block->p_BlockType != BlockType::Air && y > water_max - 2 && y < water_max + 4)
+            std::fill_n(section_blocks, PaletteBlockStorage::VOLUME, Block{ BlockType::Air });
+
+            for (int x = 0; x < CHUNK_SIZE_X; x++)
+            {
+                for (int z = 0; z < CHUNK_SIZE_Z; z++)
+                {
+                    const Block* column = &columns[(x * CHUNK_SIZE_Z + z) * CHUNK_SIZE_Y + base_y];
+
+                    for (int y = 0; y < height; y++)
                     {
-                        chunk_data->at(x).at(y).at(z) = { BlockType::Sand };
+                        section_blocks[(x * CHUNK_SECTION_SIZE_Y + y) * CHUNK_SIZE_Z + z] = column[y];
                     }
                 }
             }
+
+            chunk->p_Sections[i].p_Blocks.Encode(section_blocks);
         }
+
+        // The sections were written without SetBlock(), which keeps the shadow caster heights up to date
+        chunk->UpdateShadowCasterHeights();
     }
 
-    BlockType GenerateFlower()
+    BlockType GenerateFlower(std::uint32_t roll)
     {
-        static Random random;
-
-        switch (random.UnsignedInt(6))
+        switch (roll % 6)
         {
         case 0:
             return BlockType::Flower_allium;
@@ -219,152 +264,284 @@ namespace Omnia
 
     constexpr double e = 2.718281828459f; // eulers number
 
-    void GenerateChunk(Chunk* chunk, const int WorldSeed, WorldGenerationType gen_type)
+    // How far a structure reaches sideways from the column it grows on (the 5x5 canopy of a tree)
+    constexpr int structure_reach = 2;
+
+    // The heightmap stage covers the chunk and the columns around it that can grow a structure reaching in to it
+    constexpr int padded_columns_x = CHUNK_SIZE_X + 2 * structure_reach;
+    constexpr int padded_columns_z = CHUNK_SIZE_Z + 2 * structure_reach;
+
+    /*
+    The noise generators of the terrain. FastNoise keeps its settings in the object so the generators can't be shared between threads,
+    every thread that generates chunks (the chunk generator workers, the chunk saver, the main thread) has its own context.
+    It is set up again when the thread generates a chunk of another world
+    */
+    struct GeneratorContext
     {
-        int water_min = water_min_default;
-        int water_max = water_max_default;
+        FastNoise p_HeightNoise;
+        FastNoise p_BiomeNoise;
+        FastNoise p_CaveNoise;
 
-        static FastNoise WorldGenerator(WorldSeed);
-        static FastNoise WorldGenerator_1(WorldSeed);
-        
-        // Set the chunk state
-        WorldGenerator.SetNoiseType(FastNoise::SimplexFractal);
+        // The terrain and the water are built here before they are written to the chunk (see WriteColumns)
+        Block p_Columns[column_buffer_size];
 
-        if (gen_type == WorldGenerationType::Generation_Normal)
+        // The height and the biome of the columns of the chunk and of the structure_reach columns around it, stored as [x * padded_columns_z + z]
+        std::uint8_t p_PaddedHeights[padded_columns_x * padded_columns_z];
+        Biome p_PaddedBiomes[padded_columns_x * padded_columns_z];
+
+        int p_Seed = 0;
+        WorldGenerationType p_GenerationType = WorldGenerationType::Generation_Normal;
+        bool p_Initialized = false;
+    };
+
+    static GeneratorContext& GetGeneratorContext(int seed, WorldGenerationType gen_type)
+    {
+        thread_local GeneratorContext context;
+
+        if (context.p_Initialized && context.p_Seed == seed && context.p_GenerationType == gen_type)
         {
-            WorldGenerator.SetFrequency(0.006);
-            WorldGenerator.SetFractalOctaves(5);
-            WorldGenerator.SetFractalLacunarity(2.0f);
+            return context;
         }
 
-        if (gen_type == WorldGenerationType::Generation_Normal || gen_type == WorldGenerationType::Generation_Islands ||
-            gen_type == WorldGenerationType::Generation_Hilly)
+        context.p_HeightNoise = FastNoise(seed);
+        context.p_HeightNoise.SetNoiseType(FastNoise::SimplexFractal);
+
+        if (gen_type == WorldGenerationType::Generation_Normal)
         {
-            int generated_x = 0;
-            int generated_y = 0;
-            int generated_z = 0;
+            context.p_HeightNoise.SetFrequency(0.006);
+            context.p_HeightNoise.SetFractalOctaves(5);
+            context.p_HeightNoise.SetFractalLacunarity(2.0f);
+        }
 
-            if (gen_type == WorldGenerationType::Generation_Islands)
-            {
-                water_max = 110;
-                water_max_default = water_max;
-            }
+        // The biomes don't depend on the world seed
+        context.p_BiomeNoise = FastNoise(8213);
+        context.p_BiomeNoise.SetNoiseType(FastNoise::Simplex);
+
+        context.p_CaveNoise = FastNoise(seed);
+        context.p_CaveNoise.SetNoiseType(FastNoise::Simplex);
 
-            if (gen_type == WorldGenerationType::Generation_Hilly)
+        context.p_Seed = seed;
+        context.p_GenerationType = gen_type;
+        context.p_Initialized = true;
+
+        return context;
+    }
+
+    // Caves are carved below cave_level where the cave noise is close to 0
+    constexpr int cave_level = 55;
+    constexpr float cave_threshold = 0.1f;
+
+    // The cave noise is sampled every cave_cell_xz blocks horizontally and cave_cell_y blocks vertically, the blocks in between are interpolated
+    constexpr int cave_cell_xz = 4;
+    constexpr int cave_cell_y = 8;
+    constexpr int cave_points_xz = CHUNK_SIZE_X / cave_cell_xz + 1;
+    constexpr int cave_points_y = (cave_level + cave_cell_y - 1) / cave_cell_y + 1;
+
+    // The blocks kept below the lowest surface around a column. Every column that is low enough to reach is under water, so this keeps the water out of the caves
+    constexpr int cave_crust = 4;
+
+    static void GenerateCaves(Chunk* chunk, const GeneratorContext& context)
+    {
+        const int start_x = static_cast<int>(chunk->p_Position.x) * CHUNK_SIZE_X;
+        const int start_z = static_cast<int>(chunk->p_Position.z) * CHUNK_SIZE_Z;
+
+        // The highest block that can be carved in each column. The heightmap proves most columns can't have a cave at all
+        int carve_top[CHUNK_SIZE_X][CHUNK_SIZE_Z];
+        int chunk_top = 0;
+
+        for (int x = 0; x < CHUNK_SIZE_X; x++)
+        {
+            for (int z = 0; z < CHUNK_SIZE_Z; z++)
             {
-                water_max = 80;
-                water_max_default = water_max;
+                int surface = chunk->p_HeightMap[x][z];
+
+                if (x > 0) surface = std::min<int>(surface, chunk->p_HeightMap[x - 1][z]);
+                if (x < CHUNK_SIZE_X - 1) surface = std::min<int>(surface, chunk->p_HeightMap[x + 1][z]);
+                if (z > 0) surface = std::min<int>(surface, chunk->p_HeightMap[x][z - 1]);
+                if (z < CHUNK_SIZE_Z - 1) surface = std::min<int>(surface, chunk->p_HeightMap[x][z + 1]);
+
+                carve_top[x][z] = std::min(cave_level, surface - cave_crust);
+                chunk_top = std::max(chunk_top, carve_top[x][z]);
             }
+        }
+
+        if (chunk_top <= water_min)
+        {
+            return;
+        }
 
-            // Generates the world using perlin noise to generate a height map
+        float lattice[cave_points_xz * cave_points_y * cave_points_xz];
+        context.p_CaveNoise.GetNoiseGrid(lattice, start_x, 0, start_z, cave_points_xz, cave_points_y, cave_points_xz, cave_cell_xz, cave_cell_y, cave_cell_xz);
 
-            for (int x = 0; x < CHUNK_SIZE_X; x++)
+        auto lattice_at = [&lattice](int x, int y, int z) { return lattice[(x * cave_points_y + y) * cave_points_xz + z]; };
+
+        for (int cell_x = 0; cell_x < cave_points_xz - 1; cell_x++)
+        {
+            for (int cell_z = 0; cell_z < cave_points_xz - 1; cell_z++)
             {
-                for (int z = 0; z < CHUNK_SIZE_Z; z++)
+                int cell_top = 0;
+
+                for (int x = 0; x < cave_cell_xz; x++)
                 {
-                    int real_x = x + chunk->p_Position.x * CHUNK_SIZE_X;
-                    int real_z = z + chunk->p_Position.z * CHUNK_SIZE_Z;
+                    for (int z = 0; z < cave_cell_xz; z++)
+                    {
+                        cell_top = std::max(cell_top, carve_top[cell_x * cave_cell_xz + x][cell_z * cave_cell_xz + z]);
+                    }
+                }
 
-                    float height_at = 0.0f;
+                for (int cell_y = 0; cell_y * cave_cell_y < cell_top; cell_y++)
+                {
+                    float corners[2][2][2];
+                    float min_corner = 1.0f;
+                    float max_corner = -1.0f;
 
-                    if (gen_type == WorldGenerationType::Generation_Islands || gen_type == WorldGenerationType::Generation_Hilly)
+                    for (int i = 0; i < 8; i++)
                     {
-                        height_at = WorldGenerator.GetNoise(real_x, real_z) +
-                            (0.5 * WorldGenerator.GetNoise(real_x, real_z)) *
-                            WorldGenerator.GetNoise(real_x * 0.4f, real_z * 0.4f);
+                        float& corner = corners[i >> 2][(i >> 1) & 1][i & 1];
+
+                        corner = lattice_at(cell_x + (i >> 2), cell_y + ((i >> 1) & 1), cell_z + (i & 1));
+                        min_corner = std::min(min_corner, corner);
+                        max_corner = std::max(max_corner, corner);
                     }
 
-                    else if (gen_type == WorldGenerationType::Generation_Normal)
+                    // The interpolated noise stays between the corners, skip the cell if no block in it can be close enough to 0
+                    if (min_corner >= cave_threshold || max_corner <= -cave_threshold)
                     {
-                        height_at = (WorldGenerator.GetNoise(real_x / 2.0f, real_z / 2.0f));
+                        continue;
                     }
 
-                    // Generate the biome
-                    float column_noise = BiomeGenerator.GetNoise(real_x, real_z);
-                    column_noise = ((column_noise + 1.0f) / 2) * 200;
+                    for (int x = 0; x < cave_cell_xz; x++)
+                    {
+                        for (int z = 0; z < cave_cell_xz; z++)
+                        {
+                            const int block_x = cell_x * cave_cell_xz + x;
+                            const int block_z = cell_z * cave_cell_xz + z;
+                            const int min_y = std::max(cell_y * cave_cell_y, water_min);
+                            const int max_y = std::min((cell_y + 1) * cave_cell_y, carve_top[block_x][block_z]);
+
+                            if (min_y >= max_y)
+                            {
+                                continue;
+                            }
 
-                    Biome biome = GetBiome(column_noise);
-                    chunk->p_BiomeMap[x][z] = biome;
+                            // Interpolate on the bottom and top faces of the cell, then along y for every block of the column
+                            const float fx = static_cast<float>(x) / cave_cell_xz;
+                            const float fz = static_cast<float>(z) / cave_cell_xz;
+                            float face[2];
 
-                    generated_x = x;
-                    generated_z = z;
+                            for (int y = 0; y < 2; y++)
+                            {
+                                const float near_x = glm::mix(corners[0][y][0], corners[0][y][1], fz);
+                                const float far_x = glm::mix(corners[1][y][0], corners[1][y][1], fz);
 
-                    generated_y = ((height_at + 1.0f) / 2) * 240;
+                                face[y] = glm::mix(near_x, far_x, fx);
+                            }
 
-                    if (generated_y >= CHUNK_SIZE_Y)
-                    {
-                        generated_y = CHUNK_SIZE_Y - 2;
-                    }
+                            for (int y = min_y; y < max_y; y++)
+                            {
+                                const float fy = static_cast<float>(y - cell_y * cave_cell_y) / cave_cell_y;
+                                const float noise = glm::mix(face[0], face[1], fy);
 
-                    chunk->p_HeightMap[x][z] = static_cast<uint8_t>(generated_y);
-                    SetVerticalBlocks(chunk, generated_x, generated_z, generated_y, real_x, real_z);
+                                if (noise > -cave_threshold && noise < cave_threshold)
+                                {
+                                    chunk->SetBlock(block_x, y, block_z, BlockType::Air);
+                                }
+                            }
+                        }
+                    }
                 }
             }
+        }
+    }
+
+    /*
+    Heightmap stage : the height and the biome of every column. The columns around the chunk are computed as well,
+    the flora stage needs them for the structures of the neighbouring chunks that reach in to this one
+    */
+    static void GenerateHeightmap(Chunk* chunk, GeneratorContext& context)
+    {
+        const WorldGenerationType gen_type = context.p_GenerationType;
 
-            AddWaterBlocks(chunk, water_min, water_max);
+        if (gen_type == WorldGenerationType::Generation_Flat || gen_type == WorldGenerationType::Generation_FlatWithoutStructures)
+        {
+            std::fill_n(context.p_PaddedHeights, padded_columns_x * padded_columns_z, static_cast<std::uint8_t>(127));
+            std::fill_n(context.p_PaddedBiomes, padded_columns_x * padded_columns_z, Biome::Grassland);
         }
 
-        else if (gen_type == WorldGenerationType::Generation_Flat || gen_type == WorldGenerationType::Generation_FlatWithoutStructures)
+        else
         {
-            for (int x = 0; x < CHUNK_SIZE_X; x++)
-            {
-                for (int z = 0; z < CHUNK_SIZE_Z; z++)
-                {
-                    const uint8_t height = 127;
+            const int start_x = static_cast<int>(chunk->p_Position.x) * CHUNK_SIZE_X - structure_reach;
+            const int start_z = static_cast<int>(chunk->p_Position.z) * CHUNK_SIZE_Z - structure_reach;
 
-                    float real_x = x + chunk->p_Position.x * CHUNK_SIZE_X;
-                    float real_z = z + chunk->p_Position.z * CHUNK_SIZE_Z;
-                    chunk->p_HeightMap[x][z] = height;
+            // The noise of the whole area is evaluated at once, several columns at a time (see FastNoise::GetNoiseGrid)
+            float height_noise[padded_columns_x * padded_columns_z];
+            float detail_noise[padded_columns_x * padded_columns_z];
+            float biome_noise[padded_columns_x * padded_columns_z];
 
-                    SetVerticalBlocks(chunk, x, z, height, real_x, real_z);
-                }
+            if (gen_type == WorldGenerationType::Generation_Islands || gen_type == WorldGenerationType::Generation_Hilly)
+            {
+                context.p_HeightNoise.GetNoiseGrid(height_noise, start_x, start_z, padded_columns_x, padded_columns_z);
+                context.p_HeightNoise.GetNoiseGrid(detail_noise, start_x, start_z, padded_columns_x, padded_columns_z, 1, 0.4f);
             }
-        }
-    }
 
-    // To freaking slow
-    void GenerateCaves(Chunk* chunk, const int seed)
-    {
-        constexpr int cave_level = 55;
-
-        static FastNoise noise_1(seed);
-        static FastNoise noise_2(seed);
+            else
+            {
+                context.p_HeightNoise.GetNoiseGrid(height_noise, start_x, start_z, padded_columns_x, padded_columns_z, 1, 0.5f);
+            }
 
-        noise_1.SetNoiseType(FastNoise::Simplex);
-        noise_2.SetNoiseType(FastNoise::Simplex);
+            context.p_BiomeNoise.GetNoiseGrid(biome_noise, start_x, start_z, padded_columns_x, padded_columns_z);
 
-        for (int x = 0; x < CHUNK_SIZE_X; x++)
-        {
-            for (int y = 0; y < CHUNK_SIZE_Y; y++)
+            for (int column = 0; column < padded_columns_x * padded_columns_z; column++)
             {
-                for (int z = 0; z < CHUNK_SIZE_Z; z++)
-                {
-                    if (y < 2)
-                    {
-                        chunk->p_ChunkContents.at(x).at(y).at(z) = { BlockType::Bedrock };
-                    }
+                float height_at = 0.0f;
 
-                    else if (y < cave_level)
-                    {
-                        float real_x = x + chunk->p_Position.x * CHUNK_SIZE_X;
-                        float real_z = z + chunk->p_Position.z * CHUNK_SIZE_Z;
+                if (gen_type == WorldGenerationType::Generation_Islands || gen_type == WorldGenerationType::Generation_Hilly)
+                {
+                    height_at = height_noise[column] + (0.5 * height_noise[column]) * detail_noise[column];
+                }
 
-                        float n1 = noise_1.GetNoise(real_x, y, real_z);
-                        n1 = n1 * n1;
+                else if (gen_type == WorldGenerationType::Generation_Normal)
+                {
+                    height_at = height_noise[column];
+                }
 
-                        float n2 = noise_2.GetNoise(real_x, y, real_z);
-                        n2 = n2 * n2;
+                // Generate the biome
+                float column_noise = biome_noise[column];
+                column_noise = ((column_noise + 1.0f) / 2) * 200;
 
-                        float res = n1 + n2;
+                context.p_PaddedBiomes[column] = GetBiome(column_noise);
 
-                        bool cave = res < 0.02 ? true : false;
+                int generated_y = ((height_at + 1.0f) / 2) * 240;
 
-                        if (cave)
-                        {
-                            chunk->p_ChunkContents.at(x).at(y).at(z) = { BlockType::Air };
-                        }
-                    }
+                if (generated_y >= CHUNK_SIZE_Y)
+                {
+                    generated_y = CHUNK_SIZE_Y - 2;
                 }
+
+                context.p_PaddedHeights[column] = static_cast<uint8_t>(generated_y);
+            }
+        }
+
+        for (int x = 0; x < CHUNK_SIZE_X; x++)
+        {
+            for (int z = 0; z < CHUNK_SIZE_Z; z++)
+            {
+                const int column = (x + structure_reach) * padded_columns_z + (z + structure_reach);
+
+                chunk->p_HeightMap[x][z] = context.p_PaddedHeights[column];
+                chunk->p_BiomeMap[x][z] = context.p_PaddedBiomes[column];
+            }
+        }
+    }
+
+    // Column fill stage : the blocks of every column up to its height, in the column buffer of the context
+    static void FillColumns(const Chunk* chunk, Block* columns)
+    {
+        for (int x = 0; x < CHUNK_SIZE_X; x++)
+        {
+            for (int z = 0; z < CHUNK_SIZE_Z; z++)
+            {
+                SetVerticalBlocks(GetColumn(columns, x, z), chunk->p_BiomeMap[x][z], chunk->p_HeightMap[x][z]);
             }
         }
     }
@@ -378,107 +555,236 @@ namespace Omnia
 
     TreeStructure WorldStructureTree;
     CactusStructure WorldStructureCactus;
-    Random WorldTreeGenerator(1234);
-    Random WorldModelGenerator(1234);
 
-    bool FillInWorldStructure(WorldStructure* structure, int x, int y, int z)
+    /*
+    The structure that grows on a column, nullptr if there is none. x and z are the world position of the column,
+    position is set to the world position the structure is built from
+    */
+    static const WorldStructure* GetColumnStructure(int seed, int water_max, int x, int z, int height, Biome biome, glm::ivec3& position)
     {
-        if (y <= 0 || y >= CHUNK_SIZE_Y)
+        if (height + MAX_STRUCTURE_Y >= CHUNK_SIZE_Y || height <= water_max + 6)
         {
-            return false;
+            return nullptr;
         }
 
-        for (int i = 0; i < structure->p_Structure.size(); i++)
+        const WorldStructure* structure = nullptr;
+        int structure_freq = 0; // The higher the less likely it is to spawn
+        position = glm::ivec3(x, height, z);
+
+        if (biome == Biome::Grassland)
         {
-            Block* block = GetWorldBlock(glm::vec3(x + structure->p_Structure.at(i).x, y + structure->p_Structure.at(i).y, z + structure->p_Structure.at(i).z));
-            *block = structure->p_Structure.at(i).block;
+            // The trunk is in the middle of the canopy
+            position.x = x - structure_reach;
+            position.z = z - structure_reach;
+            structure_freq = 200;
+            structure = &WorldStructureTree;
         }
 
-        return true;
+        else if (biome == Biome::Desert)
+        {
+            structure_freq = 300;
+            structure = &WorldStructureCactus;
+        }
+
+        if (structure && GetGeneratorRoll(seed, x, 0, z, GeneratorRoll::Structure) % structure_freq == 0)
+        {
+            return structure;
+        }
+
+        return nullptr;
     }
 
-    void GenerateChunkFlora(Chunk* chunk, const int WorldSeed, WorldGenerationType gen_type)
+    // Writes the blocks of a structure that land in the chunk, the rest is written by the chunks they land in. position is a world position
+    static void FillInWorldStructure(Chunk* chunk, const WorldStructure* structure, const glm::ivec3& position)
     {
-        if (gen_type == WorldGenerationType::Generation_FlatWithoutStructures)
+        if (position.y <= 0 || position.y >= CHUNK_SIZE_Y)
         {
             return;
         }
 
+        const int chunk_x = static_cast<int>(chunk->p_Position.x) * CHUNK_SIZE_X;
+        const int chunk_z = static_cast<int>(chunk->p_Position.z) * CHUNK_SIZE_Z;
+
+        for (const StructureBlock& block : structure->p_Structure)
+        {
+            const int local_x = position.x + block.x - chunk_x;
+            const int y = position.y + block.y;
+            const int local_z = position.z + block.z - chunk_z;
+
+            if (local_x >= 0 && local_x < CHUNK_SIZE_X && local_z >= 0 && local_z < CHUNK_SIZE_Z && y >= 0 && y < CHUNK_SIZE_Y)
+            {
+                chunk->SetBlock(local_x, y, local_z, block.block.p_BlockType);
+            }
+        }
+    }
+
+    // Flora stage : trees, cacti, flowers and grass
+    static void GenerateChunkFlora(Chunk* chunk, const GeneratorContext& context)
+    {
+        const int WorldSeed = context.p_Seed;
+        const int water_max = GetWaterLevel(context.p_GenerationType);
+        const int chunk_x = static_cast<int>(chunk->p_Position.x) * CHUNK_SIZE_X;
+        const int chunk_z = static_cast<int>(chunk->p_Position.z) * CHUNK_SIZE_Z;
+
+        // Grass, flowers and dead bushes on the columns that don't grow a structure
         for (int x = 0; x < CHUNK_SIZE_X; x++)
         {
             for (int z = 0; z < CHUNK_SIZE_Z; z++)
             {
-                int real_x = x + chunk->p_Position.x * CHUNK_SIZE_X;
-                int real_z = z + chunk->p_Position.z * CHUNK_SIZE_Z;
-                int structure_freq = 0; // The higher the less likely it is to spawn
-                bool added_structure = false;
+                int real_x = x + chunk_x;
+                int real_z = z + chunk_z;
+                int y = chunk->p_HeightMap[x][z];
 
                 Biome biome = chunk->p_BiomeMap[x][z];
+                glm::ivec3 structure_position;
 
-                if (chunk->p_HeightMap[x][z] + MAX_STRUCTURE_Y < CHUNK_SIZE_Y)
+                if (y + 1 >= CHUNK_SIZE_Y || y + 1 <= water_max + 6 || GetColumnStructure(WorldSeed, water_max, real_x, real_z, y, biome, structure_position))
                 {
-                    int structure_x = real_x;
-                    int structure_y = chunk->p_HeightMap[x][z];
-                    int structure_z = real_z;
+                    continue;
+                }
 
-                    WorldStructure* structure = nullptr;
+                BlockType model_type = BlockType::Air;
 
-                    if (biome == Biome::Grassland)
+                if (biome == Biome::Grassland)
+                {
+                    int num = GetGeneratorRoll(WorldSeed, real_x, 0, real_z, GeneratorRoll::Model) % 150;
+
+                    if (num > 135)
                     {
-                        structure_x = real_x - 2;
-                        structure_z = real_z - 2;
-                        structure_freq = 200;
-                        structure = &WorldStructureTree;
+                        model_type = BlockType::Model_Grass;
                     }
 
-                    else if (biome == Biome::Desert)
+                    else if (num == 40 || num == 30)
                     {
-                        structure_freq = 300;
-                        structure = &WorldStructureCactus;
+                        model_type = GenerateFlower(GetGeneratorRoll(WorldSeed, real_x, 0, real_z, GeneratorRoll::Flower));
                     }
+                }
 
-                    if (structure && WorldTreeGenerator.UnsignedInt(structure_freq) == 0 && chunk->p_HeightMap[x][z] > water_max_default + 6)
+                else if (biome == Biome::Desert)
+                {
+                    int num = GetGeneratorRoll(WorldSeed, real_x, 0, real_z, GeneratorRoll::Model) % 280;
+
+                    if (num == 40 || num == 30)
                     {
-                        added_structure = true;
-                        FillInWorldStructure(structure, structure_x, structure_y, structure_z);
+                        model_type = BlockType::Model_Deadbush;
                     }
                 }
 
-                if (chunk->p_HeightMap[x][z] + 1 < CHUNK_SIZE_Y && chunk->p_HeightMap[x][z] + 1 > water_max_default + 6 && !added_structure)
+                chunk->SetBlock(x, y, z, model_type);
+            }
+        }
+
+        /*
+        The structures of the chunk and the ones of the columns around it that reach in to it. Every chunk goes through the structures
+        in the same (world position) order and only writes its own blocks, so a structure across a chunk border comes out whole and the same
+        whatever chunk is generated first. A chunk never writes to another one, so nothing is lost or overwritten when chunks are unloaded
+        and generated again
+        */
+        for (int x = 0; x < padded_columns_x; x++)
+        {
+            for (int z = 0; z < padded_columns_z; z++)
+            {
+                const int column = x * padded_columns_z + z;
+                glm::ivec3 structure_position;
+
+                const WorldStructure* structure = GetColumnStructure(WorldSeed, water_max, chunk_x + x - structure_reach, chunk_z + z - structure_reach,
+                    context.p_PaddedHeights[column], context.p_PaddedBiomes[column], structure_position);
+
+                if (structure)
                 {
-                    int y = chunk->p_HeightMap[x][z];
-                    BlockType model_type = BlockType::Air;
+                    FillInWorldStructure(chunk, structure, structure_position);
+                }
+            }
+        }
+    }
 
-                    if (biome == Biome::Grassland)
-                    {
-                        int num = WorldModelGenerator.UnsignedInt(150);
+    // Lighting stage : there are no light sources in the generated terrain, the chunk starts dark. Only the sky light is computed
+    static void GenerateChunkLighting(Chunk* chunk)
+    {
+        chunk->UpdateSkyLight();
+        chunk->p_LightMapState = ChunkLightMapState::UnmodifiedLightMap;
+    }
 
-                        if (num > 135)
-                        {
-                            model_type = BlockType::Model_Grass;
-                        }
+    static void RunGenerationStage(GenerationStage stage, Chunk* chunk, GeneratorContext& context)
+    {
+        const WorldGenerationType gen_type = context.p_GenerationType;
+        const bool noise_terrain = gen_type == WorldGenerationType::Generation_Normal || gen_type == WorldGenerationType::Generation_Islands ||
+            gen_type == WorldGenerationType::Generation_Hilly;
 
-                        else if (num == 40 || num == 30)
-                        {
-                            model_type = GenerateFlower();
-                        }
-                    }
+        switch (stage)
+        {
+        case GenerationStage::Heightmap:
+            GenerateHeightmap(chunk, context);
+            break;
 
-                    else if (biome == Biome::Desert)
-                    {
-                        int num = WorldModelGenerator.UnsignedInt(280);
+        case GenerationStage::ColumnFill:
+            FillColumns(chunk, context.p_Columns);
+            break;
 
-                        if (num == 40 || num == 30)
-                        {
-                            model_type = BlockType::Model_Deadbush;
-                        }
-                    }
+        case GenerationStage::Water:
+        {
+            int top = 0;
+
+            if (noise_terrain)
+            {
+                AddWaterBlocks(context.p_Columns, chunk, context.p_Seed, GetWaterLevel(gen_type));
+                top = GetWaterLevel(gen_type);
+            }
 
-                    chunk->p_ChunkContents.at(x).at(y).at(z).p_BlockType = model_type;
+            for (int x = 0; x < CHUNK_SIZE_X; x++)
+            {
+                for (int z = 0; z < CHUNK_SIZE_Z; z++)
+                {
+                    top = std::max<int>(top, chunk->p_HeightMap[x][z]);
                 }
             }
+
+            // The later stages change a few blocks here and there, they write to the chunk directly
+            WriteColumns(chunk, context.p_Columns, top);
+            break;
+        }
+
+        case GenerationStage::Caves:
+            if (noise_terrain && gen_type != WorldGenerationType::Generation_Islands)
+            {
+                GenerateCaves(chunk, context);
+            }
+
+            break;
+
+        case GenerationStage::Flora:
+            if (gen_type != WorldGenerationType::Generation_FlatWithoutStructures)
+            {
+                GenerateChunkFlora(chunk, context);
+            }
+
+            break;
+
+        case GenerationStage::Lighting:
+            GenerateChunkLighting(chunk);
+            break;
+
+        default:
+            break;
         }
     }
 
-   
-}
\ No newline at end of file
+    void GenerateChunk(Chunk* chunk, const int WorldSeed, WorldGenerationType gen_type, GenerationTimings* timings)
+    {
+        GeneratorContext& context = GetGeneratorContext(WorldSeed, gen_type);
+
+        for (int stage = 0; stage < static_cast<int>(GenerationStage::Count); stage++)
+        {
+            if (!timings)
+            {
+                RunGenerationStage(static_cast<GenerationStage>(stage), chunk, context);
+                continue;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+
+            RunGenerationStage(static_cast<GenerationStage>(stage), chunk, context);
+            timings->p_StageSeconds[stage] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+}
@@ -11,7 +11,6 @@
 // Include fast noise
 #include "../Noise/FastNoise.h"
 
-#include "World.h"
 #include "WorldGeneratorType.h"
 #include "Structures/WorldStructures.h"
 #include "../Chunk.h"
@@ -21,8 +20,33 @@
 
 namespace Omnia
 {
-	Block* GetWorldBlock(const glm::vec3& block_pos);
+	/*
+	The stages a chunk goes through when it is generated, in this order.
+	Every stage only reads and writes the chunk it is given, so a chunk can be generated on any thread without its neighbours
+	*/
+	enum class GenerationStage : std::uint8_t
+	{
+		Heightmap = 0, // The height and the biome of every column, from the noise
+		ColumnFill, // Bedrock, stone, dirt, grass and sand up to the height of every column, written as runs in a column buffer
+		Water, // Water up to the water level and the sand and clay around it. The column buffer is written to the chunk after it
+		Caves, // Carved in to the terrain below the water level (Normal and Hilly)
+		Flora, // Trees, cacti, flowers and grass. The structures of the neighbouring chunks that reach in to the chunk are written as well
+		Lighting, // The light of the chunk
+		Count
+	};
 
-	void GenerateChunk(Chunk* chunk, const int WorldSeed, WorldGenerationType gen_type);
-	void GenerateChunkFlora(Chunk* chunk, const int WorldSeed, WorldGenerationType gen_type);
+	// The time spent in each stage, in seconds. Added to by every chunk it is passed to
+	struct GenerationTimings
+	{
+		double p_StageSeconds[static_cast<int>(GenerationStage::Count)] = {};
+	};
+
+	/*
+	Stored in the chunks that are saved as changes against the generated terrain (see ChunkFileHandler::ChunkSaveMode::Delta).
+	Bump it with every change that makes the generator write different blocks for the same seed, the chunks saved by another version are refused
+	*/
+	constexpr std::uint32_t WORLD_GENERATOR_VERSION = 1;
+
+	// Runs every stage on a new chunk. The stages are only timed when timings isn't null
+	void GenerateChunk(Chunk* chunk, const int WorldSeed, WorldGenerationType gen_type, GenerationTimings* timings = nullptr);
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+/*
+Compares the chunk lookup throughput of ChunkHashMap (Core/World/ChunkHashMap.h) with the std::map that World used before.
+The maps hold a small payload instead of real chunks so that thousands of them fit in memory, the lookups are what is measured.
+
+Build (from the repository root) :
+	cl /O2 /EHsc /std:c++17 Tools/ChunkMapBenchmark.cpp
+	g++ -O2 -std=c++17 Tools/ChunkMapBenchmark.cpp -o ChunkMapBenchmark
+
+Usage : ChunkMapBenchmark [render distance] [iterations]
+*/
+
+#include <iostream>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdint>
+
+#include "../Core/World/ChunkHashMap.h"
+
+struct ChunkPayload
+{
+	ChunkPayload(int x, int z) : p_X(x), p_Z(z) {}
+
+	int p_X;
+	int p_Z;
+	std::uint8_t p_Data[64];
+};
+
+struct LookupResult
+{
+	double p_NanosecondsPerLookup;
+	std::uint64_t p_Checksum; // Keeps the compiler from removing the lookups
+};
+
+template <typename F>
+static LookupResult MeasureLookups(const std::vector<std::pair<int, int>>& coordinates, int iterations, F&& find)
+{
+	std::uint64_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < iterations; i++)
+	{
+		for (const std::pair<int, int>& coordinate : coordinates)
+		{
+			const ChunkPayload* chunk = find(coordinate.first, coordinate.second);
+			checksum += chunk ? static_cast<std::uint64_t>(chunk->p_X + 1) : 0;
+		}
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	double elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(end - start).count();
+
+	return { elapsed / (static_cast<double>(coordinates.size()) * iterations), checksum };
+}
+
+static void RunBenchmark(const std::string& name, const std::vector<std::pair<int, int>>& coordinates, int iterations,
+	std::map<std::pair<int, int>, ChunkPayload>& tree_map, Omnia::ChunkHashMap<ChunkPayload>& hash_map)
+{
+	LookupResult tree_result = MeasureLookups(coordinates, iterations, [&](int cx, int cz) -> const ChunkPayload*
+	{
+		auto chunk = tree_map.find(std::pair<int, int>(cx, cz));
+		return chunk == tree_map.end() ? nullptr : &chunk->second;
+	});
+
+	LookupResult hash_result = MeasureLookups(coordinates, iterations, [&](int cx, int cz) -> const ChunkPayload*
+	{
+		return hash_map.Find(cx, cz);
+	});
+
+	if (tree_result.p_Checksum != hash_result.p_Checksum)
+	{
+		std::cout << "ERROR : The maps returned different chunks for " << name << "\n";
+	}
+
+	std::cout << name << "\n";
+	std::cout << "    std::map     : " << tree_result.p_NanosecondsPerLookup << " ns / lookup\n";
+	std::cout << "    ChunkHashMap : " << hash_result.p_NanosecondsPerLookup << " ns / lookup ("
+		<< tree_result.p_NanosecondsPerLookup / hash_result.p_NanosecondsPerLookup << "x)\n";
+}
+
+int main(int argc, char** argv)
+{
+	const int render_distance = argc > 1 ? std::stoi(argv[1]) : 16;
+	const int iterations = argc > 2 ? std::stoi(argv[2]) : 200;
+
+	// The loaded region is a little larger than the render distance, like in World::OnUpdate()
+	const int load_distance = render_distance + 2;
+
+	std::map<std::pair<int, int>, ChunkPayload> tree_map;
+	Omnia::ChunkHashMap<ChunkPayload> hash_map;
+
+	for (int x = -load_distance; x < load_distance; x++)
+	{
+		for (int z = -load_distance; z < load_distance; z++)
+		{
+			tree_map.emplace(std::pair<int, int>(x, z), ChunkPayload(x, z));
+			hash_map.Emplace(x, z, x, z);
+		}
+	}
+
+	std::cout << "Loaded chunks : " << hash_map.Size() << " | Hash map capacity : " << hash_map.Capacity() << "\n\n";
+
+	// The render distance grid walk that RenderWorld does every frame
+	std::vector<std::pair<int, int>> grid;
+
+	for (int x = -render_distance; x < render_distance; x++)
+	{
+		for (int z = -render_distance; z < render_distance; z++)
+		{
+			grid.push_back({ x, z });
+		}
+	}
+
+	// Block and light lookups, spread randomly over the loaded region
+	std::mt19937 random(1337);
+	std::uniform_int_distribution<int> loaded(-load_distance, load_distance - 1);
+	std::vector<std::pair<int, int>> random_hits;
+
+	for (size_t i = 0; i < grid.size(); i++)
+	{
+		random_hits.push_back({ loaded(random), loaded(random) });
+	}
+
+	// Neighbour lookups at the edge of the loaded region, about half of them miss
+	std::uniform_int_distribution<int> edge(load_distance - 4, load_distance + 4);
+	std::vector<std::pair<int, int>> edge_lookups;
+
+	for (size_t i = 0; i < grid.size(); i++)
+	{
+		edge_lookups.push_back({ edge(random) * (i % 2 ? 1 : -1), loaded(random) });
+	}
+
+	RunBenchmark("Render distance grid walk", grid, iterations, tree_map, hash_map);
+	RunBenchmark("Random lookups in the loaded region", random_hits, iterations, tree_map, hash_map);
+	RunBenchmark("Lookups at the edge of the loaded region (hits and misses)", edge_lookups, iterations, tree_map, hash_map);
+
+	return 0;
+}
@@ -0,0 +1,307 @@
+/*
+Generates, lights and saves every chunk within a radius of the spawn chunk of a world, on every core and without a window or an OpenGL context.
+The output is the same save the game writes : WorldFileHandler::LoadWorld() opens it and the world reads the chunks from the region files
+instead of generating them. Chunks that are already saved (changed by a player or by an earlier run) are kept as they are,
+so running it again with a larger radius only adds the new ring.
+
+A chunk only needs itself to be generated (the trees of the neighbouring chunks that reach in to it are generated with it),
+so every chunk is one job that generates it, saves it and frees it. The jobs are queued one strip of columns at a time.
+
+Only the generator, the chunk and the file handling sources are built, none of them need OpenGL (ChunkMesh.h has no opengl, the meshes
+are built and uploaded by ChunkMesh.cpp and ChunkMeshArena.cpp which are game only).
+
+Build (from the repository root) :
+	cl /O2 /EHsc /std:c++17 /D_CRT_SECURE_NO_WARNINGS /ICore /ICore/Dependencies/glm
+		Tools/WorldPregen.cpp Core/World/WorldGenerator.cpp Core/World/Structures/WorldStructures.cpp
+		Core/Noise/FastNoise.cpp Core/Chunk.cpp Core/Block.cpp Core/PaletteBlockStorage.cpp Core/Lighting/SectionLightMap.cpp Core/Maths/Frustum.cpp
+		"Core/File Handling/ChunkFileHandler.cpp" "Core/File Handling/RegionFile.cpp" "Core/File Handling/WorldDataFile.cpp" Core/Utils/Logger.cpp
+		/link psapi.lib
+	g++ -O2 -std=c++17 -pthread (same include directories and sources) -o WorldPregen
+
+Usage : WorldPregen <world name> <seed> <generation type> <radius> [threads]
+	generation type : normal, islands, hilly, flat, flat_without_structures (or 0 - 4, see WorldGeneratorType.h)
+	radius : in chunks around the spawn chunk, radius 16 is 33 x 33 chunks
+	threads : every core by default
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+#include "../Core/World/WorldGenerator.h"
+#include "../Core/File Handling/ChunkFileHandler.h"
+#include "../Core/File Handling/WorldDataFile.h"
+#include "../Core/Utils/ThreadPool.h"
+
+using namespace Omnia;
+
+// The sun a new World starts with (see the World constructor)
+constexpr float new_world_sun_position = 1500.0f;
+constexpr std::uint8_t new_world_sun_cycle = 1; // Sun_Rising
+
+static const char* StageNames[] = { "Heightmap", "Column fill", "Water", "Caves", "Flora", "Lighting" };
+static_assert(sizeof(StageNames) / sizeof(StageNames[0]) == static_cast<int>(GenerationStage::Count), "Every generation stage needs a name");
+
+struct PregenOptions
+{
+	std::string p_WorldName;
+	int p_Seed = 0;
+	WorldGenerationType p_GenerationType = WorldGenerationType::Generation_Normal;
+	int p_Radius = 0;
+	unsigned int p_ThreadCount = 1;
+};
+
+struct PregenStats
+{
+	GenerationTimings p_Timings; // Summed over the threads
+	double p_SaveSeconds = 0.0; // Summed over the threads
+	size_t p_GeneratedChunks = 0;
+	size_t p_SavedChunks = 0;
+	size_t p_KeptChunks = 0;
+	size_t p_FailedChunks = 0;
+};
+
+static size_t GetPeakMemoryUsage()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.PeakWorkingSetSize;
+	}
+
+	return 0;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	#ifdef __APPLE__
+		return static_cast<size_t>(usage.ru_maxrss); // Bytes on macOS, kilobytes everywhere else
+	#else
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;
+	#endif
+#endif
+}
+
+static bool ParseGenerationType(const std::string& name, WorldGenerationType& type)
+{
+	static const char* TypeNames[] = { "normal", "islands", "hilly", "flat", "flat_without_structures" };
+
+	for (int i = 0; i < 5; i++)
+	{
+		if (name == TypeNames[i] || name == std::to_string(i))
+		{
+			type = static_cast<WorldGenerationType>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool ParseOptions(int argc, char** argv, PregenOptions& options)
+{
+	if (argc < 5 || !ParseGenerationType(argv[3], options.p_GenerationType))
+	{
+		return false;
+	}
+
+	try
+	{
+		options.p_WorldName = argv[1];
+		options.p_Seed = std::stoi(argv[2]);
+		options.p_Radius = std::stoi(argv[4]);
+		options.p_ThreadCount = argc > 5 ? static_cast<unsigned int>(std::stoi(argv[5])) : std::thread::hardware_concurrency();
+	}
+
+	catch (const std::exception&)
+	{
+		return false;
+	}
+
+	options.p_ThreadCount = std::max(options.p_ThreadCount, 1u);
+
+	return !options.p_WorldName.empty() && options.p_Radius >= 0;
+}
+
+// Creates the directories and world.bin so that LoadWorld() can open the world. An existing world.bin is kept
+static bool PrepareWorld(const PregenOptions& options)
+{
+	if (!WorldFileHandler::IsSaveCompatible(options.p_WorldName, options.p_Seed))
+	{
+		std::cout << "ERROR : Another world with a different seed is saved as \"" << options.p_WorldName << "\"\n";
+		return false;
+	}
+
+	std::filesystem::create_directories(WorldFileHandler::GetChunkDirectory(options.p_WorldName));
+
+	WorldFileHandler::WorldData world_data;
+
+	if (WorldFileHandler::ReadWorldData(options.p_WorldName, world_data))
+	{
+		if (world_data.world_gen_type != static_cast<int>(options.p_GenerationType))
+		{
+			std::cout << "ERROR : \"" << options.p_WorldName << "\" is saved with another generation type\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	world_data = { options.p_Seed, static_cast<int>(options.p_GenerationType), new_world_sun_position, new_world_sun_cycle };
+
+	if (!WorldFileHandler::WriteWorldData(options.p_WorldName, world_data))
+	{
+		std::cout << "ERROR : Unable to write the world data of \"" << options.p_WorldName << "\"\n";
+		return false;
+	}
+
+	return true;
+}
+
+static void Pregenerate(const PregenOptions& options, PregenStats& stats)
+{
+	const std::string chunk_directory = WorldFileHandler::GetChunkDirectory(options.p_WorldName);
+
+	// The full payload, the world would have to generate the chunk again to read a delta
+	ChunkFileHandler::ChunkSaveOptions save_options;
+	save_options.p_Mode = ChunkFileHandler::ChunkSaveMode::Full;
+	save_options.p_Seed = options.p_Seed;
+	save_options.p_GenerationType = options.p_GenerationType;
+
+	ThreadPool thread_pool(options.p_ThreadCount);
+	std::mutex stats_mutex;
+
+	const int side = 2 * options.p_Radius + 1;
+
+	// Enough chunks per strip to keep every thread busy
+	const int strip_width = std::max(1, static_cast<int>((options.p_ThreadCount * 4 + side - 1) / side));
+
+	for (int strip_x = -options.p_Radius; strip_x <= options.p_Radius; strip_x += strip_width)
+	{
+		const int strip_end = std::min(strip_x + strip_width, options.p_Radius + 1);
+
+		for (int cx = strip_x; cx < strip_end; cx++)
+		{
+			for (int cz = -options.p_Radius; cz <= options.p_Radius; cz++)
+			{
+				if (ChunkFileHandler::ChunkExists(cx, cz, chunk_directory))
+				{
+					stats.p_KeptChunks++;
+					continue;
+				}
+
+				thread_pool.Enqueue([&, cx, cz]()
+				{
+					std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(glm::vec3(cx, 0, cz));
+					GenerationTimings timings;
+
+					GenerateChunk(chunk.get(), options.p_Seed, options.p_GenerationType, &timings);
+					chunk->p_ChunkState = ChunkState::Generated;
+
+					const auto save_start = std::chrono::steady_clock::now();
+					const bool saved = ChunkFileHandler::WriteChunk(chunk.get(), chunk_directory, save_options);
+					const double save_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - save_start).count();
+
+					std::lock_guard<std::mutex> lock(stats_mutex);
+
+					for (int stage = 0; stage < static_cast<int>(GenerationStage::Count); stage++)
+					{
+						stats.p_Timings.p_StageSeconds[stage] += timings.p_StageSeconds[stage];
+					}
+
+					stats.p_SaveSeconds += save_seconds;
+					stats.p_GeneratedChunks++;
+					(saved ? stats.p_SavedChunks : stats.p_FailedChunks)++;
+				});
+			}
+		}
+
+		thread_pool.WaitIdle();
+
+		std::cout << "\r" << stats.p_SavedChunks + stats.p_KeptChunks << " / " << static_cast<size_t>(side) * side << " chunks" << std::flush;
+	}
+
+	std::cout << "\n";
+	ChunkFileHandler::CloseRegionFiles();
+}
+
+static void PrintStats(const PregenOptions& options, const PregenStats& stats, double seconds)
+{
+	const double generated = static_cast<double>(std::max<size_t>(stats.p_GeneratedChunks, 1));
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "\nSaved " << stats.p_SavedChunks << " chunks, kept " << stats.p_KeptChunks << " that were already saved";
+
+	if (stats.p_FailedChunks > 0)
+	{
+		std::cout << ", " << stats.p_FailedChunks << " COULDN'T BE WRITTEN";
+	}
+
+	std::cout << "\nGenerated " << stats.p_GeneratedChunks << " chunks in " << seconds << " s on "
+		<< options.p_ThreadCount << " threads\n";
+	std::cout << "    " << stats.p_GeneratedChunks / seconds << " chunks / s generated, " << stats.p_SavedChunks / seconds << " chunks / s saved\n\n";
+
+	std::cout << "Time per stage (summed over the threads) :\n";
+
+	for (int stage = 0; stage < static_cast<int>(GenerationStage::Count); stage++)
+	{
+		const double stage_seconds = stats.p_Timings.p_StageSeconds[stage];
+
+		std::cout << "    " << std::left << std::setw(18) << StageNames[stage] << std::right << std::setw(10) << stage_seconds * 1000.0 << " ms  "
+			<< std::setw(8) << stage_seconds * 1000000.0 / generated << " us / chunk\n";
+	}
+
+	std::cout << "    " << std::left << std::setw(18) << "Save" << std::right << std::setw(10) << stats.p_SaveSeconds * 1000.0 << " ms  "
+		<< std::setw(8) << stats.p_SaveSeconds * 1000000.0 / std::max<size_t>(stats.p_SavedChunks, 1) << " us / saved chunk\n\n";
+
+	std::cout << "Peak memory : " << GetPeakMemoryUsage() / (1024.0 * 1024.0) << " MB\n";
+}
+
+int main(int argc, char** argv)
+{
+	PregenOptions options;
+
+	if (!ParseOptions(argc, argv, options))
+	{
+		std::cout << "Usage : WorldPregen <world name> <seed> <generation type> <radius> [threads]\n";
+		std::cout << "    generation type : normal, islands, hilly, flat, flat_without_structures (or 0 - 4)\n";
+		return 1;
+	}
+
+	if (!PrepareWorld(options))
+	{
+		return 1;
+	}
+
+	PregenStats stats;
+	const auto start = std::chrono::steady_clock::now();
+
+	Pregenerate(options, stats);
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	PrintStats(options, stats, seconds);
+
+	return stats.p_FailedChunks > 0 ? 1 : 0;
+}
@@ -11,31 +11,14 @@ extern Omnia::Application Omnia::OmniaApplication;
 
 namespace Omnia
 {
-    ChunkDataTypePtr _GetChunkDataForMeshing (int cx, int cz)
+    const Chunk* _GetChunkForMeshing(int cx, int cz)
     {
-        if (OmniaApplication.GetWorld() && OmniaApplication.GetWorld()->ChunkExistsInMap(cx, cz))
-        {
-            Chunk* chunk = OmniaApplication.GetWorld()->RetrieveChunkFromMap(cx, cz);
-            return &chunk->p_ChunkContents;
-        }
-
-        return nullptr;
-    }
-
-    ChunkLightDataTypePtr _GetChunkLightDataForMeshing(int cx, int cz)
-    {
-        if (OmniaApplication.GetWorld() && OmniaApplication.GetWorld()->ChunkExistsInMap(cx, cz))
-        {
-            Chunk* chunk = OmniaApplication.GetWorld()->RetrieveChunkFromMap(cx, cz);
-            return &chunk->p_ChunkLightInformation;
-        }
-
-        return nullptr;
+        return OmniaApplication.GetWorld() ? OmniaApplication.GetWorld()->FindChunk(cx, cz) : nullptr;
     }
 
-    Block* GetWorldBlock(const glm::vec3& block_pos)
+    Block GetWorldBlock(const glm::vec3& block_pos)
     {
-        std::pair<Block*, Chunk*> block = OmniaApplication.GetWorld()->GetBlockFromPosition(block_pos);
+        std::pair<Block, Chunk*> block = OmniaApplication.GetWorld()->GetBlockFromPosition(block_pos);
         return block.first;
     }
 }